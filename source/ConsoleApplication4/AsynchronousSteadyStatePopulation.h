@@ -0,0 +1,326 @@
+
+  
+#ifndef ASYNCHRONOUSSTEADYSTATEPOPULATION_H
+#define ASYNCHRONOUSSTEADYSTATEPOPULATION_H
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "IPopulation.h"
+#include "IProgram.h"
+#include "Rand.h"
+#include "WeightedCollection.h"
+
+namespace VUWLGP {
+  // A steady-state population with no generational barrier. Evolve runs
+  // Config::NumberOfThreads() worker threads which each repeatedly breed a child from
+  // tournament-selected parents, evaluate it, and put it in place of the loser of a
+  // replacement tournament. Breeding and replacement happen under a lock on the population, but
+  // evaluation (the expensive part) does not, so a slow program only holds up the thread
+  // evaluating it rather than the whole population.
+  //
+  // Logging is by "equivalent generations": generation g is logged once g * populationSize
+  // children have been evaluated, so logs and results are comparable with those of a
+  // generational population. The order in which children are evaluated, and so the results of
+  // a run, depend on thread scheduling unless a single thread is used - so although checkpoints
+  // are saved and can be resumed from, a resumed run isn't an exact continuation. Only a
+  // snapshot of each generation is taken under the lock: its logs are written by a LogWriter
+  // (whatever Config::asyncLogging is), and its metrics record once the lock is released.
+  template <class IProgramSubclass, class T>
+  class AsynchronousSteadyStatePopulation: public IPopulation<IProgramSubclass, T> {
+  public:
+    // Uses the default cctor, dtor
+    AsynchronousSteadyStatePopulation(Config<T>* conf): IPopulation<IProgramSubclass,T>(conf) { }
+
+    // Evolves the population for up to maxGenerations equivalent generations. Returns the
+    // equivalent generation a solution was found in, else maxGenerations + 1. If a worker
+    // thread fails (e.g. to write a checkpoint or log), the others are stopped and the first
+    // error is thrown as a std::string once they have finished.
+    unsigned int Evolve(FitnessEnvironment<T>& fe);
+
+    // Carries out an equivalent generation serially: breeds populationSize children, then puts
+    // each in place of the loser of a replacement tournament between the programs which were
+    // in the population before it. The children are left flagged for EvaluateFlaggedPrograms.
+    void IteratePopulation();
+
+    // Carries out a size AsynchronousSteadyStatePopulation::tournamentSize tournament:
+    const IProgramSubclass* SelectProgByFitness() const;
+    static unsigned int tournamentSize;
+
+  protected:
+    // Breeds a child using one of the evolutionary operators, culled to the maximum length.
+    IProgramSubclass* BreedChild() const;
+
+    // Replaces the least fit of a size tournamentSize tournament with child, which the
+    // population takes ownership of.
+    void ReplaceTournamentLoser(IProgramSubclass* child);
+
+    // The loop each of Evolve's worker threads runs, evaluating against its own
+    // FitnessEnvironment which shares fe's cases. Each thread seeds its own random number
+    // generator with seed, drawn from the generator of the thread which called Evolve.
+    void Work(const FitnessEnvironment<T>* fe, unsigned int seed);
+
+    // Runs Work, and if it throws keeps the first error for Evolve and stops the run. Worker
+    // threads start here, as nothing must escape a thread.
+    void ContainedWork(const FitnessEnvironment<T>* fe, unsigned int seed);
+
+    // Picks up to tournamentSize distinct programs and returns the index of the fittest (if
+    // fittest is true) or the least fit of them. The contestants are drawn from the indexes in
+    // candidates, or from the whole population if candidates is null.
+    unsigned int Tournament(bool fittest, const std::vector<unsigned int>* candidates = 0) const;
+
+    // Hands a snapshot of equivalent generation gen to the LogWriter, as Log does (last is
+    // set for the run's last log, which is never dropped), and returns its metrics record
+    // (setting metricsHeader), for AppendMetrics to write once populationLock has been
+    // released.
+    std::string LogSnapshot(unsigned int gen, bool last, std::string& metricsHeader);
+
+    // Held while a metrics record is appended, so the records are written in order:
+    std::mutex metricsLock;
+
+    // Shared state of a call to Evolve, only accessed while holding populationLock:
+    std::mutex populationLock;
+    unsigned int evaluations; // children evaluated so far
+    unsigned int solvedInGeneration; // 0 until a solution is found
+    bool stop;
+    std::string error; // the first error a worker thread caught, or empty
+  };
+}
+
+template <class IProgramSubclass, class T> unsigned int
+VUWLGP::AsynchronousSteadyStatePopulation<IProgramSubclass, T>::tournamentSize = 4;
+
+
+
+////////////////////////////////// Inline Function Definitions /////////////////////////////////
+template <class IProgramSubclass, class T> unsigned int
+VUWLGP::AsynchronousSteadyStatePopulation<IProgramSubclass, T>::Evolve
+(VUWLGP::FitnessEnvironment<T>& fe) {
+  this->evaluationEnvironment = &fe;
+
+  if(this->startGeneration == 0) {
+    this->EvaluateFlaggedPrograms(fe);
+    this->Log("initial");
+
+    if(this->SolutionExists()) { return 0; }
+  }
+
+  evaluations = this->startGeneration * this->Size();
+  solvedInGeneration = 0;
+  stop = this->startGeneration >= this->config->maxGenerations;
+  error.clear();
+
+  std::vector<std::thread> workers;
+  for(unsigned int i = 0; i < this->config->NumberOfThreads(); ++i) {
+    workers.push_back(std::thread(&AsynchronousSteadyStatePopulation::ContainedWork, this,
+				  &fe, Rand::Int()));
+  }
+
+  for(unsigned int i = 0; i < workers.size(); ++i) {
+    workers[i].join();
+  }
+  if(!error.empty()) {
+    throw error;
+  }
+
+  return solvedInGeneration != 0 ? solvedInGeneration : this->config->maxGenerations + 1;
+}
+
+
+
+template <class IProgramSubclass, class T> void
+VUWLGP::AsynchronousSteadyStatePopulation<IProgramSubclass, T>::IteratePopulation() {
+  std::vector<IProgramSubclass*> children;
+  children.reserve(this->Size());
+  while(children.size() < this->Size()) {
+    children.push_back(BreedChild());
+  }
+
+  // Children's fitnesses aren't known yet, so only their elders compete to be replaced:
+  std::vector<unsigned int> elders;
+  for(unsigned int i = 0; i < this->Size(); ++i) {
+    elders.push_back(i);
+  }
+
+  for(unsigned int i = 0; i < children.size(); ++i) {
+    unsigned int loser = Tournament(false, &elders);
+    delete this->programs[loser];
+    this->programs[loser] = children[i];
+    elders.erase(std::find(elders.begin(), elders.end(), loser));
+  }
+}
+
+
+
+template <class IProgramSubclass, class T> const IProgramSubclass*
+VUWLGP::AsynchronousSteadyStatePopulation<IProgramSubclass, T>::SelectProgByFitness() const {
+  return dynamic_cast<IProgramSubclass*>(this->programs[Tournament(true)]);
+}
+
+
+
+template <class IProgramSubclass, class T> IProgramSubclass*
+VUWLGP::AsynchronousSteadyStatePopulation<IProgramSubclass, T>::BreedChild() const {
+  // The same operators and weightings as GenerationalTournamentPopulation:
+  VUWLGP::WeightedCollection<IProgramSubclass*
+    (IPopulation<IProgramSubclass, T>::*)() const> o;
+  o.AddElement(&IPopulation<IProgramSubclass, T>::MacroMutation, 30);
+  o.AddElement(&IPopulation<IProgramSubclass, T>::MicroMutation, 30);
+  o.AddElement(&IPopulation<IProgramSubclass, T>::CrossoverFree, 30);
+
+  IProgramSubclass* child = (this->*o.GetRandomElement())();
+  child->RandomlyCullToSize(this->config->maxLength);
+  return child;
+}
+
+
+
+template <class IProgramSubclass, class T> void
+VUWLGP::AsynchronousSteadyStatePopulation<IProgramSubclass, T>::ReplaceTournamentLoser
+(IProgramSubclass* child) {
+  unsigned int loser = Tournament(false);
+  delete this->programs[loser];
+  this->programs[loser] = child;
+}
+
+
+
+template <class IProgramSubclass, class T> void
+VUWLGP::AsynchronousSteadyStatePopulation<IProgramSubclass, T>::Work
+(const VUWLGP::FitnessEnvironment<T>* fe, unsigned int seed) {
+  Rand::Init(seed);
+  FitnessEnvironment<T> localFe(*fe);
+
+  std::unique_lock<std::mutex> lock(populationLock);
+  while(!stop) {
+    IProgramSubclass* child = BreedChild();
+
+    lock.unlock();
+    child->UpdateFitness(localFe);
+    lock.lock();
+
+    if(stop) { // another thread finished the run while this child was being evaluated
+      delete child;
+      break;
+    }
+
+    bool solved = child->Fitness() <= this->config->epsilon;
+    ReplaceTournamentLoser(child);
+    ++evaluations;
+
+    // Log each equivalent generation as it completes, plus the partial one a solution is
+    // found in:
+    unsigned int generation = (evaluations + this->Size() - 1) / this->Size();
+    bool last = solved || evaluations == this->config->maxGenerations * this->Size();
+    std::string metrics;
+    std::string metricsHeader;
+    if(evaluations % this->Size() == 0 || solved) {
+      metrics = LogSnapshot(generation, last, metricsHeader);
+    }
+
+    if(solved) {
+      solvedInGeneration = generation;
+      stop = true;
+    }
+    else if(evaluations == this->config->maxGenerations * this->Size()) {
+      stop = true;
+    }
+    else if(evaluations % this->Size() == 0 && this->config->checkpointInterval != 0 &&
+	    generation % this->config->checkpointInterval == 0) {
+      this->SaveCheckpoint(this->config->checkpointFilePath + ".bin", generation);
+    }
+
+    if(!metrics.empty()) {
+      // metricsLock is taken first, so a later generation's record can't be written first:
+      std::unique_lock<std::mutex> metricsGuard(metricsLock);
+      lock.unlock();
+      this->AppendMetrics(metrics, metricsHeader);
+      metricsGuard.unlock();
+      lock.lock();
+    }
+  }
+}
+
+
+
+template <class IProgramSubclass, class T> void
+VUWLGP::AsynchronousSteadyStatePopulation<IProgramSubclass, T>::ContainedWork
+(const VUWLGP::FitnessEnvironment<T>* fe, unsigned int seed) {
+  std::string failure;
+  try {
+    Work(fe, seed);
+  }
+  catch(const std::string& e) {
+    failure = e;
+  }
+  catch(const std::exception& e) {
+    failure = std::string("AsynchronousSteadyStatePopulation - ") + e.what();
+  }
+
+  if(!failure.empty()) {
+    std::unique_lock<std::mutex> lock(populationLock);
+    if(error.empty()) {
+      error = failure;
+    }
+    stop = true;
+  }
+}
+
+
+
+template <class IProgramSubclass, class T> std::string
+VUWLGP::AsynchronousSteadyStatePopulation<IProgramSubclass, T>::LogSnapshot
+(unsigned int gen, bool last, std::string& metricsHeader) {
+  std::ostringstream conv;
+  conv << gen;
+  std::string genString = conv.str();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  this->LogAsynchronously(genString, gen % this->config->popLogInterval == 0 ?
+			  this->config->popLogFilePath + "." + genString + ".txt" : "", last);
+
+  double logSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+    .count();
+  return this->MetricsRecord(gen, logSeconds, metricsHeader);
+}
+
+
+
+template <class IProgramSubclass, class T> unsigned int
+VUWLGP::AsynchronousSteadyStatePopulation<IProgramSubclass, T>::Tournament
+(bool fittest, const std::vector<unsigned int>* candidates) const {
+  unsigned int numCandidates = candidates != 0 ? candidates->size() : this->Size();
+  unsigned int contestants = tournamentSize < numCandidates ? tournamentSize : numCandidates;
+
+  std::vector<unsigned int> chosen;
+  chosen.reserve(contestants);
+  unsigned int winner = 0;
+
+  while(chosen.size() < contestants) {
+    unsigned int candidate = Rand::Int(numCandidates);
+    if(candidates != 0) {
+      candidate = (*candidates)[candidate];
+    }
+
+    if(std::find(chosen.begin(), chosen.end(), candidate) != chosen.end()) {
+      continue; // Select another, different program
+    }
+
+    double candidateFitness = this->programs[candidate]->Fitness();
+    double winnerFitness = this->programs[winner]->Fitness();
+    if(chosen.empty() ||
+       (fittest ? candidateFitness < winnerFitness : candidateFitness > winnerFitness)) {
+      winner = candidate;
+    }
+    chosen.push_back(candidate);
+  }
+
+  return winner;
+}
+#endif
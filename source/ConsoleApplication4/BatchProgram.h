@@ -0,0 +1,195 @@
+
+  
+#ifndef BATCHPROGRAM_H
+#define BATCHPROGRAM_H
+
+#include <algorithm>
+#include <vector>
+
+#include "Config.h"
+#include "FitnessEnvironment.h"
+#include "ICompiledProgram.h"
+#include "IInstructionOperation.h"
+#include "IProgram.h"
+#include "Instruction.h"
+#include "InstructionArgumentConstant.h"
+#include "RegisterCollection.h"
+
+namespace VUWLGP {
+  // A program compiled to run on a block of up to BlockLength cases at a time through its
+  // operations' batch forms (see IInstructionOperation::ExecuteBatch): each register and
+  // feature is a column of the block's values, and each instruction is one call which runs
+  // on the whole block, so the virtual calls are made once per block rather than once per
+  // case and the operations' loops vectorise. Any operation with a batch form, including
+  // user-defined ones, runs this way without changes here. Conditionals clear a mask of the
+  // cases the next assignment is skipped for, as the interpreter skips it, and every case is
+  // computed as the interpreter computes it, so the fitnesses are exactly the same.
+  template <class T> class BatchProgram: public ICompiledProgram<T> {
+  public:
+    static const unsigned int BlockLength = 256;
+
+    // Compiles prog's effective (non-intron) code, whose operations must all have batch forms
+    // (see Compile). prog's introns must be marked, and as its operations are used in place,
+    // prog must outlive the BatchProgram and not change while it is used.
+    BatchProgram(const IProgram<T>& prog, const Config<T>* conf);
+    // Default cctor, dtor
+
+    void AccumulateError(IProgram<T>& prog, FitnessEnvironment<T>& fe) const;
+
+    // Returns a new BatchProgram of prog, or 0 if an operation of its effective code has no
+    // batch form (see IInstructionOperation::ExecutesBatches). The caller is responsible for
+    // deleting it.
+    static ICompiledProgram<T>* Compile(const IProgram<T>& prog, const Config<T>* conf);
+
+  private:
+    typedef typename IInstructionOperation<T>::Column Column;
+
+    // An effective instruction. Its operands are slots: the registers come first, then the
+    // features, then the program's constants.
+    struct Step {
+      const IInstructionOperation<T>* operation;
+      bool conditional;
+      unsigned int destination;
+      unsigned int first;
+      unsigned int second;
+    };
+
+    // Returns the column of slot in columns, the registers' and features' columns.
+    Column ColumnOf(unsigned int slot, const std::vector<T>& columns) const;
+
+    unsigned int numRegisters;
+    unsigned int numFeatures;
+    std::vector<Step> steps;
+    std::vector<T> constants;
+  };
+}
+
+
+
+////////////////////////////////// Inline Function Definitions /////////////////////////////////
+// Defined as well as initialised, as std::min takes it by reference:
+template <class T> const unsigned int VUWLGP::BatchProgram<T>::BlockLength;
+
+
+
+template <class T>
+VUWLGP::BatchProgram<T>::BatchProgram(const VUWLGP::IProgram<T>& prog,
+				      const VUWLGP::Config<T>* conf):
+numRegisters(conf->numRegisters),
+numFeatures(conf->numFeatures) {
+  const std::vector<Instruction<T>*>& instrs = prog.ConstRawAccessToTheInternalInstructions();
+  for(unsigned int i = 0; i < instrs.size(); ++i) {
+    if(instrs[i]->IsIntron) {
+      continue;
+    }
+
+    Step step;
+    step.operation = instrs[i]->Operation();
+    step.conditional = instrs[i]->IsConditional();
+    step.destination = instrs[i]->DestinationIndex();
+    const IInstructionArgument<T>* operands[] = { instrs[i]->FirstArgument(),
+						  instrs[i]->SecondArgument() };
+    unsigned int* slots[] = { &step.first, &step.second };
+    for(unsigned int j = 0; j < 2; ++j) {
+      switch(operands[j]->ArgumentType()) {
+      case ArgumentTypeRegister:
+	*slots[j] = operands[j]->ArgumentIndex();
+	break;
+      case ArgumentTypeFeature:
+	*slots[j] = numRegisters + operands[j]->ArgumentIndex();
+	break;
+      default:
+	*slots[j] = numRegisters + numFeatures + constants.size();
+	constants.push_back(static_cast<const InstructionArgumentConstant<T>*>(operands[j])
+			    ->Constant());
+      }
+    }
+    steps.push_back(step);
+  }
+}
+
+
+
+template <class T>
+void VUWLGP::BatchProgram<T>::AccumulateError(VUWLGP::IProgram<T>& prog,
+					      VUWLGP::FitnessEnvironment<T>& fe) const {
+  std::vector<T> columns((numRegisters + numFeatures) * BlockLength);
+  std::vector<unsigned char> mask(BlockLength);
+  RegisterCollection<T> finalRegisterValues(numRegisters);
+
+  // Each block is walked twice, to load its features and then to score its cases, so it is
+  // made the window for the time being:
+  unsigned int begin = fe.WindowBegin();
+  unsigned int end = fe.WindowEnd();
+  for(unsigned int block = begin; block < end; block += BlockLength) {
+    unsigned int length = std::min(BlockLength, end - block);
+    fe.SetWindow(block, block + length);
+
+    std::fill(columns.begin(), columns.begin() + numRegisters * BlockLength, T(0));
+    for(unsigned int f = 0; f < numFeatures; ++f) {
+      fe.ReadFeatures(f, &columns[(numRegisters + f) * BlockLength]);
+    }
+
+    // The mask is set afresh by the first of a run of conditionals, each of which clears it
+    // for the cases it doesn't hold for, and is used up by the assignment they guard:
+    bool guarded = false;
+    for(typename std::vector<Step>::const_iterator step = steps.begin(); step != steps.end();
+	++step) {
+      Column first = ColumnOf(step->first, columns);
+      Column second = ColumnOf(step->second, columns);
+      if(step->conditional) {
+	if(!guarded) {
+	  std::fill(mask.begin(), mask.begin() + length, 1);
+	  guarded = true;
+	}
+	step->operation->ExecuteBatch(0, first, second, length, &mask[0]);
+      }
+      else {
+	step->operation->ExecuteBatch(&columns[step->destination * BlockLength], first, second,
+				      length, guarded ? &mask[0] : 0);
+	guarded = false;
+      }
+    }
+
+    unsigned int i = 0;
+    for(bool more = fe.LoadFirstCase(); more; more = fe.LoadNextCase(), ++i) {
+      for(unsigned int r = 0; r < numRegisters; ++r) {
+	finalRegisterValues.Write(r, columns[r * BlockLength + i]);
+      }
+      prog.UpdateError(finalRegisterValues, fe.CurrentCase());
+    }
+  }
+  fe.SetWindow(begin, end);
+}
+
+
+
+template <class T>
+VUWLGP::ICompiledProgram<T>* VUWLGP::BatchProgram<T>::Compile(const VUWLGP::IProgram<T>& prog,
+							      const VUWLGP::Config<T>* conf) {
+  const std::vector<Instruction<T>*>& instrs = prog.ConstRawAccessToTheInternalInstructions();
+  for(unsigned int i = 0; i < instrs.size(); ++i) {
+    if(!instrs[i]->IsIntron && !instrs[i]->Operation()->ExecutesBatches()) {
+      return 0;
+    }
+  }
+  return new BatchProgram<T>(prog, conf);
+}
+
+
+
+template <class T>
+typename VUWLGP::BatchProgram<T>::Column
+VUWLGP::BatchProgram<T>::ColumnOf(unsigned int slot, const std::vector<T>& columns) const {
+  Column column;
+  if(slot < numRegisters + numFeatures) {
+    column.values = &columns[slot * BlockLength];
+    column.stride = 1;
+  }
+  else {
+    column.values = &constants[slot - numRegisters - numFeatures];
+    column.stride = 0;
+  }
+  return column;
+}
+#endif
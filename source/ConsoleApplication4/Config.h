@@ -4,11 +4,15 @@
 #define CONFIG_H
 
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
 
 #include "WeightedCollection.h"
 
 namespace VUWLGP {
   template <class T> class Config; // needed for the typedefs/use of Config* in Config's defn
+  template <class T> class ICompiledProgram;
   template <class T> class IInstructionArgument;
   template <class T> class IInstructionOperation;
   template <class T> class IInstructionOperationConditional;
@@ -28,17 +32,32 @@ namespace VUWLGP {
     // e.g., an an Instruction
     typedef IInstructionArgument<T>* (*ArgumentGeneratorFunc)(Config<T>*);
 
+    // A program compiler function compiles a program whose introns are marked, or returns
+    // 0 if it can't, e.g. if the program has operations it doesn't know.
+    typedef ICompiledProgram<T>* (*ProgramCompilerFunc)(const IProgram<T>&, const Config<T>*);
+
   public:
-    // Should not really be copy-constructed, so the cctor is private.
     // All data members are public as they're just properties.
     Config();
     Config(int argc, char** argv, bool printAsParses); // parses the command line
     virtual ~Config();
 
+    // Copies are independent of the original (they have their own operation and argument
+    // generator collections), e.g. so that concurrent runs can each change their seeds and log
+    // paths. Configs should not be assigned, so operator= is private.
+    Config(const Config& rhs);
+
     // Initialises the config object based on what are assumed to be the command line 
     // arguments passed to it:
     void Init(int argc, char** argv, bool printAsParses);
 
+    // Returns numThreads, or the number of hardware threads if numThreads is 0.
+    unsigned int NumberOfThreads() const;
+
+    // Returns evaluationEngine, with "auto" resolved to the engine it means for a dataset of
+    // numCases cases.
+    std::string EvaluationEngineFor(unsigned int numCases) const;
+
     // Program/Instruction configuration parameters:
     unsigned int numRegisters;
     unsigned int numFeatures;
@@ -47,6 +66,7 @@ namespace VUWLGP {
     // Stores pointers to the generators of instruction operations (e.g. +, -, etc.)
     WeightedCollection<ArgumentGeneratorFunc>* argumentGenerators; // can't spec on CL
     WeightedCollection<OperationGeneratorFunc>* instructionOperations; // can't spec on CL
+    ProgramCompilerFunc programCompiler; // the "compiled" engine's, e.g. OpSet::Register's
 
     // Population configuration parameters
     unsigned int initialMinLength;
@@ -62,7 +82,11 @@ namespace VUWLGP {
 
     // Logging parameters - statistics log file, how often should the full pop be logged, etc.
     // .txt and generation information will be postpended to the paths given for the pop and
-    // stats logs, but not to the run log file path, which should be a .csv file.
+    // stats logs, but not to the run log file path, which should be a .csv file. Each run
+    // appends a line "generations,time,training fitness,test fitness" to it, the time in clock
+    // ticks (CLOCKS_PER_SEC per second): the CPU time of a single run or island, but the
+    // wall-clock time of each of several concurrent runs (see MultiRunDriver), as their CPU
+    // times can't be told apart.
     unsigned int popLogInterval;
     std::string popLogFilePath;
     std::string statsLogFilePath;
@@ -72,8 +96,166 @@ namespace VUWLGP {
     unsigned int randSeed;
     bool seedSpecified;
 
+    // Parallelism - the number of threads used to evolve (and/or evaluate) a population. 0
+    // means one per hardware thread. See Config::NumberOfThreads.
+    unsigned int numThreads;
+
+    // The kind of population main evolves: "generational" (GenerationalTournamentPopulation),
+    // "pipelined" (PipelinedGenerationalPopulation) or "asynchronous"
+    // (AsynchronousSteadyStatePopulation).
+    std::string populationModel;
+
+    // Island model parameters - the number of islands (each is run as a separate process with
+    // its own population and copy of the fitness cases), how often (in generations) and how
+    // many of each island's fittest programs migrate to the next island, and whether each
+    // island process should be bound to the processors of one NUMA node.
+    unsigned int numIslands;
+    unsigned int migrationInterval;
+    unsigned int migrationSize;
+    bool bindIslandsToNumaNodes;
+
+    // Multi-run parameters - the number of independent runs main carries out (run r is seeded
+    // with randSeed + r and logs to its own files), how many of them run at once (0 means one
+    // per hardware thread), and the .csv file a labelled line for each run and the runs'
+    // mean, standard deviation and median are appended to. Only used without islands. See
+    // MultiRunDriver.
+    unsigned int numRuns;
+    unsigned int numConcurrentRuns;
+    std::string runSummaryFilePath;
+
+    // Checkpoint parameters - how often (in generations, 0 for never) the population and the
+    // state needed to carry on the run are written to checkpointFilePath + ".bin", and the path
+    // of a checkpoint to resume a single population run from (empty to start a new run).
+    unsigned int checkpointInterval;
+    std::string checkpointFilePath;
+    std::string resumeFrom;
+
+    // Asynchronous logging parameters - whether IPopulation::Log hands the population to a
+    // LogWriter thread rather than writing the logs itself, how many logs can wait to be
+    // written, and whether logs are dropped (the default) when that many are, rather than
+    // evolution waiting for the disk. Dropped logs are noted in the statistics log. The last
+    // log of a run (the final generation or the one a solution is found in) is never dropped.
+    bool asyncLogging;
+    unsigned int logQueueLength;
+    bool dropLogsWhenBehind;
+
+    // How population dumps are written - "text" (a population.<generation>.txt file each time,
+    // as before), "history" (appended to one popLogFilePath + ".history.bin" file, storing only
+    // the programs which changed since the previous dump; lgphistory rebuilds the text) or
+    // "both" - and how many dumps there are between the full copies in the history.
+    std::string popLogFormat;
+    unsigned int historyKeyframeInterval;
+
+    // Per-generation metrics - "none", or "csv" or "jsonl" to append one record per logged
+    // generation to metricsFilePath + ".csv"/".jsonl", and whether each record includes the
+    // best program's text (which is much more expensive than the rest of the record).
+    std::string metricsFormat;
+    std::string metricsFilePath;
+    bool metricsBestProgram;
+
+    // Files of fitness cases to train and test on (in the Regression format Dataset reads, or
+    // binary datasets), instead of the built in problem. If there is no test file the test
+    // cases come from the training file too. The cases of a binary dataset's "train" or
+    // "test" split are used if it has one, otherwise the whole file is.
+    std::string trainingCasesFilePath;
+    std::string testCasesFilePath;
+
+    // Out-of-core evaluation - if non-zero, populations evaluate all of their programs against
+    // this many cases at a time, rather than each program against all of the cases in turn, so
+    // each block of cases is read once per generation and can be dropped from memory before the
+    // next is read. Fitnesses are exactly the same either way. 0 evaluates program by program.
+    // Only reading a binary Dataset is out-of-core; the other cases are all in memory anyway,
+    // but still benefit from being read from the cache. The asynchronous model evaluates each
+    // child as it is bred, so it is only used for the initial population there.
+    unsigned int evaluationChunkSize;
+
+    // Cache blocking - if evaluationTileSize is non-zero, each block of cases (see
+    // evaluationChunkSize, or all of the cases if it is 0) is evaluated a tile of this many
+    // cases at a time: a batch of evaluationProgramBatch programs is run over one tile, while
+    // it is in the cache, before the batch moves on to the next tile. The tile should fit in
+    // the L1 or L2 cache alongside the batch's programs. Fitnesses are exactly the same.
+    unsigned int evaluationTileSize;
+    unsigned int evaluationProgramBatch;
+
+    // How populations evaluate whole generations: "interpreter" runs each program's
+    // instructions in turn, "lockstep" runs groups of programs together a step at a time with
+    // a LockstepEvaluator (falling back to the interpreter for programs it can't run), "plan"
+    // runs each program's ExecutionPlan, with superinstructions (see fusionThreshold),
+    // "compiled" runs each program as programCompiler compiles it and "batch" runs it a block
+    // of cases at a time with a BatchProgram (both falling back to the interpreter for
+    // programs they can't compile), and "auto" uses lockstep, with BatchPrograms for the
+    // programs it can't run, for datasets of at most lockstepMaxCases cases (256 by default, 0
+    // means any number) and batch for larger ones. Fitnesses are exactly the same either way.
+    // Children the pipelined or asynchronous models evaluate one at a time as they are bred
+    // use the interpreter.
+    std::string evaluationEngine;
+    unsigned int lockstepMaxCases;
+
+    // The type main evaluates programs in: "double", or "float", which halves the memory the
+    // cases and registers take up so twice as many fit in a cache line or a vector register.
+    // Errors are always summed in double. With rescoreInDouble, the best program of a float
+    // run is also evaluated in double on the same cases, to show how much precision was lost.
+    std::string precision;
+    bool rescoreInDouble;
+
+    // How main stores the features of the fitness cases: "full" (as T), or "float16" or
+    // "bfloat16" (see FitnessEnvironment::PackFeatures), which cut the memory read per case.
+    // The batch engine decodes float16s with F16C at the avx2 and avx512 evaluationKernels.
+    std::string featureStorage;
+
+    // The passes ExecutionPlan::Optimise runs on the plans the plan based evaluators (e.g.
+    // LockstepEvaluator) compile programs into: foldConstants folds the values known before
+    // any case is seen into constants (see ExecutionPlan::FoldConstants),
+    // eliminateRedundancy computes each value once (see ExecutionPlan::EliminateRedundancy)
+    // and renameRegisters packs the values into as few registers as it can (see
+    // ExecutionPlan::RenameRegisters). The passes don't change fitnesses, unless
+    // assumeFiniteValues lets them simplify e.g. x - x to 0, which is NaN if x is infinite or
+    // NaN.
+    bool foldConstants;
+    bool eliminateRedundancy;
+    bool renameRegisters;
+    bool assumeFiniteValues;
+
+    // If it isn't negative, main also prints the best program without its approximate
+    // semantic introns, the steps whose removal changes none of its outputs on the training
+    // cases by more than semanticIntronTolerance (see ExecutionPlan::RemoveSemanticIntrons),
+    // and the fitnesses it then has. 0 only removes steps which change nothing on them.
+    T semanticIntronTolerance;
+
+    // The "plan" evaluation engine fuses the pairs of steps which make up at least this share
+    // of the pairs in the plans it has compiled so far in the run into superinstructions
+    // (see OpcodeProfile::Choose), so 0 fuses every pair it can and 1 or more none.
+    double fusionThreshold;
+
+    // If transcendentalOperations is set, main also builds programs from exp, sin, cos and the
+    // protected sqrt and log (see InstructionOperationExp etc.), and if fastTranscendentals is
+    // set they use the faster approximations of Transcendental::fast, whose errors are bounded
+    // there.
+    bool transcendentalOperations;
+    bool fastTranscendentals;
+
+    // The instruction set level the batch evaluation kernels run at (see KernelDispatch):
+    // "auto" for the best the processor supports, or "sse2", "avx2" or "avx512" to force one,
+    // e.g. for benchmarking. The levels give exactly the same results.
+    std::string evaluationKernels;
+
+    // If autotune is set, populations which evaluate whole generations (all but
+    // AsynchronousSteadyStatePopulation) time each engine, tile size and number of threads
+    // (see EngineAutotuner) on their population before Evolve starts, for at most about
+    // autotuneSeconds in all, and evaluate with the fastest. The decision is kept in the
+    // tuning cache at tuningCacheFilePath (none if it is empty), and later runs on the same
+    // machine and problem shape use it without timing anything. It overrides
+    // evaluationEngine, evaluationTileSize and numThreads, and as every setting gives the same
+    // fitnesses, only the speed of the run changes.
+    bool autotune;
+    double autotuneSeconds;
+    std::string tuningCacheFilePath;
+
   private:
-    Config(const Config& rhs) { }
+    Config& operator=(const Config& rhs);
+
+    // Gives the parameters which main does not have to set their default values:
+    void SetDefaults();
   };
 }
 
@@ -84,6 +266,9 @@ template <class T>
 VUWLGP::Config<T>::Config() {
   instructionOperations = new WeightedCollection<OperationGeneratorFunc>();
   argumentGenerators = new WeightedCollection<ArgumentGeneratorFunc>();
+  programCompiler = 0;
+
+  SetDefaults();
 }
 
 
@@ -92,12 +277,149 @@ template <class T>
 VUWLGP::Config<T>::Config(int argc, char** argv, bool printAsParses) {
   instructionOperations = new WeightedCollection<OperationGeneratorFunc>();
   argumentGenerators = new WeightedCollection<ArgumentGeneratorFunc>();
+  programCompiler = 0;
 
+  SetDefaults();
   Init(argc, argv, printAsParses);
 }
 
 
 
+template <class T>
+VUWLGP::Config<T>::Config(const VUWLGP::Config<T>& rhs) {
+  instructionOperations = 
+    new WeightedCollection<OperationGeneratorFunc>(*rhs.instructionOperations);
+  argumentGenerators = new WeightedCollection<ArgumentGeneratorFunc>(*rhs.argumentGenerators);
+  programCompiler = rhs.programCompiler;
+
+  numRegisters = rhs.numRegisters;
+  numFeatures = rhs.numFeatures;
+  epsilon = rhs.epsilon;
+  initialMinLength = rhs.initialMinLength;
+  initialMaxLength = rhs.initialMaxLength;
+  maxLength = rhs.maxLength;
+  populationSize = rhs.populationSize;
+  maxGenerations = rhs.maxGenerations;
+  popLogInterval = rhs.popLogInterval;
+  popLogFilePath = rhs.popLogFilePath;
+  statsLogFilePath = rhs.statsLogFilePath;
+  runLogFilePath = rhs.runLogFilePath;
+  randSeed = rhs.randSeed;
+  seedSpecified = rhs.seedSpecified;
+  numThreads = rhs.numThreads;
+  populationModel = rhs.populationModel;
+  numIslands = rhs.numIslands;
+  migrationInterval = rhs.migrationInterval;
+  migrationSize = rhs.migrationSize;
+  bindIslandsToNumaNodes = rhs.bindIslandsToNumaNodes;
+  numRuns = rhs.numRuns;
+  numConcurrentRuns = rhs.numConcurrentRuns;
+  runSummaryFilePath = rhs.runSummaryFilePath;
+  checkpointInterval = rhs.checkpointInterval;
+  checkpointFilePath = rhs.checkpointFilePath;
+  resumeFrom = rhs.resumeFrom;
+  asyncLogging = rhs.asyncLogging;
+  logQueueLength = rhs.logQueueLength;
+  dropLogsWhenBehind = rhs.dropLogsWhenBehind;
+  popLogFormat = rhs.popLogFormat;
+  historyKeyframeInterval = rhs.historyKeyframeInterval;
+  metricsFormat = rhs.metricsFormat;
+  metricsFilePath = rhs.metricsFilePath;
+  metricsBestProgram = rhs.metricsBestProgram;
+  trainingCasesFilePath = rhs.trainingCasesFilePath;
+  testCasesFilePath = rhs.testCasesFilePath;
+  evaluationChunkSize = rhs.evaluationChunkSize;
+  evaluationTileSize = rhs.evaluationTileSize;
+  evaluationProgramBatch = rhs.evaluationProgramBatch;
+  evaluationEngine = rhs.evaluationEngine;
+  lockstepMaxCases = rhs.lockstepMaxCases;
+  precision = rhs.precision;
+  rescoreInDouble = rhs.rescoreInDouble;
+  featureStorage = rhs.featureStorage;
+  foldConstants = rhs.foldConstants;
+  eliminateRedundancy = rhs.eliminateRedundancy;
+  renameRegisters = rhs.renameRegisters;
+  assumeFiniteValues = rhs.assumeFiniteValues;
+  semanticIntronTolerance = rhs.semanticIntronTolerance;
+  fusionThreshold = rhs.fusionThreshold;
+  transcendentalOperations = rhs.transcendentalOperations;
+  fastTranscendentals = rhs.fastTranscendentals;
+  evaluationKernels = rhs.evaluationKernels;
+  autotune = rhs.autotune;
+  autotuneSeconds = rhs.autotuneSeconds;
+  tuningCacheFilePath = rhs.tuningCacheFilePath;
+}
+
+
+
+template <class T>
+void VUWLGP::Config<T>::SetDefaults() {
+  seedSpecified = false;
+
+  numIslands = 1;
+  migrationInterval = 10;
+  migrationSize = 5;
+  bindIslandsToNumaNodes = true;
+
+  numThreads = 1;
+  populationModel = "generational";
+
+  numRuns = 1;
+  numConcurrentRuns = 0;
+  runSummaryFilePath = "runs.csv";
+
+  checkpointInterval = 0;
+  checkpointFilePath = "checkpoint";
+  resumeFrom = "";
+
+  asyncLogging = true;
+  logQueueLength = 4;
+  dropLogsWhenBehind = true;
+
+  popLogFormat = "text";
+  historyKeyframeInterval = 10;
+
+  metricsFormat = "none";
+  metricsFilePath = "metrics";
+  metricsBestProgram = false;
+
+  trainingCasesFilePath = "";
+  testCasesFilePath = "";
+
+  evaluationChunkSize = 0;
+
+  evaluationTileSize = 0;
+  evaluationProgramBatch = 16;
+
+  evaluationEngine = "auto";
+  lockstepMaxCases = 256;
+
+  precision = "double";
+  rescoreInDouble = false;
+
+  featureStorage = "full";
+
+  foldConstants = true;
+  eliminateRedundancy = true;
+  renameRegisters = true;
+  assumeFiniteValues = false;
+
+  semanticIntronTolerance = -1;
+
+  fusionThreshold = 0.02;
+
+  transcendentalOperations = false;
+  fastTranscendentals = false;
+
+  evaluationKernels = "auto";
+
+  autotune = false;
+  autotuneSeconds = 2;
+  tuningCacheFilePath = "tuning.cache";
+}
+
+
+
 template <class T>
 void VUWLGP::Config<T>::Init(int argc, char** argv, bool printAsParses) {
   for(int i = 1; i < argc; ++i) {
@@ -200,6 +522,315 @@ void VUWLGP::Config<T>::Init(int argc, char** argv, bool printAsParses) {
 	std::cout << "Set Config::randSeed to " << randSeed << std::endl;
       }
     }
+    else if(arg.substr(0, colonPos) == "numIslands") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> numIslands;
+      if(printAsParses) { 
+	std::cout << "Set Config::numIslands to " << numIslands << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "migrationInterval") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> migrationInterval;
+      if(printAsParses) { 
+	std::cout << "Set Config::migrationInterval to " << migrationInterval << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "migrationSize") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> migrationSize;
+      if(printAsParses) { 
+	std::cout << "Set Config::migrationSize to " << migrationSize << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "bindIslandsToNumaNodes") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> bindIslandsToNumaNodes;
+      if(printAsParses) { 
+	std::cout << "Set Config::bindIslandsToNumaNodes to " << bindIslandsToNumaNodes 
+		  << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "numThreads") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> numThreads;
+      if(printAsParses) { 
+	std::cout << "Set Config::numThreads to " << numThreads << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "populationModel") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> populationModel;
+      if(printAsParses) { 
+	std::cout << "Set Config::populationModel to " << populationModel << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "numRuns") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> numRuns;
+      if(printAsParses) { 
+	std::cout << "Set Config::numRuns to " << numRuns << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "numConcurrentRuns") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> numConcurrentRuns;
+      if(printAsParses) { 
+	std::cout << "Set Config::numConcurrentRuns to " << numConcurrentRuns << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "runSummaryFilePath") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> runSummaryFilePath;
+      if(printAsParses) { 
+	std::cout << "Set Config::runSummaryFilePath to " << runSummaryFilePath << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "checkpointInterval") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> checkpointInterval;
+      if(printAsParses) { 
+	std::cout << "Set Config::checkpointInterval to " << checkpointInterval 
+		  << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "checkpointFilePath") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> checkpointFilePath;
+      if(printAsParses) { 
+	std::cout << "Set Config::checkpointFilePath to " << checkpointFilePath 
+		  << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "resumeFrom") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> resumeFrom;
+      if(printAsParses) { 
+	std::cout << "Set Config::resumeFrom to " << resumeFrom << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "asyncLogging") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> asyncLogging;
+      if(printAsParses) { 
+	std::cout << "Set Config::asyncLogging to " << asyncLogging << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "logQueueLength") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> logQueueLength;
+      if(printAsParses) { 
+	std::cout << "Set Config::logQueueLength to " << logQueueLength << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "dropLogsWhenBehind") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> dropLogsWhenBehind;
+      if(printAsParses) { 
+	std::cout << "Set Config::dropLogsWhenBehind to " << dropLogsWhenBehind 
+		  << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "popLogFormat") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> popLogFormat;
+      if(printAsParses) { 
+	std::cout << "Set Config::popLogFormat to " << popLogFormat << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "historyKeyframeInterval") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> historyKeyframeInterval;
+      if(printAsParses) { 
+	std::cout << "Set Config::historyKeyframeInterval to " << historyKeyframeInterval 
+		  << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "metricsFormat") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> metricsFormat;
+      if(printAsParses) { 
+	std::cout << "Set Config::metricsFormat to " << metricsFormat << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "metricsFilePath") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> metricsFilePath;
+      if(printAsParses) { 
+	std::cout << "Set Config::metricsFilePath to " << metricsFilePath << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "metricsBestProgram") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> metricsBestProgram;
+      if(printAsParses) { 
+	std::cout << "Set Config::metricsBestProgram to " << metricsBestProgram 
+		  << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "trainingCasesFilePath") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> trainingCasesFilePath;
+      if(printAsParses) { 
+	std::cout << "Set Config::trainingCasesFilePath to " << trainingCasesFilePath 
+		  << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "testCasesFilePath") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> testCasesFilePath;
+      if(printAsParses) { 
+	std::cout << "Set Config::testCasesFilePath to " << testCasesFilePath << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "evaluationChunkSize") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> evaluationChunkSize;
+      if(printAsParses) { 
+	std::cout << "Set Config::evaluationChunkSize to " << evaluationChunkSize 
+		  << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "evaluationTileSize") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> evaluationTileSize;
+      if(printAsParses) { 
+	std::cout << "Set Config::evaluationTileSize to " << evaluationTileSize 
+		  << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "evaluationProgramBatch") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> evaluationProgramBatch;
+      if(printAsParses) { 
+	std::cout << "Set Config::evaluationProgramBatch to " << evaluationProgramBatch 
+		  << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "evaluationEngine") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> evaluationEngine;
+      if(printAsParses) { 
+	std::cout << "Set Config::evaluationEngine to " << evaluationEngine << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "lockstepMaxCases") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> lockstepMaxCases;
+      if(printAsParses) { 
+	std::cout << "Set Config::lockstepMaxCases to " << lockstepMaxCases << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "precision") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> precision;
+      if(printAsParses) { 
+	std::cout << "Set Config::precision to " << precision << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "rescoreInDouble") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> rescoreInDouble;
+      if(printAsParses) { 
+	std::cout << "Set Config::rescoreInDouble to " << rescoreInDouble << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "featureStorage") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> featureStorage;
+      if(printAsParses) { 
+	std::cout << "Set Config::featureStorage to " << featureStorage << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "foldConstants") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> foldConstants;
+      if(printAsParses) { 
+	std::cout << "Set Config::foldConstants to " << foldConstants << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "eliminateRedundancy") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> eliminateRedundancy;
+      if(printAsParses) { 
+	std::cout << "Set Config::eliminateRedundancy to " << eliminateRedundancy << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "renameRegisters") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> renameRegisters;
+      if(printAsParses) { 
+	std::cout << "Set Config::renameRegisters to " << renameRegisters << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "assumeFiniteValues") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> assumeFiniteValues;
+      if(printAsParses) { 
+	std::cout << "Set Config::assumeFiniteValues to " << assumeFiniteValues 
+		  << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "semanticIntronTolerance") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> semanticIntronTolerance;
+      if(printAsParses) { 
+	std::cout << "Set Config::semanticIntronTolerance to " << semanticIntronTolerance 
+		  << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "fusionThreshold") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> fusionThreshold;
+      if(printAsParses) { 
+	std::cout << "Set Config::fusionThreshold to " << fusionThreshold << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "transcendentalOperations") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> transcendentalOperations;
+      if(printAsParses) { 
+	std::cout << "Set Config::transcendentalOperations to " << transcendentalOperations 
+		  << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "fastTranscendentals") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> fastTranscendentals;
+      if(printAsParses) { 
+	std::cout << "Set Config::fastTranscendentals to " << fastTranscendentals 
+		  << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "evaluationKernels") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> evaluationKernels;
+      if(printAsParses) { 
+	std::cout << "Set Config::evaluationKernels to " << evaluationKernels << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "autotune") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> autotune;
+      if(printAsParses) { 
+	std::cout << "Set Config::autotune to " << autotune << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "autotuneSeconds") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> autotuneSeconds;
+      if(printAsParses) { 
+	std::cout << "Set Config::autotuneSeconds to " << autotuneSeconds << std::endl;
+      }
+    }
+    else if(arg.substr(0, colonPos) == "tuningCacheFilePath") {
+      std::istringstream conv(arg.substr(colonPos + 1));
+      conv >> tuningCacheFilePath;
+      if(printAsParses) { 
+	std::cout << "Set Config::tuningCacheFilePath to " << tuningCacheFilePath 
+		  << std::endl;
+      }
+    }
     else if(colonPos != std::string::npos) {
       std::cout << "Argument '" << arg << "' unrecognised." << std::endl;
     }
@@ -208,6 +839,29 @@ void VUWLGP::Config<T>::Init(int argc, char** argv, bool printAsParses) {
 
 
 
+template <class T>
+unsigned int VUWLGP::Config<T>::NumberOfThreads() const {
+  if(numThreads != 0) {
+    return numThreads;
+  }
+
+  unsigned int hardwareThreads = std::thread::hardware_concurrency();
+  return hardwareThreads != 0 ? hardwareThreads : 1;
+}
+
+
+
+template <class T>
+std::string VUWLGP::Config<T>::EvaluationEngineFor(unsigned int numCases) const {
+  if(evaluationEngine != "auto") {
+    return evaluationEngine;
+  }
+
+  return lockstepMaxCases == 0 || numCases <= lockstepMaxCases ? "lockstep" : "batch";
+}
+
+
+
 template <class T> VUWLGP::Config<T>::~Config() {
   delete instructionOperations;
   delete argumentGenerators;
@@ -1,12 +1,23 @@
 //        Farhad   Mohammad Kazemi
 
+#include <algorithm>
 #include <ctime>
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 
+#include "AsynchronousSteadyStatePopulation.h"
 #include "Config.h"
+#include "Dataset.h"
+#include "ExecutionPlan.h"
 #include "GenerationalTournamentPopulation.h"
+#include "IslandModel.h"
+#include "KernelDispatch.h"
+#include "MultiRunDriver.h"
+#include "OpSet.h"
+#include "PipelinedGenerationalPopulation.h"
+#include "ProgramSerialiser.h"
 
 #include "InstructionArgumentConstant.h"
 #include "InstructionArgumentFeature.h"
@@ -17,6 +28,11 @@
 #include "InstructionOperationMult.h"
 #include "InstructionOperationDiv.h"
 #include "InstructionOperationIflt.h"
+#include "InstructionOperationExp.h"
+#include "InstructionOperationSin.h"
+#include "InstructionOperationCos.h"
+#include "InstructionOperationSqrt.h"
+#include "InstructionOperationLog.h"
 
 #include "SymRegFitnessCase.h"
 
@@ -26,34 +42,247 @@ using namespace VUWLGP; // else the lines of code get stupidly and clumsily long
 
 // Initialise the static members which specify the proportion selected through elitism and
 // the size of the selection tournaments for other evolutionary operators:
-double GenerationalTournamentPopulation<SymRegProgram<double>, double>::proportionElitism
+template <> double
+GenerationalTournamentPopulation<SymRegProgram<double>, double>::proportionElitism
 = 0.1;
-unsigned int GenerationalTournamentPopulation<SymRegProgram<double>, double>::tournamentSize
+template <> unsigned int
+GenerationalTournamentPopulation<SymRegProgram<double>, double>::tournamentSize
+= 2;
+template <> unsigned int
+AsynchronousSteadyStatePopulation<SymRegProgram<double>, double>::tournamentSize
+= 2;
+template <> double
+GenerationalTournamentPopulation<SymRegProgram<float>, float>::proportionElitism
+= 0.1;
+template <> unsigned int
+GenerationalTournamentPopulation<SymRegProgram<float>, float>::tournamentSize
+= 2;
+template <> unsigned int
+AsynchronousSteadyStatePopulation<SymRegProgram<float>, float>::tournamentSize
 = 2;
 
-int main(int argc, char** argv) {
+// Builds the population which is evolved, of the kind Config::populationModel names. Caller is
+// responsible for the memory.
+template <class T>
+static IPopulation<SymRegProgram<T>, T>* BuildPopulation(Config<T>* c) {
+	if (c->populationModel == "asynchronous") {
+		return new AsynchronousSteadyStatePopulation<SymRegProgram<T>, T>(c);
+	}
+	else if (c->populationModel == "pipelined") {
+		return new PipelinedGenerationalPopulation<SymRegProgram<T>, T>(c);
+	}
+	else if (c->populationModel != "generational") {
+		throw std::string("Unknown population model: ") + c->populationModel;
+	}
+	return new GenerationalTournamentPopulation<SymRegProgram<T>, T>(c);
+}
+
+// The fitness cases loaded from Config::trainingCasesFilePath and testCasesFilePath, if they
+// were given. Loaded once by Run, before any runs start, and shared by all of them:
+template <class T> struct LoadedData {
+	static Dataset<T>* training;
+	static Dataset<T>* test;
+};
+template <class T> Dataset<T>* LoadedData<T>::training = 0;
+template <class T> Dataset<T>* LoadedData<T>::test = 0;
+
+// Adds the arguments and operations programs are built from to c.
+template <class T>
+static void AddInstructionSet(Config<T>* c) {
+	c->argumentGenerators->AddElement(InstructionArgumentConstant<T>::Generate);
+	c->argumentGenerators->AddElement(InstructionArgumentFeature<T>::Generate);
+	c->argumentGenerators->AddElement(InstructionArgumentRegister<T>::Generate);
+
+	// As an OpSet, which also compiles programs for the "compiled" evaluation engine:
+	if (c->transcendentalOperations) {
+		OpSet<T, InstructionOperationPlus, InstructionOperationMinus, InstructionOperationMult,
+			InstructionOperationDiv, InstructionOperationIflt, InstructionOperationExp,
+			InstructionOperationSin, InstructionOperationCos, InstructionOperationSqrt,
+			InstructionOperationLog>::Register(c);
+	}
+	else {
+		OpSet<T, InstructionOperationPlus, InstructionOperationMinus, InstructionOperationMult,
+			InstructionOperationDiv, InstructionOperationIflt>::Register(c);
+	}
+	Transcendental<T>::fast = c->fastTranscendentals;
+}
+
+// Makes fe evaluate against data where it is - the cases of its split called splitName, if it
+// has one, otherwise all of them.
+template <class T>
+static void UseDataset(FitnessEnvironment<T>* fe, const Dataset<T>& data,
+	const std::string& splitName) {
+	const typename Dataset<T>::Split* split = data.FindSplit(splitName);
+	fe->UseDataset(data, split != 0 ? split->begin : 0,
+		split != 0 ? split->end : data.NumberOfCases(), SymRegFitnessCase<T>::Generate);
+}
+
+// Stores the features of fe as Config::featureStorage says, if it isn't "full", and prints how
+// much precision the features of the cases called name lost.
+template <class T>
+static void PackFeatures(Config<T>* c, FitnessEnvironment<T>* fe, const std::string& name) {
+	FeatureStorage storage = HalfFloat::StorageNamed(c->featureStorage);
+	if (storage == FullPrecision) {
+		return;
+	}
+
+	typename FitnessEnvironment<T>::PackingError error = fe->PackFeatures(storage);
+	// Written in one go, as runs on other threads may be packing their cases too:
+	std::ostringstream buffer;
+	buffer << "Stored the " << name << " features as " << c->featureStorage
+		<< ": largest error " << error.maxAbsolute << " (relative " << error.maxRelative
+		<< "), RMS error " << error.rms << ", " << error.overflows << " overflows" << std::endl;
+	std::cout << buffer.str();
+}
+
+// Builds the fitness environment we will train on (the training data, or the Mexican hat over
+// [-4, 4]). Caller is responsible for the memory.
+template <class T>
+static FitnessEnvironment<T>* BuildTrainingEnvironment(Config<T>* c) {
+	FitnessEnvironment<T>* train = new FitnessEnvironment<T>(c);
+	if (LoadedData<T>::training != 0) {
+		UseDataset(train, *LoadedData<T>::training, "train");
+		PackFeatures(c, train, "training");
+		return train;
+	}
+
+	for (double i = -4; i <= 4; i += 0.02) {
+		train->AddCase(new SymRegFitnessCase<T>(i, (1 - ((i*i) / 4) - ((i*i) / 4))*exp(-((i*i) / 8) - ((i*i) / 8))));
+	}
+	PackFeatures(c, train, "training");
+	return train;
+}
+
+// Builds the fitness environment we will test on (the test data, or the Mexican hat over
+// [-8, 8]). Caller is responsible for the memory.
+template <class T>
+static FitnessEnvironment<T>* BuildTestEnvironment(Config<T>* c) {
+	FitnessEnvironment<T>* test = new FitnessEnvironment<T>(c);
+	if (LoadedData<T>::test != 0) {
+		UseDataset(test, *LoadedData<T>::test, "test");
+		PackFeatures(c, test, "test");
+		return test;
+	}
+
+	for (double i = -8; i <= 8; i += 0.04) {
+		test->AddCase(new SymRegFitnessCase<T>(i, (1 - ((i*i) / 4) - ((i*i) / 4))*exp(-((i*i) / 8) - ((i*i) / 8))));
+	}
+	PackFeatures(c, test, "test");
+	return test;
+}
+
+// Frees the fitness cases loaded from files, if any.
+template <class T>
+static void DeleteData() {
+	if (LoadedData<T>::test != LoadedData<T>::training) {
+		delete LoadedData<T>::test;
+	}
+	delete LoadedData<T>::training;
+}
+
+// Builds a double precision copy of the cases fe evaluates against (which are the same
+// values, as every float is exactly a double), for c. Caller is responsible for the memory.
+template <class T>
+static FitnessEnvironment<double>* WidenEnvironment(Config<double>* c,
+	FitnessEnvironment<T>& fe) {
+	FitnessEnvironment<double>* wide = new FitnessEnvironment<double>(c);
+	if (!fe.LoadFirstCase()) {
+		return wide;
+	}
+
+	std::vector<double> x(c->numFeatures);
+	do {
+		for (unsigned int i = 0; i < x.size(); ++i) {
+			x[i] = fe.ReadFeature(i);
+		}
+		double y = static_cast<const SymRegFitnessCase<T>*>(fe.CurrentCase())->Y();
+		wide->AddCase(new SymRegFitnessCase<double>(x, y));
+	} while (fe.LoadNextCase());
+	return wide;
+}
+
+// Evaluates best, whose training and test fitnesses in T are trainingFitness and testFitness,
+// in double on the same cases and prints both, to show how much precision evaluating in T
+// loses.
+template <class T>
+static void RescoreInDouble(Config<T>* c, const IProgram<T>& best, FitnessEnvironment<T>& train,
+	FitnessEnvironment<T>& test, double trainingFitness, double testFitness) {
+	Config<double>* dc = new Config<double>();
+	dc->numRegisters = c->numRegisters;
+	dc->numFeatures = c->numFeatures;
+	dc->transcendentalOperations = c->transcendentalOperations;
+	dc->fastTranscendentals = c->fastTranscendentals;
+	AddInstructionSet(dc);
+
+	ProgramSerialiser<double> serialiser(dc);
+	SymRegProgram<double>* wideBest = serialiser.Convert<SymRegProgram<double> >(best);
+	FitnessEnvironment<double>* wideTrain = WidenEnvironment(dc, train);
+	FitnessEnvironment<double>* wideTest = WidenEnvironment(dc, test);
+
+	const char* names[2] = { "training", "test" };
+	FitnessEnvironment<double>* environments[2] = { wideTrain, wideTest };
+	double fitnesses[2] = { trainingFitness, testFitness };
+	std::cout << "Best program re-scored in double:" << std::endl;
+	for (unsigned int i = 0; i < 2; ++i) {
+		wideBest->UpdateFitness(*environments[i]);
+		double difference = fitnesses[i] - wideBest->Fitness();
+		std::cout << "  " << names[i] << " fitness " << wideBest->Fitness() << " ("
+			<< c->precision << " " << fitnesses[i] << ", difference " << difference
+			<< ", relative " << difference / wideBest->Fitness() << ")" << std::endl;
+	}
+
+	delete wideBest;
+	delete wideTest;
+	delete wideTrain;
+	delete dc;
+}
+
+// Prints best without its approximate semantic introns (see Config::semanticIntronTolerance),
+// and the training and test fitnesses it then has. Leaves best's fitness incorrect.
+template <class T>
+static void PrintWithoutSemanticIntrons(Config<T>* c, IProgram<T>& best,
+	FitnessEnvironment<T>& train, FitnessEnvironment<T>& test) {
+	best.MarkIntrons();
+	if (!ExecutionPlan<T>::CanCompile(best)) {
+		return;
+	}
+
+	ExecutionPlan<T> plan(best, c);
+	plan.Optimise(c);
+	plan.RemoveSemanticIntrons(train, c->semanticIntronTolerance);
+	std::cout << "Without semantic introns (" << plan.NumberOfSteps() << " steps):\n"
+		<< plan.ToString() << std::endl;
+
+	plan.Evaluate(best, train);
+	double trainingFitness = best.Fitness();
+	plan.Evaluate(best, test);
+	std::cout << "  training fitness " << trainingFitness << ", test fitness " << best.Fitness()
+		<< std::endl;
+}
+
+// Carries out the run(s) the command line asks for, with programs evaluated in T.
+template <class T>
+static int Run(int argc, char** argv) {
 	// Building the relevant config object - specify it all, even though not all of it is needed:
-	Config<double>* c;
+	Config<T>* c;
 	if (argc == 1) {
-		c = new Config<double>();
+		c = new Config<T>();
 	}
 	else {
-		c = new Config<double>(argc, argv, true);
+		c = new Config<T>(argc, argv, true);
 	}
 
 	c->numRegisters = 6;
 	c->numFeatures = 1;
 	c->epsilon = 0.1;
 
-	c->argumentGenerators->AddElement(InstructionArgumentConstant<double>::Generate);
-	c->argumentGenerators->AddElement(InstructionArgumentFeature<double>::Generate);
-	c->argumentGenerators->AddElement(InstructionArgumentRegister<double>::Generate);
+	AddInstructionSet(c);
 
-	c->instructionOperations->AddElement(InstructionOperationPlus<double>::Generate);
-	c->instructionOperations->AddElement(InstructionOperationMinus<double>::Generate);
-	c->instructionOperations->AddElement(InstructionOperationMult<double>::Generate);
-	c->instructionOperations->AddElement(InstructionOperationDiv<double>::Generate);
-	c->instructionOperations->AddElement(InstructionOperationIflt<double>::Generate);
+	// The batch kernels' instruction set level, which only the batch engine (and auto, for
+	// larger datasets) uses:
+	KernelDispatch::Select(c->evaluationKernels);
+	std::cout << "Evaluation kernels: " << KernelDispatch::Name(KernelDispatch::Selected())
+		<< std::endl;
 
 	c->initialMinLength = 6;
 	c->initialMaxLength = 10;
@@ -68,6 +297,51 @@ int main(int argc, char** argv) {
 
 	c->runLogFilePath = "results.csv";
 
+	// Load the fitness cases from files if they were given. Programs can use every feature:
+	if (!c->trainingCasesFilePath.empty()) {
+		Dataset<T>*& trainingData = LoadedData<T>::training;
+		Dataset<T>*& testData = LoadedData<T>::test;
+		trainingData = new Dataset<T>(c->trainingCasesFilePath, Dataset<T>::Regression,
+			c->NumberOfThreads());
+		testData = c->testCasesFilePath.empty() ? trainingData : new Dataset<T>(
+			c->testCasesFilePath, Dataset<T>::Regression, c->NumberOfThreads());
+
+		if (testData->NumberOfFeatures() != trainingData->NumberOfFeatures()) {
+			throw std::string("The training and test cases have different numbers of features");
+		}
+		c->numFeatures = trainingData->NumberOfFeatures();
+	}
+
+	// Each island is a separate process which seeds the RNG and builds its own population and
+	// fitness environments, the coordinator just waits for them and merges their results:
+	if (c->numIslands > 1) {
+		IslandModel<SymRegProgram<T>, T> islands(c, BuildPopulation<T>,
+			BuildTrainingEnvironment<T>, BuildTestEnvironment<T>);
+
+		std::cout << "Running " << c->numIslands << " islands." << std::endl;
+		unsigned int generationsUsed = islands.Evolve();
+		std::cout << (generationsUsed <= c->maxGenerations ? "Solution found" : "No solution found")
+			<< " on island " << islands.BestIsland() << ". Island results:" << std::endl;
+		islands.LogResults();
+
+		DeleteData<T>();
+		delete c;
+		return 0;
+	}
+
+	// Independent runs are carried out on their own threads, each seeding its own RNG:
+	if (c->numRuns > 1) {
+		MultiRunDriver<SymRegProgram<T>, T> driver(c, BuildPopulation<T>,
+			BuildTrainingEnvironment<T>, BuildTestEnvironment<T>);
+
+		std::cout << "Carrying out " << c->numRuns << " runs." << std::endl;
+		driver.Run();
+
+		DeleteData<T>();
+		delete c;
+		return 0;
+	}
+
 	// Initialise the RNG:
 	if (c->seedSpecified) {
 		Rand::Init(c->randSeed);
@@ -77,28 +351,32 @@ int main(int argc, char** argv) {
 	}
 
 	// Building the population object, randomising the fitness of it all:
-	IPopulation<SymRegProgram<double>, double>* pop =
-		new GenerationalTournamentPopulation<SymRegProgram<double>, double>(c);
+	IPopulation<SymRegProgram<T>, T>* pop = BuildPopulation(c);
 
-	// Build the fitness environment we will train and another we will test on:
-	FitnessEnvironment<double> train(c);
-	for (double i = -4; i <= 4; i += 0.02) {
-		train.AddCase(new SymRegFitnessCase<double>(i, (1 - ((i*i) / 4) - ((i*i) / 4))*exp(-((i*i) / 8) - ((i*i) / 8))));
+	// Carry on from a checkpoint if asked to - this replaces the programs and RNG state:
+	if (!c->resumeFrom.empty()) {
+		unsigned int generation = pop->LoadCheckpoint(c->resumeFrom);
+		std::cout << "Resuming from generation " << generation << " of " << c->resumeFrom
+			<< std::endl;
 	}
 
-	FitnessEnvironment<double> test(c);
-	for (double i = -8; i <= 8; i += 0.04) {
-				test.AddCase(new SymRegFitnessCase<double>(i, (1 - ((i*i) / 4) - ((i*i) / 4))*exp(-((i*i) / 8) - ((i*i) / 8))));
-	}
+	// Build the fitness environment we will train and another we will test on:
+	FitnessEnvironment<T>* train = BuildTrainingEnvironment(c);
+	FitnessEnvironment<T>* test = BuildTestEnvironment(c);
 
-	std::cout << "Loaded " << train.NumberOfCases() << " training cases and "
-		<< test.NumberOfCases() << " test cases. Beginning evolution." << std::endl;
+	std::cout << "Loaded " << train->NumberOfCases() << " training cases and "
+		<< test->NumberOfCases() << " test cases. Beginning evolution." << std::endl;
 
 
 	// Carry out the evolution:
 	//clock();
-	unsigned int generationsUsedOrNoSolution = pop->Evolve(train);
+	unsigned int generationsUsedOrNoSolution = pop->Evolve(*train);
 	int time = clock();
+	unsigned int droppedLogs = pop->FlushLogs();
+	if (droppedLogs != 0) {
+		std::cout << droppedLogs << " logs were dropped as the log writer fell behind."
+			<< std::endl;
+	}
 
 	if (generationsUsedOrNoSolution <= c->maxGenerations) {
 		std::cout << "Solution found.\nSolution is:" << std::endl;
@@ -107,8 +385,23 @@ int main(int argc, char** argv) {
 		std::cout << "No solution found.\nBest program:" << std::endl;
 	}
 
-	IProgram<double>* best = pop->GetFittestProgram();
-	std::cout << pop->GetFittestProgram()->ToString(true, true) << std::endl;
+	IProgram<T>* best = pop->GetFittestProgram();
+	std::cout << best->ToString(true, true) << std::endl;
+
+	// And its effective code as the evaluators run it, e.g. for deploying it:
+	best->MarkIntrons();
+	if (ExecutionPlan<T>::CanCompile(*best)) {
+		ExecutionPlan<T> plan(*best, c);
+		plan.Optimise(c);
+		std::cout << "Optimised (" << plan.NumberOfSteps() << " steps):\n" << plan.ToString()
+			<< std::endl;
+	}
+	if (c->evaluationEngine == "plan") {
+		std::cout << pop->StepProfile().ToString() << std::endl;
+	}
+	if (!pop->TuningDecision().empty()) {
+		std::cout << "Autotuned evaluation: " << pop->TuningDecision() << std::endl;
+	}
 
 	// Now calculate the statistics that aren't already calculated:
 	std::cout << "Writing run statistics to: " << c->runLogFilePath << std::endl;
@@ -120,7 +413,7 @@ int main(int argc, char** argv) {
 
 	double bestTrainingFitness = best->Fitness();
 
-	best->UpdateFitness(test);
+	best->UpdateFitness(*test);
 	double bestTestFitness = best->Fitness();
 
 	std::ofstream fout(c->runLogFilePath.c_str(), std::ios::out | std::ios::app);
@@ -128,10 +421,40 @@ int main(int argc, char** argv) {
 		<< std::endl;
 	std::cout << generations << "," << time << "," << bestTrainingFitness << ","
 		<< bestTestFitness << std::endl;
-	std::cout << "\n\t(NB: Clock ticks per second: " << CLK_TCK << ")" << std::endl;
+	std::cout << "\n\t(NB: Clock ticks per second: " << CLOCKS_PER_SEC << ")" << std::endl;
 	fout.close();
 
+	if (c->rescoreInDouble) {
+		RescoreInDouble(c, *best, *train, *test, bestTrainingFitness, bestTestFitness);
+	}
+	if (c->semanticIntronTolerance >= 0) {
+		PrintWithoutSemanticIntrons(c, *best, *train, *test);
+	}
+
 	delete pop;
+	delete test;
+	delete train;
+	DeleteData<T>();
 	delete c;
 	return 0;
 }
+
+int main(int argc, char** argv) {
+	// The precision is the type the Config and everything else is built with, so it has to be
+	// found before the Config parses the command line:
+	std::string precision = "double";
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg.find("precision:") == 0) {
+			precision = arg.substr(std::string("precision:").size());
+		}
+	}
+
+	if (precision == "float") {
+		return Run<float>(argc, argv);
+	}
+	else if (precision != "double") {
+		throw std::string("Unknown precision: ") + precision;
+	}
+	return Run<double>(argc, argv);
+}
@@ -0,0 +1,634 @@
+
+  
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MappedFile.h"
+
+namespace VUWLGP {
+  // A set of fitness cases stored column by column - a std::vector of the values of each
+  // feature, and one of the targets (for symbolic regression) or class numbers (for
+  // classification) - loaded from a text file. The file is memory-mapped and split into one
+  // chunk per thread at line boundaries. Each thread counts the cases in its chunk, then
+  // parses its numbers straight into their places in the columns.
+  //
+  // There is one case per line, its fields separated by any mix of spaces, tabs, commas and
+  // semicolons. Blank lines and lines starting with # are ignored. In a Regression file each
+  // line is the features followed by the target, and the file may start with a line of column
+  // names. A Patterns file is in the pattern format MultiClassFitnessCase reads: the image, x
+  // and y position, class number and class name, followed by the features. Every case must
+  // have the same number of features.
+  //
+  // A dataset can be saved in a binary format which is opened by mapping it, with no copying
+  // or parsing - the columns are used where they are in the mapped file. It can also record
+  // named splits of the cases (e.g. "train" and "test"), as ranges of case numbers.
+  template <class T> class Dataset {
+  public:
+    enum Format { Regression, Patterns };
+
+    // A named range [begin, end) of case numbers.
+    struct Split {
+      std::string name;
+      unsigned int begin;
+      unsigned int end;
+    };
+
+    // Loads the file at filePath using up to numThreads threads. If it is a binary dataset
+    // (see Save) it is mapped instead. Throws a std::string if the file can't be read, one of
+    // its cases can't be parsed or a binary dataset was saved with a different T or format.
+    Dataset(const std::string& filePath, Format format, unsigned int numThreads);
+    ~Dataset();
+
+    // Writes the dataset, with splits, in the binary format. Throws a std::string if it can't.
+    void Save(const std::string& filePath, const std::vector<Split>& splits) const;
+
+    unsigned int NumberOfCases() const { return numCases; }
+    unsigned int NumberOfFeatures() const { return featureColumns.size(); }
+    Format DataFormat() const { return format; }
+
+    // The values of feature f for every case.
+    const T* Feature(unsigned int f) const { return featureColumns[f]; }
+
+    // Feature f of case i, and case i's target (Regression files) or class (Patterns files).
+    T F(unsigned int f, unsigned int i) const { return featureColumns[f][i]; }
+    double Target(unsigned int i) const { return targetColumn[i]; }
+    unsigned int ClassNumber(unsigned int i) const { return classColumn[i]; }
+
+    // Advise the system that cases [begin, end) are about to be read, or won't be read again
+    // for a while, so that a mapped dataset larger than memory can be read a block at a time
+    // (see MappedFile::Advise). They do nothing for datasets which were parsed into memory.
+    void Prefetch(unsigned int begin, unsigned int end) const { Advise(begin, end, true); }
+    void Release(unsigned int begin, unsigned int end) const { Advise(begin, end, false); }
+
+    // The splits recorded in a binary dataset, and the one called name (if there is one).
+    const std::vector<Split>& Splits() const { return splits; }
+    const Split* FindSplit(const std::string& name) const;
+
+    // Parses the number at pos, which must end at a field separator or end, and moves pos past
+    // it. Returns false if there isn't a number there. Decimal numbers with up to 19
+    // significant digits and small exponents are converted exactly without strtod, which
+    // anything else (e.g. inf, or longer mantissas) falls back to.
+    static bool ParseNumber(const char*& pos, const char* end, double& value);
+
+    // Returns pos moved past any field separators before end.
+    static const char* SkipSeparators(const char* pos, const char* end);
+
+  private:
+    Dataset(const Dataset<T>& rhs); // not copyable
+    Dataset<T>& operator=(const Dataset<T>& rhs);
+
+    // The layout of a binary dataset: the 8 byte tag "VUWLGPDS", then a Header, then
+    // numSplits BinarySplits, then (starting at dataOffset) each feature column, each
+    // featureColumnBytes long, and the target or class column. Offsets and sizes are multiples
+    // of 64 bytes, so the columns are aligned in the mapped file. Values are stored in the
+    // native byte order, targets as doubles and classes as unsigned ints.
+    struct Header {
+      unsigned int version;
+      unsigned int elementSize; // sizeof(T)
+      unsigned int format;
+      unsigned int numFeatures;
+      unsigned long long numCases;
+      unsigned long long dataOffset;
+      unsigned long long featureColumnBytes;
+      unsigned long long targetColumnBytes;
+      unsigned int numSplits;
+      unsigned int reserved;
+    };
+
+    struct BinarySplit {
+      char name[24]; // null padded
+      unsigned int begin;
+      unsigned int end;
+    };
+
+    // Passes cases [begin, end) of each column to MappedFile::Advise.
+    void Advise(unsigned int begin, unsigned int end, bool needed) const;
+
+    // Maps the binary dataset at filePath and sets up the columns to use it. Throws a
+    // std::string if it isn't a valid binary dataset of T in format.
+    void OpenBinary(const std::string& filePath);
+
+    // Sets count to the number of cases in [begin, end), which starts at the start of a line.
+    static void CountCases(const char* begin, const char* end, unsigned int& count);
+
+    // Parses the cases in [begin, end) into the columns, the first of them as case number
+    // first. Sets error if one of them can't be parsed.
+    void ParseCases(const char* begin, const char* end, unsigned int first, std::string& error);
+
+    // Parses the case on the line [begin, end) into place i in the columns. Returns false if
+    // it can't.
+    bool ParseCase(const char* begin, const char* end, unsigned int i);
+
+    // Returns the end of the line starting at pos (the '\n', or end).
+    static const char* LineEnd(const char* pos, const char* end) {
+      const char* newline = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+      return newline != 0 ? newline : end;
+    }
+
+    // Returns true if the line [begin, end) holds a case, rather than being blank or a comment.
+    static bool IsCase(const char* begin, const char* end) {
+      const char* pos = SkipSeparators(begin, end);
+      return pos != end && *pos != '#';
+    }
+
+    static bool IsSeparator(char c) {
+      return c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\r' || c == '\n';
+    }
+
+    // Returns pos moved past the field at it.
+    static const char* SkipField(const char* pos, const char* end) {
+      while(pos != end && !IsSeparator(*pos)) { ++pos; }
+      return pos;
+    }
+
+    Format format;
+    unsigned int numCases;
+    std::vector<Split> splits;
+
+    // The columns, either in the storage below (parsed files) or the mapping (binary files):
+    std::vector<const T*> featureColumns;
+    const double* targetColumn;
+    const unsigned int* classColumn;
+
+    std::vector<std::vector<T> > features;
+    std::vector<double> targets;
+    std::vector<unsigned int> classes;
+    MappedFile* mapping;
+  };
+}
+
+
+
+////////////////////////////////// INLINE FUNCTION DEFINITIONS /////////////////////////////////
+template <class T>
+VUWLGP::Dataset<T>::Dataset(const std::string& filePath, Format f, unsigned int numThreads):
+format(f),
+numCases(0),
+targetColumn(0),
+classColumn(0),
+mapping(0) {
+  MappedFile file(filePath);
+  const char* begin = file.Data();
+  const char* end = begin + file.Size();
+
+  if(file.Size() >= 8 + sizeof(Header) && std::memcmp(begin, "VUWLGPDS", 8) == 0) {
+    // The destructor won't run if OpenBinary refuses the file, so the mapping is freed here:
+    try {
+      OpenBinary(filePath);
+    }
+    catch(...) {
+      delete mapping;
+      throw;
+    }
+    return;
+  }
+
+  // The first case gives the number of features. In a Regression file it might be preceded
+  // by column names:
+  bool headerSkipped = format != Regression;
+  const char* first = begin;
+  while(first < end) {
+    const char* lineEnd = LineEnd(first, end);
+    if(IsCase(first, lineEnd)) {
+      const char* pos = SkipSeparators(first, lineEnd);
+      double unused;
+      if(headerSkipped || ParseNumber(pos, lineEnd, unused)) {
+	break;
+      }
+      begin = lineEnd;
+      headerSkipped = true;
+    }
+    first = lineEnd + 1;
+  }
+
+  if(first >= end) {
+    return; // no cases
+  }
+
+  unsigned int numFields = 0;
+  const char* lineEnd = LineEnd(first, end);
+  for(const char* pos = SkipSeparators(first, lineEnd); pos != lineEnd;
+      pos = SkipSeparators(SkipField(pos, lineEnd), lineEnd)) {
+    ++numFields;
+  }
+
+  unsigned int otherFields = format == Regression ? 1 : 5;
+  if(numFields <= otherFields) {
+    throw filePath + ": the first case has no features";
+  }
+  features.resize(numFields - otherFields);
+
+  // Split the file into chunks (of at least a megabyte) which start at the start of a line:
+  unsigned int numChunks = std::max(1u, numThreads);
+  numChunks = std::min<size_t>(numChunks, (end - begin) / (1 << 20) + 1);
+
+  std::vector<const char*> bounds(1, begin);
+  for(unsigned int i = 1; i < numChunks; ++i) {
+    const char* bound = std::max(begin + (end - begin) / numChunks * i, bounds.back());
+    bounds.push_back(std::min(LineEnd(bound, end) + 1, end));
+  }
+  bounds.push_back(end);
+
+  // Count the cases in each chunk, to find where each one's cases go:
+  std::vector<unsigned int> counts(numChunks);
+  std::vector<std::thread> threads;
+  for(unsigned int i = 0; i < numChunks; ++i) {
+    threads.push_back(std::thread(&Dataset<T>::CountCases, bounds[i], bounds[i + 1],
+				  std::ref(counts[i])));
+  }
+  for(unsigned int i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  std::vector<unsigned int> firsts;
+  for(unsigned int i = 0; i < numChunks; ++i) {
+    firsts.push_back(numCases);
+    numCases += counts[i];
+  }
+
+  for(unsigned int i = 0; i < features.size(); ++i) {
+    features[i].resize(numCases);
+  }
+  if(format == Regression) {
+    targets.resize(numCases);
+  }
+  else {
+    classes.resize(numCases);
+  }
+
+  // Then parse them:
+  std::vector<std::string> errors(numChunks);
+  threads.clear();
+  for(unsigned int i = 0; i < numChunks; ++i) {
+    threads.push_back(std::thread(&Dataset<T>::ParseCases, this, bounds[i], bounds[i + 1],
+				  firsts[i], std::ref(errors[i])));
+  }
+  for(unsigned int i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  for(unsigned int i = 0; i < numChunks; ++i) {
+    if(!errors[i].empty()) {
+      throw filePath + ": " + errors[i];
+    }
+  }
+
+  for(unsigned int i = 0; i < features.size(); ++i) {
+    featureColumns.push_back(numCases > 0 ? &features[i][0] : 0);
+  }
+  targetColumn = targets.empty() ? 0 : &targets[0];
+  classColumn = classes.empty() ? 0 : &classes[0];
+}
+
+
+
+template <class T>
+VUWLGP::Dataset<T>::~Dataset() {
+  delete mapping;
+}
+
+
+
+template <class T> void
+VUWLGP::Dataset<T>::Save(const std::string& filePath, const std::vector<Split>& saveSplits) const {
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  header.version = 1;
+  header.elementSize = sizeof(T);
+  header.format = format;
+  header.numFeatures = NumberOfFeatures();
+  header.numCases = numCases;
+  header.numSplits = saveSplits.size();
+
+  unsigned long long targetSize = format == Regression ? sizeof(double) : sizeof(unsigned int);
+  header.featureColumnBytes = (numCases * sizeof(T) + 63) / 64 * 64;
+  header.targetColumnBytes = (numCases * targetSize + 63) / 64 * 64;
+  header.dataOffset = (8 + sizeof(Header) + saveSplits.size() * sizeof(BinarySplit) + 63) /
+    64 * 64;
+
+  std::vector<char> start(header.dataOffset, 0);
+  std::memcpy(&start[0], "VUWLGPDS", 8);
+  std::memcpy(&start[8], &header, sizeof(header));
+
+  for(unsigned int i = 0; i < saveSplits.size(); ++i) {
+    if(saveSplits[i].begin > saveSplits[i].end || saveSplits[i].end > numCases ||
+       saveSplits[i].name.size() >= sizeof(BinarySplit().name)) {
+      throw "Dataset::Save - split " + saveSplits[i].name + " is invalid";
+    }
+
+    BinarySplit split;
+    std::memset(&split, 0, sizeof(split));
+    saveSplits[i].name.copy(split.name, saveSplits[i].name.size());
+    split.begin = saveSplits[i].begin;
+    split.end = saveSplits[i].end;
+    std::memcpy(&start[8 + sizeof(Header) + i * sizeof(BinarySplit)], &split, sizeof(split));
+  }
+
+  FILE* file = std::fopen(filePath.c_str(), "wb");
+  if(file == 0) {
+    throw "Dataset::Save - could not open " + filePath;
+  }
+
+  // Each column is followed by zeros up to the next multiple of 64 bytes:
+  std::vector<char> zeros(1 << 16, 0);
+  bool written = std::fwrite(&start[0], 1, start.size(), file) == start.size();
+  for(unsigned int i = 0; i <= NumberOfFeatures() && written; ++i) {
+    const void* column = i < NumberOfFeatures() ? static_cast<const void*>(Feature(i)) :
+      format == Regression ? static_cast<const void*>(targetColumn) :
+      static_cast<const void*>(classColumn);
+    size_t size = numCases * (i < NumberOfFeatures() ? sizeof(T) : targetSize);
+    written = size == 0 || std::fwrite(column, 1, size, file) == size;
+
+    for(size_t padding = (size + 63) / 64 * 64 - size; padding > 0 && written; ) {
+      size_t block = std::min(padding, zeros.size());
+      written = std::fwrite(&zeros[0], 1, block, file) == block;
+      padding -= block;
+    }
+  }
+
+  if(std::fclose(file) != 0 || !written) {
+    std::remove(filePath.c_str());
+    throw "Dataset::Save - could not write " + filePath;
+  }
+}
+
+
+
+template <class T> const typename VUWLGP::Dataset<T>::Split*
+VUWLGP::Dataset<T>::FindSplit(const std::string& name) const {
+  for(unsigned int i = 0; i < splits.size(); ++i) {
+    if(splits[i].name == name) {
+      return &splits[i];
+    }
+  }
+  return 0;
+}
+
+
+
+template <class T>
+void VUWLGP::Dataset<T>::OpenBinary(const std::string& filePath) {
+  mapping = new MappedFile(filePath, false);
+  const char* data = mapping->Data();
+
+  Header header;
+  std::memcpy(&header, data + 8, sizeof(header));
+  if(header.version != 1 || header.elementSize != sizeof(T)) {
+    throw filePath + " is a binary dataset from an unsupported version or of another type";
+  }
+
+  unsigned long long targetSize = header.format == Regression ? sizeof(double) :
+    sizeof(unsigned int);
+  if(header.format > Patterns || header.numCases > 0xffffffffull ||
+     header.dataOffset % 64 != 0 || header.featureColumnBytes % 64 != 0 ||
+     header.featureColumnBytes < header.numCases * sizeof(T) ||
+     header.targetColumnBytes < header.numCases * targetSize ||
+     header.dataOffset < 8 + sizeof(Header) + header.numSplits * sizeof(BinarySplit) ||
+     header.dataOffset + header.numFeatures * header.featureColumnBytes +
+     header.targetColumnBytes > mapping->Size()) {
+    throw filePath + " is not a valid binary dataset";
+  }
+  if(header.format != static_cast<unsigned int>(format)) {
+    throw filePath + " is a binary dataset in another format (" +
+      (header.format == Regression ? "regression" : "patterns") + ")";
+  }
+
+  numCases = header.numCases;
+
+  for(unsigned int i = 0; i < header.numSplits; ++i) {
+    BinarySplit binary;
+    std::memcpy(&binary, data + 8 + sizeof(Header) + i * sizeof(BinarySplit), sizeof(binary));
+    binary.name[sizeof(binary.name) - 1] = '\0';
+
+    Split split;
+    split.name = binary.name;
+    split.begin = std::min(binary.begin, numCases);
+    split.end = std::min(std::max(binary.end, split.begin), numCases);
+    splits.push_back(split);
+  }
+
+  const char* column = data + header.dataOffset;
+  for(unsigned int i = 0; i < header.numFeatures; ++i, column += header.featureColumnBytes) {
+    featureColumns.push_back(reinterpret_cast<const T*>(column));
+  }
+  if(format == Regression) {
+    targetColumn = reinterpret_cast<const double*>(column);
+  }
+  else {
+    classColumn = reinterpret_cast<const unsigned int*>(column);
+  }
+}
+
+
+
+template <class T>
+void VUWLGP::Dataset<T>::Advise(unsigned int begin, unsigned int end, bool needed) const {
+  if(mapping == 0 || begin >= end) {
+    return;
+  }
+
+  for(unsigned int i = 0; i < featureColumns.size(); ++i) {
+    mapping->Advise(reinterpret_cast<const char*>(featureColumns[i] + begin),
+		    (end - begin) * sizeof(T), needed);
+  }
+  if(format == Regression) {
+    mapping->Advise(reinterpret_cast<const char*>(targetColumn + begin),
+		    (end - begin) * sizeof(double), needed);
+  }
+  else {
+    mapping->Advise(reinterpret_cast<const char*>(classColumn + begin),
+		    (end - begin) * sizeof(unsigned int), needed);
+  }
+}
+
+
+
+template <class T>
+bool VUWLGP::Dataset<T>::ParseNumber(const char*& pos, const char* end, double& value) {
+  static const double powersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  const char* p = pos;
+  bool negative = p != end && *p == '-';
+  if(p != end && (*p == '-' || *p == '+')) { ++p; }
+
+  // Collect up to 19 significant digits, as an integer times a power of ten:
+  unsigned long long mantissa = 0;
+  int significantDigits = 0;
+  int exponent = 0;
+  bool anyDigits = false;
+  bool exact = true; // false if a non-zero digit didn't fit in the mantissa
+
+  for(; p != end && *p >= '0' && *p <= '9'; ++p) {
+    anyDigits = true;
+    if(significantDigits < 19) {
+      mantissa = mantissa * 10 + (*p - '0');
+      significantDigits += mantissa != 0 ? 1 : 0;
+    }
+    else {
+      ++exponent;
+      exact = exact && *p == '0';
+    }
+  }
+
+  if(p != end && *p == '.') {
+    for(++p; p != end && *p >= '0' && *p <= '9'; ++p) {
+      anyDigits = true;
+      if(significantDigits < 19) {
+	mantissa = mantissa * 10 + (*p - '0');
+	significantDigits += mantissa != 0 ? 1 : 0;
+	--exponent;
+      }
+      else {
+	exact = exact && *p == '0';
+      }
+    }
+  }
+
+  if(anyDigits && p != end && (*p == 'e' || *p == 'E')) {
+    const char* e = p + 1;
+    bool negativeExponent = e != end && *e == '-';
+    if(e != end && (*e == '-' || *e == '+')) { ++e; }
+
+    if(e != end && *e >= '0' && *e <= '9') {
+      int explicitExponent = 0;
+      for(; e != end && *e >= '0' && *e <= '9'; ++e) {
+	explicitExponent = std::min(explicitExponent * 10 + (*e - '0'), 100000);
+      }
+      exponent += negativeExponent ? -explicitExponent : explicitExponent;
+      p = e;
+    }
+  }
+
+  // Both the mantissa and the power of ten are exact doubles, so one multiplication or
+  // division rounds correctly:
+  if(anyDigits && exact && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22 &&
+     (p == end || IsSeparator(*p))) {
+    value = exponent < 0 ? mantissa / powersOfTen[-exponent] :
+      mantissa * powersOfTen[exponent];
+    value = negative ? -value : value;
+    pos = p;
+    return true;
+  }
+
+  // Anything else goes to strtod, which needs a null terminated copy:
+  const char* fieldEnd = SkipField(pos, end);
+  char buffer[128];
+  size_t length = fieldEnd - pos;
+  if(length == 0 || length >= sizeof(buffer)) {
+    return false;
+  }
+
+  std::memcpy(buffer, pos, length);
+  buffer[length] = '\0';
+  char* parsedTo;
+  value = std::strtod(buffer, &parsedTo);
+  if(parsedTo != buffer + length) {
+    return false;
+  }
+
+  pos = fieldEnd;
+  return true;
+}
+
+
+
+template <class T>
+const char* VUWLGP::Dataset<T>::SkipSeparators(const char* pos, const char* end) {
+  while(pos != end && IsSeparator(*pos)) { ++pos; }
+  return pos;
+}
+
+
+
+template <class T>
+void VUWLGP::Dataset<T>::CountCases(const char* begin, const char* end, unsigned int& count) {
+  count = 0;
+  for(const char* line = begin; line < end; ) {
+    const char* lineEnd = LineEnd(line, end);
+    count += IsCase(line, lineEnd) ? 1 : 0;
+    line = lineEnd + 1;
+  }
+}
+
+
+
+template <class T>
+void VUWLGP::Dataset<T>::ParseCases(const char* begin, const char* end, unsigned int first,
+				    std::string& error) {
+  unsigned int i = first;
+  for(const char* line = begin; line < end; ) {
+    const char* lineEnd = LineEnd(line, end);
+
+    if(IsCase(line, lineEnd)) {
+      if(!ParseCase(line, lineEnd, i)) {
+	std::ostringstream message;
+	message << "case " << i + 1 << " (\"" << std::string(line, lineEnd) << "\") should be ";
+	if(format == Regression) {
+	  message << features.size() << " features and the target";
+	}
+	else {
+	  message << "the image, x, y, class number, class name and " << features.size()
+		  << " features";
+	}
+	error = message.str();
+	return;
+      }
+      ++i;
+    }
+
+    line = lineEnd + 1;
+  }
+}
+
+
+
+template <class T>
+bool VUWLGP::Dataset<T>::ParseCase(const char* begin, const char* end, unsigned int i) {
+  const char* pos = SkipSeparators(begin, end);
+  double value;
+
+  if(format == Patterns) {
+    for(unsigned int field = 0; field < 3; ++field) { // image, x and y - not kept
+      pos = SkipSeparators(SkipField(pos, end), end);
+    }
+
+    if(!ParseNumber(pos, end, value) || value < 0 ||
+       value != static_cast<unsigned int>(value)) {
+      return false;
+    }
+    classes[i] = static_cast<unsigned int>(value);
+
+    pos = SkipSeparators(SkipField(SkipSeparators(pos, end), end), end); // class name
+  }
+
+  for(unsigned int f = 0; f < features.size(); ++f) {
+    if(!ParseNumber(pos, end, value)) {
+      return false;
+    }
+    features[f][i] = static_cast<T>(value);
+    pos = SkipSeparators(pos, end);
+  }
+
+  if(format == Regression) {
+    if(!ParseNumber(pos, end, targets[i])) {
+      return false;
+    }
+    pos = SkipSeparators(pos, end);
+  }
+
+  return pos == end;
+}
+#endif
@@ -0,0 +1,106 @@
+// lgpdataset - converts a text dataset (see Dataset.h) into the binary format, which is opened
+// with no copying or parsing, optionally recording splits of its cases.
+//
+// Usage: lgpdataset <input> <output> [regression|patterns] [double|float] [<split> ...]
+//
+// where each split is name:begin:end, a range [begin, end) of case numbers which can also be
+// given as percentages of the cases, e.g. train:0:80% test:80%:100%. The element type must
+// match the program which will use the dataset (the console application uses double).
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Dataset.h"
+
+using namespace VUWLGP;
+
+// Returns the case number (or percentage of numCases) text gives.
+static unsigned int CaseNumber(const std::string& text, unsigned int numCases) {
+	char* end;
+	double value = std::strtod(text.c_str(), &end);
+	if (end == text.c_str() || value < 0 || (*end != '\0' && std::string(end) != "%")) {
+		throw "Invalid case number: " + text;
+	}
+
+	if (*end == '%') {
+		value = value / 100 * numCases + 0.5;
+	}
+	return static_cast<unsigned int>(value);
+}
+
+// Converts argv[1] to argv[2] as a dataset of T, with the splits given from argv[first].
+template <class T> static void Convert(char** argv, typename Dataset<T>::Format format,
+	int argc, int first) {
+	Dataset<T> data(argv[1], format, std::thread::hardware_concurrency());
+
+	std::vector<typename Dataset<T>::Split> splits;
+	for (int i = first; i < argc; ++i) {
+		std::string arg = argv[i];
+		std::string::size_type colon1 = arg.find(':');
+		std::string::size_type colon2 = arg.find(':', colon1 + 1);
+		if (colon1 == std::string::npos || colon2 == std::string::npos) {
+			throw "Splits should be name:begin:end, not " + arg;
+		}
+
+		typename Dataset<T>::Split split;
+		split.name = arg.substr(0, colon1);
+		split.begin = CaseNumber(arg.substr(colon1 + 1, colon2 - colon1 - 1), data.NumberOfCases());
+		split.end = CaseNumber(arg.substr(colon2 + 1), data.NumberOfCases());
+		splits.push_back(split);
+	}
+
+	data.Save(argv[2], splits);
+
+	std::cout << "Wrote " << data.NumberOfCases() << " cases of " << data.NumberOfFeatures()
+		<< " features to " << argv[2] << std::endl;
+	for (unsigned int i = 0; i < splits.size(); ++i) {
+		std::cout << "  " << splits[i].name << ": cases " << splits[i].begin << " to "
+			<< splits[i].end << std::endl;
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc < 3) {
+		std::cerr << "Usage: " << argv[0] << " <input> <output> [regression|patterns] "
+			<< "[double|float] [<name>:<begin>:<end> ...]" << std::endl;
+		return 1;
+	}
+
+	// The optional format and element type come before the splits:
+	int first = 3;
+	bool patterns = false;
+	bool singlePrecision = false;
+	for (; first < argc && std::string(argv[first]).find(':') == std::string::npos; ++first) {
+		std::string arg = argv[first];
+		if (arg == "patterns" || arg == "regression") {
+			patterns = arg == "patterns";
+		}
+		else if (arg == "float" || arg == "double") {
+			singlePrecision = arg == "float";
+		}
+		else {
+			std::cerr << "Unknown option " << arg << std::endl;
+			return 1;
+		}
+	}
+
+	try {
+		if (singlePrecision) {
+			Convert<float>(argv, patterns ? Dataset<float>::Patterns : Dataset<float>::Regression,
+				argc, first);
+		}
+		else {
+			Convert<double>(argv, patterns ? Dataset<double>::Patterns :
+				Dataset<double>::Regression, argc, first);
+		}
+	}
+	catch (const std::string& e) {
+		std::cerr << e << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
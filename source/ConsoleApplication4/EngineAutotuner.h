@@ -0,0 +1,236 @@
+
+  
+#ifndef ENGINEAUTOTUNER_H
+#define ENGINEAUTOTUNER_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Config.h"
+#include "FitnessEnvironment.h"
+#include "KernelDispatch.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace VUWLGP {
+  // The choices IPopulation::Autotune makes between ways of evaluating a generation - the
+  // evaluation engine, tile size and number of threads - for one machine and problem, and
+  // the tuning cache they are kept in between runs (Config::tuningCacheFilePath). The cache
+  // is a text file of one decision per line: the key, a tab, then the engine, tile size and
+  // number of threads separated by spaces. Later lines replace earlier ones with the same key.
+  template <class T> class EngineAutotuner {
+  public:
+    struct Setting {
+      std::string engine;
+      unsigned int tileSize;
+      unsigned int numThreads;
+
+      // e.g. "batch, tile size 0, 4 threads"
+      std::string ToString() const;
+    };
+
+    // Keys the decision by the machine - its host name, number of hardware threads and
+    // KernelDispatch level - and the shape of the problem: the register type, the numbers of
+    // cases in fe, features, registers and operations, and the population and program sizes
+    // and evaluation settings in conf which the tuning doesn't change.
+    EngineAutotuner(const Config<T>* conf, const FitnessEnvironment<T>& fe,
+		    unsigned int populationSize);
+    // Default cctor, dtor
+
+    const std::string& Key() const { return key; }
+
+    // Reads the decision for the key from the cache into setting. Returns false if there
+    // isn't one, or no cache.
+    bool Load(Setting& setting) const;
+
+    // Appends setting to the cache as the decision for the key, if there is a cache. Throws
+    // a std::string if it can't be written.
+    void Save(const Setting& setting) const;
+
+    // The candidates for each part of the setting, in the order they are tried: every engine
+    // which evaluates whole generations (with "compiled" only if conf has a
+    // programCompiler), no tiles and tiles of 256 to 4096 cases (those smaller than the
+    // dataset), and 1 thread doubling up to the number of hardware threads.
+    std::vector<std::string> Engines() const;
+    std::vector<unsigned int> TileSizes() const;
+    std::vector<unsigned int> ThreadCounts() const;
+
+    // Returns the setting conf evaluates with, with "auto" resolved to the engine it means
+    // for fe (see IPopulation::UsesLockstep) and 0 threads to the number of hardware threads.
+    static Setting Current(const Config<T>* conf, const FitnessEnvironment<T>& fe);
+
+    // Makes conf evaluate with setting.
+    static void Apply(const Setting& setting, Config<T>* conf);
+
+  private:
+    // Returns the host name, or "unknown" if it isn't available.
+    static std::string HostName();
+
+    const Config<T>* config;
+    unsigned int numCases;
+    std::string key;
+  };
+}
+
+
+
+////////////////////////////////// Inline Function Definitions /////////////////////////////////
+template <class T>
+std::string VUWLGP::EngineAutotuner<T>::Setting::ToString() const {
+  std::ostringstream buffer;
+  buffer << engine << ", tile size " << tileSize << ", " << numThreads
+	 << (numThreads == 1 ? " thread" : " threads");
+  return buffer.str();
+}
+
+
+
+template <class T>
+VUWLGP::EngineAutotuner<T>::EngineAutotuner(const VUWLGP::Config<T>* conf,
+					    const VUWLGP::FitnessEnvironment<T>& fe,
+					    unsigned int populationSize):
+config(conf),
+numCases(fe.NumberOfCases()) {
+  std::ostringstream buffer;
+  buffer << "host=" << HostName() << " hardwareThreads=" << std::thread::hardware_concurrency()
+	 << " kernels=" << KernelDispatch::Name(KernelDispatch::Selected())
+	 << " registerBytes=" << sizeof(T) << " cases=" << numCases
+	 << " features=" << conf->numFeatures << " registers=" << conf->numRegisters
+	 << " operations=" << conf->instructionOperations->NumberOfElements()
+	 << " population=" << populationSize << " initialLength=" << conf->initialMinLength
+	 << "-" << conf->initialMaxLength << " maxLength=" << conf->maxLength
+	 << " chunkSize=" << conf->evaluationChunkSize
+	 << " programBatch=" << conf->evaluationProgramBatch;
+  key = buffer.str();
+}
+
+
+
+template <class T>
+bool VUWLGP::EngineAutotuner<T>::Load(Setting& setting) const {
+  if(config->tuningCacheFilePath.empty()) {
+    return false;
+  }
+
+  std::ifstream fin(config->tuningCacheFilePath.c_str());
+  bool found = false;
+  std::string line;
+  while(std::getline(fin, line)) {
+    std::string::size_type tab = line.rfind('\t');
+    if(tab == std::string::npos || line.substr(0, tab) != key) {
+      continue;
+    }
+
+    std::istringstream conv(line.substr(tab + 1));
+    Setting cached;
+    if(conv >> cached.engine >> cached.tileSize >> cached.numThreads) {
+      setting = cached;
+      found = true;
+    }
+  }
+  return found;
+}
+
+
+
+template <class T>
+void VUWLGP::EngineAutotuner<T>::Save(const Setting& setting) const {
+  if(config->tuningCacheFilePath.empty()) {
+    return;
+  }
+
+  std::ofstream fout(config->tuningCacheFilePath.c_str(), std::ios::out | std::ios::app);
+  fout << key << "\t" << setting.engine << " " << setting.tileSize << " "
+       << setting.numThreads << std::endl;
+  if(!fout) {
+    throw "EngineAutotuner::Save - could not write " + config->tuningCacheFilePath;
+  }
+}
+
+
+
+template <class T>
+std::vector<std::string> VUWLGP::EngineAutotuner<T>::Engines() const {
+  std::vector<std::string> engines;
+  engines.push_back("interpreter");
+  engines.push_back("lockstep");
+  engines.push_back("plan");
+  if(config->programCompiler) {
+    engines.push_back("compiled");
+  }
+  engines.push_back("batch");
+  return engines;
+}
+
+
+
+template <class T>
+std::vector<unsigned int> VUWLGP::EngineAutotuner<T>::TileSizes() const {
+  std::vector<unsigned int> sizes(1, 0);
+  for(unsigned int size = 256; size <= 4096 && size < numCases; size *= 4) {
+    sizes.push_back(size);
+  }
+  return sizes;
+}
+
+
+
+template <class T>
+std::vector<unsigned int> VUWLGP::EngineAutotuner<T>::ThreadCounts() const {
+  unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<unsigned int> counts;
+  for(unsigned int count = 1; count < hardwareThreads; count *= 2) {
+    counts.push_back(count);
+  }
+  counts.push_back(hardwareThreads);
+  return counts;
+}
+
+
+
+template <class T>
+typename VUWLGP::EngineAutotuner<T>::Setting
+VUWLGP::EngineAutotuner<T>::Current(const VUWLGP::Config<T>* conf,
+				    const VUWLGP::FitnessEnvironment<T>& fe) {
+  Setting setting;
+  setting.engine = conf->EvaluationEngineFor(fe.NumberOfCases());
+  setting.tileSize = conf->evaluationTileSize;
+  setting.numThreads = conf->NumberOfThreads();
+  return setting;
+}
+
+
+
+template <class T>
+void VUWLGP::EngineAutotuner<T>::Apply(const Setting& setting, VUWLGP::Config<T>* conf) {
+  conf->evaluationEngine = setting.engine;
+  conf->evaluationTileSize = setting.tileSize;
+  conf->numThreads = setting.numThreads;
+}
+
+
+
+template <class T>
+std::string VUWLGP::EngineAutotuner<T>::HostName() {
+#ifndef _WIN32
+  char name[256];
+  if(gethostname(name, sizeof(name)) == 0) {
+    name[sizeof(name) - 1] = '\0';
+    return name;
+  }
+#else
+  const char* name = std::getenv("COMPUTERNAME");
+  if(name != 0) {
+    return name;
+  }
+#endif
+  return "unknown";
+}
+#endif
@@ -0,0 +1,152 @@
+
+  
+#ifndef EVALUATIONPOOL_H
+#define EVALUATIONPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FitnessEnvironment.h"
+#include "IProgram.h"
+
+namespace VUWLGP {
+  // A fixed set of worker threads which update the fitness of the programs submitted to them,
+  // each against its own FitnessEnvironment sharing the cases of the one the pool was built
+  // with. Evaluation doesn't use the random number generator, so programs get exactly the same
+  // fitnesses as they would if they were evaluated serially, in any order.
+  template <class T> class EvaluationPool {
+  public:
+    // fe must outlive the pool.
+    EvaluationPool(const FitnessEnvironment<T>& fe, unsigned int numThreads);
+    ~EvaluationPool(); // finishes the programs already submitted before returning
+
+    // Queues prog to have its fitness updated. The caller keeps ownership of prog, but must
+    // not use or delete it until Wait has returned.
+    void Submit(IProgram<T>* prog);
+
+    // Blocks until every program submitted so far has been evaluated. Rethrows the first
+    // std::string a worker caught while evaluating, if any.
+    void Wait();
+
+    unsigned int NumberOfThreads() const { return workers.size(); }
+
+  private:
+    EvaluationPool(const EvaluationPool<T>& rhs); // not copyable
+    EvaluationPool<T>& operator=(const EvaluationPool<T>& rhs);
+
+    void Work();
+
+    const FitnessEnvironment<T>& sharedFe;
+    std::vector<std::thread> workers;
+
+    // Only accessed while holding lock:
+    std::mutex lock;
+    std::condition_variable workAvailable;
+    std::condition_variable workFinished;
+    std::deque<IProgram<T>*> queue;
+    unsigned int outstanding; // submitted but not yet evaluated
+    std::string error;
+    bool stopping;
+  };
+}
+
+
+
+////////////////////////////////// Inline Function Definitions /////////////////////////////////
+template <class T>
+VUWLGP::EvaluationPool<T>::EvaluationPool(const VUWLGP::FitnessEnvironment<T>& fe,
+					   unsigned int numThreads):
+sharedFe(fe),
+outstanding(0),
+stopping(false) {
+  for(unsigned int i = 0; i < numThreads || i == 0; ++i) {
+    workers.push_back(std::thread(&EvaluationPool<T>::Work, this));
+  }
+}
+
+
+
+template <class T>
+VUWLGP::EvaluationPool<T>::~EvaluationPool() {
+  {
+    std::unique_lock<std::mutex> guard(lock);
+    stopping = true;
+  }
+  workAvailable.notify_all();
+
+  for(unsigned int i = 0; i < workers.size(); ++i) {
+    workers[i].join();
+  }
+}
+
+
+
+template <class T>
+void VUWLGP::EvaluationPool<T>::Submit(VUWLGP::IProgram<T>* prog) {
+  {
+    std::unique_lock<std::mutex> guard(lock);
+    queue.push_back(prog);
+    ++outstanding;
+  }
+  workAvailable.notify_one();
+}
+
+
+
+template <class T>
+void VUWLGP::EvaluationPool<T>::Wait() {
+  std::unique_lock<std::mutex> guard(lock);
+  while(outstanding != 0) {
+    workFinished.wait(guard);
+  }
+
+  if(!error.empty()) {
+    std::string e = error;
+    error.clear();
+    throw e;
+  }
+}
+
+
+
+template <class T>
+void VUWLGP::EvaluationPool<T>::Work() {
+  FitnessEnvironment<T> localFe(sharedFe);
+
+  std::unique_lock<std::mutex> guard(lock);
+  while(true) {
+    while(queue.empty() && !stopping) {
+      workAvailable.wait(guard);
+    }
+
+    if(queue.empty()) { // and so stopping
+      return;
+    }
+
+    IProgram<T>* prog = queue.front();
+    queue.pop_front();
+
+    guard.unlock();
+    std::string caught;
+    try {
+      prog->UpdateFitness(localFe);
+    }
+    catch(const std::string& e) {
+      caught = e;
+    }
+    guard.lock();
+
+    if(!caught.empty() && error.empty()) {
+      error = caught;
+    }
+
+    if(--outstanding == 0) {
+      workFinished.notify_all();
+    }
+  }
+}
+#endif
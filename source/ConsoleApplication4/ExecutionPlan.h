@@ -0,0 +1,1124 @@
+
+  
+#ifndef EXECUTIONPLAN_H
+#define EXECUTIONPLAN_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Config.h"
+#include "FitnessEnvironment.h"
+#include "ICompiledProgram.h"
+#include "IProgram.h"
+#include "Instruction.h"
+#include "InstructionArgumentConstant.h"
+#include "InstructionOperationDiv.h"
+#include "InstructionOperationIflt.h"
+#include "InstructionOperationMinus.h"
+#include "InstructionOperationMult.h"
+#include "InstructionOperationPlus.h"
+
+namespace VUWLGP {
+  // A program's effective (non-intron) code compiled into a compact list of steps, which
+  // evaluators can run without the interpreter's virtual calls and which passes such as
+  // FoldConstants rewrite into an equivalent, shorter plan. Every operand and destination is
+  // a slot: the registers come first, then the features, then the plan's constants, so a
+  // plan is run on a bank of slots holding the case's features and the plan's constants, with
+  // the registers zeroed (see Execute).
+  //
+  // The operations are those of the built in instruction set (+, -, *, protected / and if<),
+  // computed exactly as their classes compute them, plus copies, which passes introduce, and
+  // superinstructions, which Fuse makes of pairs of steps for plans which are executed. The
+  // passes only make changes which leave the outputs - the final values of the registers the
+  // program's fitness measure reads (see IProgram::NumberOfOutputs) - exactly as they were,
+  // so a plan's fitnesses are the same as the interpreter's, unless
+  // Config::assumeFiniteValues allows changes which only hold for finite values. The other
+  // registers' final values are unspecified. Programs with other operations (see CanCompile)
+  // can't be compiled.
+  template <class T> class ExecutionPlan: public ICompiledProgram<T> {
+  public:
+    // The superinstructions follow the basic operations: OpIfltPlus to OpIfltCopy are
+    // assignments guarded by a conditional, on third < fourth, OpMultPlus is first * second
+    // + third, OpMultMinus is first * second - third, and OpPlusMult and OpMinusMult are
+    // (first + second) * third and (first - second) * third.
+    enum Opcode { OpPlus, OpMinus, OpMult, OpDiv, OpIflt, OpCopy,
+		  OpIfltPlus, OpIfltMinus, OpIfltMult, OpIfltDiv, OpIfltCopy,
+		  OpMultPlus, OpMultMinus, OpPlusMult, OpMinusMult, NumberOfOpcodes };
+
+    // A step writes the result of opcode on its first and second operand to its destination,
+    // or for a conditional skips to after the next assignment if its condition is false.
+    // Copies only use their first operand, and only superinstructions use the third and
+    // fourth.
+    struct Step {
+      unsigned char opcode;
+      unsigned short destination;
+      unsigned short first;
+      unsigned short second;
+      unsigned short third;
+      unsigned short fourth;
+    };
+
+    // Compiles the effective instructions of prog, whose introns must be marked and of which
+    // CanCompile must be true. The plan doesn't refer to prog once it is built.
+    ExecutionPlan(const IProgram<T>& prog, const Config<T>* conf);
+    // Default cctor, dtor
+
+    // Runs the passes conf enables (see Config::foldConstants, Config::eliminateRedundancy
+    // and Config::renameRegisters).
+    void Optimise(const Config<T>* conf);
+
+    // Evaluates every step whose operands are known before any case is seen - registers start
+    // at 0 and constants are constant - and propagates the results through the registers, so
+    // that e.g. r[0] = 0.5 - 0.25; r[1] = r[0] * cf[0]; becomes r[1] = 0.25 * cf[0]; with r[0]
+    // only set once, at the end. Conditionals with known operands, and x < x, which is always
+    // false, are resolved, dropping the assignment they guard if they are false. Identities
+    // which hold for every value (x + 0, x - 0, x * 1, x / 1, and x / 0, which is 0 as
+    // division is protected) are simplified, and if assumeFinite is set so are those which
+    // only hold for finite values (x - x, x * 0 and 0 / x). x / x is 0 when x is, so it isn't
+    // simplified. Steps which then no longer affect the final registers are removed (see
+    // RemoveDeadSteps).
+    void FoldConstants(bool assumeFinite);
+
+    // Numbers the values the steps compute - two steps compute the same value if they apply
+    // the same operation to the same values, taking + and * to be commutative - and rewrites
+    // each step which computes a value some slot already holds as a copy of that slot, and
+    // every operand to read the first slot holding its value, so copy chains are read from
+    // their source. Steps which leave their register as it is (e.g. r[1] = r[2] + r[3]; when
+    // r[1] already holds that) and conditionals comparing a value with itself are dropped,
+    // guards and all. A step which conditionals guard leaves its register holding one of two
+    // values, so it is taken to hold a new one. Steps which then no longer affect the final
+    // registers are removed.
+    void EliminateRedundancy();
+
+    // Renames the registers so the plan uses as few as it can: each value a register holds is
+    // given the lowest register which holds nothing else needed while it is needed, except
+    // that the outputs stay in their own registers. A guarded assignment's value goes in the
+    // same register as the one it might leave in place. NumberOfRegisters then returns the
+    // number used, and the features and constants follow them, so evaluators can keep fewer
+    // register values per program and case. The plan is left as it is if no register can
+    // be saved. Copies of a register to itself, which renaming can leave, are then removed
+    // along with the conditionals guarding them.
+    void RenameRegisters();
+
+    // Replaces each pair of steps which makes up one of the superinstructions for which
+    // superinstructions (indexed by opcode) is true with it, so executing the plan dispatches
+    // fewer steps: a conditional and the assignment it guards, and an arithmetic step whose
+    // result the next step (an unguarded assignment to the same register) multiplies, adds
+    // to or subtracts from one other value. Each superinstruction rounds as the two steps
+    // would - the multiply-adds are not FMAs - so the outputs stay exactly the same. The
+    // other passes and the LockstepEvaluator only handle basic steps, so this must be the
+    // last pass, and only for plans which are executed (see Execute and Evaluate).
+    void Fuse(const std::vector<bool>& superinstructions);
+
+    // Removes the steps which can't affect the outputs, as IProgram::MarkIntrons marks
+    // instructions (but with only the outputs needed at the end).
+    void RemoveDeadSteps();
+
+    // Removes the approximate semantic introns - the steps which can affect the outputs but
+    // don't on the cases in fe's window, or only by tolerance (relative to the output, or
+    // absolute for outputs smaller than 1). Each assignment is
+    // tried without its guards and then without itself and its guards, in order, keeping
+    // each change which leaves every output within tolerance of what the whole plan gives.
+    // The state of every case before the step being tried is kept, so each try only runs the
+    // rest of the plan, and stops at the first case it changes too much. Unlike the other
+    // passes, this one changes what the plan computes on other cases, and can only be as
+    // good a guide as fe's cases are.
+    void RemoveSemanticIntrons(FitnessEnvironment<T>& fe, T tolerance);
+
+    // Runs the plan on slots, whose registers must be zeroed and whose features and
+    // constants must be loaded (see FirstFeatureSlot and FirstConstantSlot).
+    void Execute(T* slots) const { Execute(0, steps.size(), slots); }
+
+    // Sets prog's fitness to its error on the cases in fe's window as this plan computes
+    // its outputs, e.g. to score a plan which approximates prog. The fitness isn't marked
+    // correct, as the plan might not compute what prog does.
+    void Evaluate(IProgram<T>& prog, FitnessEnvironment<T>& fe) const;
+
+    // Adds prog's error on the cases in fe's window as this plan computes its outputs to its
+    // fitness, as IProgram::AccumulateError does.
+    void AccumulateError(IProgram<T>& prog, FitnessEnvironment<T>& fe) const;
+
+    unsigned int NumberOfSteps() const { return steps.size(); }
+    const Step& StepAt(unsigned int i) const { return steps[i]; }
+
+    // Returns the number of registers the plan uses, which RenameRegisters can make fewer
+    // than the program's, the first NumberOfOutputs of which are the outputs.
+    unsigned int NumberOfRegisters() const { return numRegisters; }
+    unsigned int NumberOfOutputs() const { return numOutputs; }
+    unsigned int FirstFeatureSlot() const { return numRegisters; }
+    unsigned int FirstConstantSlot() const { return numRegisters + numFeatures; }
+    unsigned int NumberOfSlots() const { return FirstConstantSlot() + constants.size(); }
+    const std::vector<T>& Constants() const { return constants; }
+
+    static bool IsConditional(unsigned int opcode) { return opcode == OpIflt; }
+
+    // Returns the result of an assignment step, as the operation's class computes it.
+    static T Apply(unsigned int opcode, T first, T second) {
+      return opcode == OpPlus ? first + second :
+	opcode == OpMinus ? first - second :
+	opcode == OpMult ? first * second :
+	opcode == OpDiv ? (second != 0 ? first / second : 0) :
+	first;
+    }
+
+    // Sets parts to the steps which superinstruction step was made of (or just step, if it
+    // isn't one) and returns how many there are.
+    static unsigned int Unfuse(const Step& step, Step* parts);
+
+    // Returns true if every effective instruction of prog uses one of the operations a plan
+    // can execute. prog's introns must be marked.
+    static bool CanCompile(const IProgram<T>& prog);
+
+    // Returns the plan as a C++ function, in the form IProgram::ToString writes programs, e.g.
+    // for deploying an evolved program. Constants are written with enough digits to read
+    // back exactly, and superinstructions as the steps they were made of.
+    std::string ToString() const;
+
+  private:
+    // Returns the opcode of op, or -1 if a plan can't execute it.
+    static int OpcodeOf(const IInstructionOperation<T>* op);
+
+    // Returns the slot of arg, adding it to the constants if it is one.
+    unsigned short SlotOf(const IInstructionArgument<T>* arg);
+
+    // Returns the slot of a constant with exactly value's bits, adding one if there isn't one.
+    unsigned short ConstantSlot(T value);
+
+    // Removes the constants which no steps use, renumbering the rest.
+    void DropUnusedConstants();
+
+    // Returns the first slot which holds value (the feature or constant whose slot it is, or
+    // else the lowest register), given the value each slot holds, or -1 if none does.
+    int HolderOf(const std::vector<unsigned int>& values, unsigned int value) const;
+
+    bool IsConstantSlot(unsigned int slot) const { return slot >= FirstConstantSlot(); }
+    T ConstantAt(unsigned int slot) const { return constants[slot - FirstConstantSlot()]; }
+
+    // Rewrites the assignment step as a copy if its result is always one of its operands, or
+    // a copy of a constant if its result is always the same.
+    void Simplify(Step& step, bool assumeFinite);
+
+    static Step Copy(unsigned int destination, unsigned int source) {
+      Step step = { OpCopy, static_cast<unsigned short>(destination),
+		    static_cast<unsigned short>(source), static_cast<unsigned short>(source),
+		    0, 0 };
+      return step;
+    }
+
+    // Sets fused to the superinstruction step and next (which follows it) make up, if they
+    // make one up, and returns true if they do. guarded is true if a conditional guards step.
+    static bool FusePair(const Step& step, const Step& next, bool guarded, Step& fused);
+
+
+    static bool SameBits(T left, T right) {
+      return std::memcmp(&left, &right, sizeof(T)) == 0;
+    }
+
+    // Runs steps [begin, end) on slots, starting at an assignment or its guards.
+    void Execute(unsigned int begin, unsigned int end, T* slots) const;
+
+    // Returns true if each case's outputs are within tolerance of expected (see
+    // RemoveSemanticIntrons) when steps [from, end) are run on a copy of its slots.
+    bool OutputsWithin(const std::vector<std::vector<T> >& cases,
+		       const std::vector<T>& expected, unsigned int from, T tolerance) const;
+
+    // Returns the first web of the set of webs (see RenameRegisters) web is in.
+    static unsigned int FirstWeb(std::vector<unsigned int>& joined, unsigned int web);
+
+    std::string SlotToString(unsigned int slot) const;
+
+    unsigned int numRegisters;
+    unsigned int numFeatures;
+    unsigned int numOutputs;
+    unsigned int programRegisters; // the program's numRegisters
+    std::vector<Step> steps;
+    std::vector<T> constants;
+  };
+}
+
+
+
+////////////////////////////////// Inline Function Definitions /////////////////////////////////
+template <class T>
+VUWLGP::ExecutionPlan<T>::ExecutionPlan(const VUWLGP::IProgram<T>& prog,
+					const VUWLGP::Config<T>* conf):
+numRegisters(conf->numRegisters),
+numFeatures(conf->numFeatures),
+numOutputs(prog.NumberOfOutputs()),
+programRegisters(conf->numRegisters) {
+  const std::vector<Instruction<T>*>& instrs = prog.ConstRawAccessToTheInternalInstructions();
+  for(unsigned int i = 0; i < instrs.size(); ++i) {
+    if(instrs[i]->IsIntron) {
+      continue;
+    }
+
+    Step step;
+    step.opcode = OpcodeOf(instrs[i]->Operation());
+    step.destination = instrs[i]->DestinationIndex();
+    step.first = SlotOf(instrs[i]->FirstArgument());
+    step.second = SlotOf(instrs[i]->SecondArgument());
+    step.third = step.fourth = 0;
+    steps.push_back(step);
+  }
+}
+
+
+
+template <class T>
+void VUWLGP::ExecutionPlan<T>::Optimise(const VUWLGP::Config<T>* conf) {
+  if(conf->foldConstants) {
+    FoldConstants(conf->assumeFiniteValues);
+  }
+  if(conf->eliminateRedundancy) {
+    EliminateRedundancy();
+  }
+  if(conf->renameRegisters) {
+    RenameRegisters();
+  }
+}
+
+
+
+template <class T>
+void VUWLGP::ExecutionPlan<T>::FoldConstants(bool assumeFinite) {
+  // What is known about each register: whether its value is known (and if so what it is),
+  // and whether the register actually holds it yet, or setting it has been left until the
+  // value is needed in the register itself:
+  std::vector<bool> known(numRegisters, true);
+  std::vector<bool> held(numRegisters, true);
+  std::vector<T> values(numRegisters, 0);
+
+  std::vector<Step> folded;
+  for(unsigned int i = 0; i < steps.size(); ) {
+    // Each assignment and the conditionals guarding it are taken together. Known operands
+    // are replaced by constants, conditionals known to be true dropped, and the whole lot
+    // dropped if one is known to be false:
+    std::vector<Step> guards;
+    bool skipped = false;
+    for(; i < steps.size() && IsConditional(steps[i].opcode); ++i) {
+      Step guard = steps[i];
+      if(guard.first < numRegisters && known[guard.first]) {
+	guard.first = ConstantSlot(values[guard.first]);
+      }
+      if(guard.second < numRegisters && known[guard.second]) {
+	guard.second = ConstantSlot(values[guard.second]);
+      }
+
+      // x < x is false whatever x is:
+      if(guard.first == guard.second) {
+	skipped = true;
+      }
+      else if(!IsConstantSlot(guard.first) || !IsConstantSlot(guard.second)) {
+	guards.push_back(guard);
+      }
+      else if(!(ConstantAt(guard.first) < ConstantAt(guard.second))) {
+	skipped = true;
+      }
+    }
+
+    if(i == steps.size()) { // trailing conditionals guard nothing
+      break;
+    }
+    Step step = steps[i++];
+    if(skipped) {
+      continue;
+    }
+    if(step.first < numRegisters && known[step.first]) {
+      step.first = ConstantSlot(values[step.first]);
+    }
+    if(step.second < numRegisters && known[step.second]) {
+      step.second = ConstantSlot(values[step.second]);
+    }
+    Simplify(step, assumeFinite);
+
+    // Steps which leave the register as it is can go, whether they are guarded or not:
+    unsigned int dest = step.destination;
+    bool constant = step.opcode == OpCopy && IsConstantSlot(step.first);
+    if((constant && known[dest] && SameBits(ConstantAt(step.first), values[dest])) ||
+       (step.opcode == OpCopy && step.first == dest)) {
+      continue;
+    }
+
+    if(guards.empty() && constant) {
+      known[dest] = true;
+      held[dest] = false;
+      values[dest] = ConstantAt(step.first);
+      continue;
+    }
+
+    // The register must hold its value if the guards might skip the step:
+    if(!guards.empty() && known[dest] && !held[dest]) {
+      folded.push_back(Copy(dest, ConstantSlot(values[dest])));
+    }
+    folded.insert(folded.end(), guards.begin(), guards.end());
+    folded.push_back(step);
+    known[dest] = false;
+  }
+
+  // The registers which were never set have to be, at the end:
+  for(unsigned int r = 0; r < numRegisters; ++r) {
+    if(known[r] && !held[r]) {
+      folded.push_back(Copy(r, ConstantSlot(values[r])));
+    }
+  }
+
+  steps.swap(folded);
+  RemoveDeadSteps();
+  DropUnusedConstants();
+}
+
+
+
+template <class T>
+void VUWLGP::ExecutionPlan<T>::EliminateRedundancy() {
+  // The value each slot holds: the features and constants are their slots' numbers, and the
+  // registers start as zero, which is the value of the +0 constant if there is one:
+  std::vector<unsigned int> values(NumberOfSlots());
+  unsigned int zero = values.size();
+  for(unsigned int slot = 0; slot < values.size(); ++slot) {
+    values[slot] = slot;
+    if(IsConstantSlot(slot) && SameBits(ConstantAt(slot), 0)) {
+      zero = slot;
+    }
+  }
+  for(unsigned int r = 0; r < numRegisters; ++r) {
+    values[r] = zero;
+  }
+  unsigned int nextValue = values.size() + 1;
+
+  // The value of each operation applied so far, by its opcode and operands' values:
+  typedef std::pair<unsigned int, std::pair<unsigned int, unsigned int> > Expression;
+  std::map<Expression, unsigned int> computed;
+
+  std::vector<Step> rewritten;
+  for(unsigned int i = 0; i < steps.size(); ) {
+    // As in FoldConstants, each assignment is taken together with its guards:
+    std::vector<Step> guards;
+    bool skipped = false;
+    for(; i < steps.size() && IsConditional(steps[i].opcode); ++i) {
+      Step guard = steps[i];
+      guard.first = HolderOf(values, values[guard.first]);
+      guard.second = HolderOf(values, values[guard.second]);
+      skipped = skipped || guard.first == guard.second;
+      guards.push_back(guard);
+    }
+
+    if(i == steps.size()) { // trailing conditionals guard nothing
+      break;
+    }
+    Step step = steps[i++];
+    if(skipped) {
+      continue;
+    }
+    step.first = HolderOf(values, values[step.first]);
+    step.second = HolderOf(values, values[step.second]);
+
+    unsigned int value = values[step.first];
+    if(step.opcode != OpCopy) {
+      unsigned int first = values[step.first];
+      unsigned int second = values[step.second];
+      if((step.opcode == OpPlus || step.opcode == OpMult) && second < first) {
+	std::swap(first, second);
+      }
+      Expression expression(step.opcode, std::make_pair(first, second));
+      typename std::map<Expression, unsigned int>::iterator found = computed.find(expression);
+      if(found == computed.end()) {
+	value = computed[expression] = nextValue++;
+      }
+      else {
+	value = found->second;
+	int holder = HolderOf(values, value);
+	if(holder >= 0) {
+	  step = Copy(step.destination, holder);
+	}
+      }
+    }
+
+    if(values[step.destination] == value) {
+      continue;
+    }
+    rewritten.insert(rewritten.end(), guards.begin(), guards.end());
+    rewritten.push_back(step);
+    values[step.destination] = guards.empty() ? value : nextValue++;
+  }
+
+  steps.swap(rewritten);
+  RemoveDeadSteps();
+  DropUnusedConstants();
+}
+
+
+
+template <class T>
+void VUWLGP::ExecutionPlan<T>::DropUnusedConstants() {
+  std::vector<T> used;
+  std::vector<int> renumbered(constants.size(), -1);
+  for(unsigned int i = 0; i < steps.size(); ++i) {
+    unsigned short* operands[2] = { &steps[i].first, &steps[i].second };
+    for(unsigned int j = 0; j < 2; ++j) {
+      if(IsConstantSlot(*operands[j])) {
+	int& slot = renumbered[*operands[j] - FirstConstantSlot()];
+	if(slot < 0) {
+	  slot = FirstConstantSlot() + used.size();
+	  used.push_back(ConstantAt(*operands[j]));
+	}
+	*operands[j] = slot;
+      }
+    }
+  }
+  constants.swap(used);
+}
+
+
+
+template <class T>
+void VUWLGP::ExecutionPlan<T>::RenameRegisters() {
+  // The values the registers hold form webs: each register's initial 0 is one, web r, and
+  // each assignment's result another, web numRegisters + i for step i - except that a
+  // guarded assignment's result joins the web of the value it might leave in place, as both
+  // must be in the same register. reaching is the web each register holds as the steps go:
+  std::vector<unsigned int> joined(numRegisters + steps.size());
+  std::vector<unsigned int> reaching(numRegisters);
+  for(unsigned int web = 0; web < joined.size(); ++web) {
+    joined[web] = web;
+  }
+  for(unsigned int r = 0; r < numRegisters; ++r) {
+    reaching[r] = r;
+  }
+
+  // Where each set of webs is needed, from its first web being set to its last use. Step i
+  // reads at 2i + 1 and writes at 2i + 2, so a register read by a step can take its result,
+  // and the outputs are read at the end. The registers' initial values are set at 0:
+  std::vector<unsigned int> firstWebs(steps.size());
+  std::vector<unsigned int> secondWebs(steps.size());
+  std::vector<unsigned int> lastUse(joined.size(), 0);
+  std::vector<bool> needed(joined.size(), false);
+  for(unsigned int i = 0; i < steps.size(); ++i) {
+    const Step& step = steps[i];
+    if(step.first < numRegisters) {
+      firstWebs[i] = FirstWeb(joined, reaching[step.first]);
+      lastUse[firstWebs[i]] = 2 * i + 1;
+      needed[firstWebs[i]] = true;
+    }
+    if(step.second < numRegisters) {
+      secondWebs[i] = FirstWeb(joined, reaching[step.second]);
+      lastUse[secondWebs[i]] = 2 * i + 1;
+      needed[secondWebs[i]] = true;
+    }
+
+    if(!IsConditional(step.opcode)) {
+      unsigned int web = numRegisters + i;
+      if(i > 0 && IsConditional(steps[i - 1].opcode)) {
+	web = joined[web] = FirstWeb(joined, reaching[step.destination]);
+      }
+      lastUse[web] = 2 * i + 2;
+      needed[web] = true;
+      reaching[step.destination] = web;
+    }
+  }
+
+  // The outputs' final webs must end up in the outputs' own registers, and are coloured
+  // first. The rest are coloured in the order they start, each with the lowest register no
+  // overlapping web which is already coloured has:
+  std::vector<int> colours(joined.size(), -1);
+  std::vector<unsigned int> coloured;
+  for(unsigned int r = 0; r < numOutputs; ++r) {
+    unsigned int web = FirstWeb(joined, reaching[r]);
+    lastUse[web] = 2 * steps.size() + 1;
+    needed[web] = true;
+    colours[web] = r;
+    coloured.push_back(web);
+  }
+
+  unsigned int used = numOutputs;
+  for(unsigned int web = 0; web < joined.size(); ++web) {
+    if(!needed[web] || colours[web] >= 0) {
+      continue;
+    }
+
+    unsigned int start = web < numRegisters ? 0 : 2 * (web - numRegisters) + 2;
+    std::vector<bool> taken(numRegisters + steps.size(), false);
+    for(unsigned int j = 0; j < coloured.size(); ++j) {
+      unsigned int other = coloured[j];
+      unsigned int otherStart = other < numRegisters ? 0 : 2 * (other - numRegisters) + 2;
+      if(start <= lastUse[other] && otherStart <= lastUse[web]) {
+	taken[colours[other]] = true;
+      }
+    }
+
+    unsigned int colour = 0;
+    while(taken[colour]) {
+      ++colour;
+    }
+    colours[web] = colour;
+    coloured.push_back(web);
+    used = std::max(used, colour + 1);
+  }
+  if(used >= numRegisters) {
+    return;
+  }
+
+  // Rename each step's registers, and move the features and constants down to follow them:
+  for(unsigned int i = 0; i < steps.size(); ++i) {
+    Step& step = steps[i];
+    step.first = step.first < numRegisters ? colours[firstWebs[i]] :
+      step.first - numRegisters + used;
+    step.second = step.second < numRegisters ? colours[secondWebs[i]] :
+      step.second - numRegisters + used;
+    step.destination = IsConditional(step.opcode) ? 0 :
+      colours[FirstWeb(joined, numRegisters + i)];
+  }
+  numRegisters = used;
+
+  // A copy between two webs given the same register now leaves it as it is, so it goes, and
+  // so do the conditionals which guarded it, as they would otherwise guard the next step:
+  std::vector<Step> remaining;
+  for(unsigned int i = 0; i < steps.size(); ++i) {
+    if(steps[i].opcode == OpCopy && steps[i].first == steps[i].destination) {
+      while(!remaining.empty() && IsConditional(remaining.back().opcode)) {
+	remaining.pop_back();
+      }
+    }
+    else {
+      remaining.push_back(steps[i]);
+    }
+  }
+  steps.swap(remaining);
+}
+
+
+
+template <class T>
+void VUWLGP::ExecutionPlan<T>::Fuse(const std::vector<bool>& superinstructions) {
+  std::vector<Step> fused;
+  for(unsigned int i = 0; i < steps.size(); ++i) {
+    Step superinstruction;
+    bool guarded = i > 0 && IsConditional(steps[i - 1].opcode);
+    if(i + 1 < steps.size() && FusePair(steps[i], steps[i + 1], guarded, superinstruction) &&
+       superinstructions[superinstruction.opcode]) {
+      fused.push_back(superinstruction);
+      ++i;
+    }
+    else {
+      fused.push_back(steps[i]);
+    }
+  }
+  steps.swap(fused);
+}
+
+
+
+template <class T>
+bool VUWLGP::ExecutionPlan<T>::FusePair(const Step& step, const Step& next, bool guarded,
+					Step& fused) {
+  if(IsConditional(next.opcode) || next.opcode >= OpIfltPlus) {
+    return false;
+  }
+  fused = next;
+  fused.third = step.first;
+  fused.fourth = step.second;
+  if(IsConditional(step.opcode)) {
+    fused.opcode = next.opcode == OpCopy ? OpIfltCopy : OpIfltPlus + next.opcode;
+    return true;
+  }
+
+  // The next step must combine step's result with one other value, which isn't step's
+  // result too, and a guarded step's result might not be the one it computes:
+  unsigned int result = step.destination;
+  if(guarded || next.destination != result || next.opcode == OpCopy ||
+     (next.first == result) == (next.second == result)) {
+    return false;
+  }
+  unsigned int other = next.first == result ? next.second : next.first;
+  fused = step;
+  fused.third = other;
+  fused.fourth = 0;
+  if(step.opcode == OpMult && next.opcode == OpPlus) {
+    fused.opcode = OpMultPlus;
+  }
+  else if(step.opcode == OpMult && next.opcode == OpMinus && next.first == result) {
+    fused.opcode = OpMultMinus;
+  }
+  else if(step.opcode == OpPlus && next.opcode == OpMult) {
+    fused.opcode = OpPlusMult;
+  }
+  else if(step.opcode == OpMinus && next.opcode == OpMult) {
+    fused.opcode = OpMinusMult;
+  }
+  else {
+    return false;
+  }
+  return true;
+}
+
+
+
+template <class T>
+unsigned int VUWLGP::ExecutionPlan<T>::Unfuse(const Step& step, Step* parts) {
+  parts[0] = parts[1] = step;
+  if(step.opcode >= OpIfltPlus && step.opcode <= OpIfltCopy) {
+    parts[0].opcode = OpIflt;
+    parts[0].first = step.third;
+    parts[0].second = step.fourth;
+    parts[1].opcode = step.opcode == OpIfltCopy ? OpCopy : step.opcode - OpIfltPlus;
+    return 2;
+  }
+
+  // The second step combines the first's result, in the destination, with the third operand:
+  const unsigned char opcodes[][2] = { { OpMult, OpPlus }, { OpMult, OpMinus },
+				       { OpPlus, OpMult }, { OpMinus, OpMult } };
+  if(step.opcode >= OpMultPlus && step.opcode <= OpMinusMult) {
+    parts[0].opcode = opcodes[step.opcode - OpMultPlus][0];
+    parts[1].opcode = opcodes[step.opcode - OpMultPlus][1];
+    parts[1].first = step.destination;
+    parts[1].second = step.third;
+    return 2;
+  }
+  return 1;
+}
+
+
+
+template <class T>
+void VUWLGP::ExecutionPlan<T>::RemoveDeadSteps() {
+  // A step is kept if it writes an output or a register which is read later, or is a
+  // conditional guarding a step which is kept:
+  std::vector<bool> live(numRegisters, false);
+  for(unsigned int r = 0; r < numOutputs && r < numRegisters; ++r) {
+    live[r] = true;
+  }
+  std::vector<bool> kept(steps.size(), false);
+  for(unsigned int i = steps.size(); i-- > 0; ) {
+    const Step& step = steps[i];
+    if(IsConditional(step.opcode)) {
+      kept[i] = i + 1 < steps.size() && kept[i + 1];
+    }
+    else if(live[step.destination]) {
+      kept[i] = true;
+      // A guarded step might not change the register, so whatever set it before still can:
+      if(i == 0 || !IsConditional(steps[i - 1].opcode)) {
+	live[step.destination] = false;
+      }
+    }
+
+    if(kept[i]) {
+      if(step.first < numRegisters) {
+	live[step.first] = true;
+      }
+      if(step.opcode != OpCopy && step.second < numRegisters) {
+	live[step.second] = true;
+      }
+    }
+  }
+
+  std::vector<Step> remaining;
+  for(unsigned int i = 0; i < steps.size(); ++i) {
+    if(kept[i]) {
+      remaining.push_back(steps[i]);
+    }
+  }
+  steps.swap(remaining);
+}
+
+
+
+template <class T>
+void VUWLGP::ExecutionPlan<T>::RemoveSemanticIntrons(VUWLGP::FitnessEnvironment<T>& fe,
+						     T tolerance) {
+  RemoveDeadSteps();
+
+  // Each case's slots, holding the registers as they are before the step being tried, and
+  // the outputs of the whole plan on each case:
+  std::vector<std::vector<T> > cases;
+  std::vector<T> expected;
+  for(bool more = fe.LoadFirstCase(); more; more = fe.LoadNextCase()) {
+    std::vector<T> slots(NumberOfSlots(), 0);
+    for(unsigned int f = 0; f < numFeatures; ++f) {
+      slots[FirstFeatureSlot() + f] = fe.ReadFeature(f);
+    }
+    for(unsigned int i = 0; i < constants.size(); ++i) {
+      slots[FirstConstantSlot() + i] = constants[i];
+    }
+    cases.push_back(slots);
+
+    Execute(&slots[0]);
+    expected.insert(expected.end(), slots.begin(), slots.begin() + numOutputs);
+  }
+
+  for(unsigned int i = 0; i < steps.size(); ) {
+    unsigned int assignment = i;
+    while(assignment < steps.size() && IsConditional(steps[assignment].opcode)) {
+      ++assignment;
+    }
+    if(assignment == steps.size()) { // trailing conditionals guard nothing
+      break;
+    }
+
+    // Try the plan without the assignment and its guards, then without just the guards:
+    std::vector<Step> whole(steps);
+    steps.erase(steps.begin() + i, steps.begin() + assignment + 1);
+    if(OutputsWithin(cases, expected, i, tolerance)) {
+      continue;
+    }
+    steps = whole;
+    if(assignment > i) {
+      steps.erase(steps.begin() + i, steps.begin() + assignment);
+      if(OutputsWithin(cases, expected, i, tolerance)) {
+	assignment = i;
+      }
+      else {
+	steps = whole;
+      }
+    }
+
+    for(unsigned int c = 0; c < cases.size(); ++c) {
+      Execute(i, assignment + 1, &cases[c][0]);
+    }
+    i = assignment + 1;
+  }
+
+  RemoveDeadSteps();
+  DropUnusedConstants();
+}
+
+
+
+template <class T>
+void VUWLGP::ExecutionPlan<T>::Evaluate(VUWLGP::IProgram<T>& prog,
+					VUWLGP::FitnessEnvironment<T>& fe) const {
+  prog.ZeroFitness();
+  AccumulateError(prog, fe);
+}
+
+
+
+template <class T>
+void VUWLGP::ExecutionPlan<T>::AccumulateError(VUWLGP::IProgram<T>& prog,
+					       VUWLGP::FitnessEnvironment<T>& fe) const {
+  std::vector<T> slots(NumberOfSlots());
+  RegisterCollection<T> finalRegisterValues(programRegisters);
+  for(bool more = fe.LoadFirstCase(); more; more = fe.LoadNextCase()) {
+    for(unsigned int r = 0; r < numRegisters; ++r) {
+      slots[r] = 0;
+    }
+    for(unsigned int f = 0; f < numFeatures; ++f) {
+      slots[FirstFeatureSlot() + f] = fe.ReadFeature(f);
+    }
+    for(unsigned int i = 0; i < constants.size(); ++i) {
+      slots[FirstConstantSlot() + i] = constants[i];
+    }
+
+    Execute(&slots[0]);
+    for(unsigned int r = 0; r < programRegisters; ++r) {
+      finalRegisterValues.Write(r, r < numRegisters ? slots[r] : 0);
+    }
+    prog.UpdateError(finalRegisterValues, fe.CurrentCase());
+  }
+}
+
+
+
+template <class T>
+void VUWLGP::ExecutionPlan<T>::Execute(unsigned int begin, unsigned int end, T* slots) const {
+  // As the interpreter does, a false conditional skips every step up to and including the
+  // next assignment:
+  bool skipping = false;
+  for(typename std::vector<Step>::const_iterator step = steps.begin() + begin;
+      step != steps.begin() + end; ++step) {
+    if(skipping) {
+      skipping = IsConditional(step->opcode);
+      continue;
+    }
+
+    T& destination = slots[step->destination];
+    T first = slots[step->first];
+    T second = slots[step->second];
+    bool guard = step->opcode < OpIfltPlus || step->opcode > OpIfltCopy ||
+      slots[step->third] < slots[step->fourth];
+    switch(step->opcode) {
+    case OpPlus:
+      destination = first + second;
+      break;
+    case OpMinus:
+      destination = first - second;
+      break;
+    case OpMult:
+      destination = first * second;
+      break;
+    case OpDiv:
+      destination = second != 0 ? first / second : 0;
+      break;
+    case OpIflt:
+      skipping = !(first < second);
+      break;
+    case OpCopy:
+      destination = first;
+      break;
+    case OpIfltPlus:
+      destination = guard ? first + second : destination;
+      break;
+    case OpIfltMinus:
+      destination = guard ? first - second : destination;
+      break;
+    case OpIfltMult:
+      destination = guard ? first * second : destination;
+      break;
+    case OpIfltDiv:
+      destination = guard ? (second != 0 ? first / second : 0) : destination;
+      break;
+    case OpIfltCopy:
+      destination = guard ? first : destination;
+      break;
+    case OpMultPlus:
+      destination = first * second;
+      destination = destination + slots[step->third];
+      break;
+    case OpMultMinus:
+      destination = first * second;
+      destination = destination - slots[step->third];
+      break;
+    case OpPlusMult:
+      destination = first + second;
+      destination = destination * slots[step->third];
+      break;
+    case OpMinusMult:
+      destination = first - second;
+      destination = destination * slots[step->third];
+      break;
+    }
+  }
+}
+
+
+
+template <class T>
+bool VUWLGP::ExecutionPlan<T>::OutputsWithin(const std::vector<std::vector<T> >& cases,
+					     const std::vector<T>& expected, unsigned int from,
+					     T tolerance) const {
+  std::vector<T> slots;
+  for(unsigned int c = 0; c < cases.size(); ++c) {
+    slots = cases[c];
+    Execute(from, steps.size(), &slots[0]);
+
+    for(unsigned int r = 0; r < numOutputs; ++r) {
+      T output = slots[r];
+      T target = expected[c * numOutputs + r];
+      bool bothNaN = output != output && target != target;
+      if(output != target && !bothNaN &&
+	 !(std::fabs(output - target) <= tolerance * std::max<T>(1, std::fabs(target)))) {
+	return false;
+      }
+    }
+  }
+  return true;
+}
+
+
+
+template <class T>
+bool VUWLGP::ExecutionPlan<T>::CanCompile(const VUWLGP::IProgram<T>& prog) {
+  const std::vector<Instruction<T>*>& instrs = prog.ConstRawAccessToTheInternalInstructions();
+  for(unsigned int i = 0; i < instrs.size(); ++i) {
+    if(!instrs[i]->IsIntron && OpcodeOf(instrs[i]->Operation()) < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+
+template <class T>
+std::string VUWLGP::ExecutionPlan<T>::ToString() const {
+  std::ostringstream buffer;
+  buffer << "template <class T>\n";
+  buffer << "void VUWLGP::Program::Execute(std::vector<T>& r, const std::vector<T>& cf) {\n";
+
+  const char* symbols[] = { "+", "-", "*", "/", "<" };
+  for(unsigned int i = 0; i < steps.size(); ++i) {
+    Step parts[2];
+    unsigned int numParts = Unfuse(steps[i], parts);
+    for(unsigned int j = 0; j < numParts; ++j) {
+      const Step& step = parts[j];
+      buffer << "\t";
+      if(IsConditional(step.opcode)) {
+	buffer << "if(" << SlotToString(step.first) << " " << symbols[step.opcode] << " "
+	       << SlotToString(step.second) << ")";
+      }
+      else if(step.opcode == OpCopy) {
+	buffer << "r[" << step.destination << "] = " << SlotToString(step.first) << ";";
+      }
+      else {
+	buffer << "r[" << step.destination << "] = " << SlotToString(step.first) << " "
+	       << symbols[step.opcode] << " " << SlotToString(step.second) << ";";
+      }
+      buffer << "\n";
+    }
+  }
+
+  buffer << "}";
+  return buffer.str();
+}
+
+
+
+template <class T>
+int VUWLGP::ExecutionPlan<T>::OpcodeOf(const VUWLGP::IInstructionOperation<T>* op) {
+  if(dynamic_cast<const InstructionOperationPlus<T>*>(op) != 0) {
+    return OpPlus;
+  }
+  else if(dynamic_cast<const InstructionOperationMinus<T>*>(op) != 0) {
+    return OpMinus;
+  }
+  else if(dynamic_cast<const InstructionOperationMult<T>*>(op) != 0) {
+    return OpMult;
+  }
+  else if(dynamic_cast<const InstructionOperationDiv<T>*>(op) != 0) {
+    return OpDiv;
+  }
+  else if(dynamic_cast<const InstructionOperationIflt<T>*>(op) != 0) {
+    return OpIflt;
+  }
+  return -1;
+}
+
+
+
+template <class T>
+int VUWLGP::ExecutionPlan<T>::HolderOf(const std::vector<unsigned int>& values,
+					unsigned int value) const {
+  if(value >= numRegisters && value < NumberOfSlots()) {
+    return value;
+  }
+  for(unsigned int r = 0; r < numRegisters; ++r) {
+    if(values[r] == value) {
+      return r;
+    }
+  }
+  return -1;
+}
+
+
+
+template <class T>
+unsigned int VUWLGP::ExecutionPlan<T>::FirstWeb(std::vector<unsigned int>& joined,
+						unsigned int web) {
+  while(joined[web] != web) {
+    web = joined[web] = joined[joined[web]];
+  }
+  return web;
+}
+
+
+
+template <class T>
+unsigned short VUWLGP::ExecutionPlan<T>::SlotOf(const VUWLGP::IInstructionArgument<T>* arg) {
+  switch(arg->ArgumentType()) {
+  case ArgumentTypeRegister:
+    return arg->ArgumentIndex();
+  case ArgumentTypeFeature:
+    return numRegisters + arg->ArgumentIndex();
+  default:
+    return ConstantSlot(static_cast<const InstructionArgumentConstant<T>*>(arg)->Constant());
+  }
+}
+
+
+
+template <class T>
+unsigned short VUWLGP::ExecutionPlan<T>::ConstantSlot(T value) {
+  for(unsigned int i = 0; i < constants.size(); ++i) {
+    if(SameBits(constants[i], value)) {
+      return FirstConstantSlot() + i;
+    }
+  }
+
+  if(FirstConstantSlot() + constants.size() > std::numeric_limits<unsigned short>::max()) {
+    throw std::string("ExecutionPlan::ConstantSlot - too many slots");
+  }
+  constants.push_back(value);
+  return FirstConstantSlot() + constants.size() - 1;
+}
+
+
+
+template <class T>
+void VUWLGP::ExecutionPlan<T>::Simplify(VUWLGP::ExecutionPlan<T>::Step& step,
+					bool assumeFinite) {
+  bool firstKnown = IsConstantSlot(step.first);
+  bool secondKnown = IsConstantSlot(step.second);
+  T first = firstKnown ? ConstantAt(step.first) : 0;
+  T second = secondKnown ? ConstantAt(step.second) : 0;
+
+  if(firstKnown && (secondKnown || step.opcode == OpCopy)) {
+    step = Copy(step.destination, ConstantSlot(Apply(step.opcode, first, second)));
+    return;
+  }
+
+  // The operand the result always equals, if there is one, or whether it is always 0:
+  int same = -1;
+  bool zero = false;
+  switch(step.opcode) {
+  case OpPlus:
+    if(secondKnown && second == 0) {
+      same = step.first;
+    }
+    else if(firstKnown && first == 0) {
+      same = step.second;
+    }
+    break;
+  case OpMinus:
+    if(secondKnown && second == 0) {
+      same = step.first;
+    }
+    zero = assumeFinite && step.first == step.second;
+    break;
+  case OpMult:
+    if(secondKnown && second == 1) {
+      same = step.first;
+    }
+    else if(firstKnown && first == 1) {
+      same = step.second;
+    }
+    zero = assumeFinite && ((firstKnown && first == 0) || (secondKnown && second == 0));
+    break;
+  case OpDiv:
+    if(secondKnown && second == 1) {
+      same = step.first;
+    }
+    zero = (secondKnown && second == 0) || (assumeFinite && firstKnown && first == 0);
+    break;
+  }
+
+  if(zero) {
+    step = Copy(step.destination, ConstantSlot(0));
+  }
+  else if(same >= 0) {
+    step = Copy(step.destination, same);
+  }
+}
+
+
+
+template <class T>
+std::string VUWLGP::ExecutionPlan<T>::SlotToString(unsigned int slot) const {
+  std::ostringstream buffer;
+  if(slot < numRegisters) {
+    buffer << "r[" << slot << "]";
+  }
+  else if(!IsConstantSlot(slot)) {
+    buffer << "cf[" << slot - numRegisters << "]";
+  }
+  else {
+    buffer.precision(std::numeric_limits<T>::max_digits10);
+    buffer << ConstantAt(slot);
+  }
+  return buffer.str();
+}
+#endif
@@ -3,11 +3,17 @@
 #ifndef FITNESSENVIRONMENT_H
 #define FITNESSENVIRONMENT_H
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "Dataset.h"
+#include "HalfFloat.h"
 #include "IFitnessCase.h"
 #include "RegisterCollection.h"
 
@@ -16,14 +22,40 @@ namespace VUWLGP {
 
   // This class stores the memory environment, fitness cases and have methods for evaluating 
   // programs. T is the type of the features and registers for this problem. This class manages 
-  // the memory of the fitness cases added to it.
+  // the memory of the fitness cases added to it. Alternatively it can evaluate programs
+  // against part of a Dataset in place, see UseDataset.
   template <class T> class FitnessEnvironment {
   public:
     FitnessEnvironment(Config<T>* c);
     virtual ~FitnessEnvironment();
 
+    // Builds a fitness environment with its own registers which shares, but does not manage
+    // the memory of, the fitness cases of rhs - e.g. so that several threads can evaluate
+    // programs against the same cases at the same time. rhs must outlive the copy, and cases
+    // should not be added to either while they are both in use.
+    FitnessEnvironment(const FitnessEnvironment<T>& rhs);
+
+    // How far the features PackFeatures stored are from their values: the largest absolute
+    // and relative differences, the root mean square difference, and how many finite values
+    // were too large for the format and became infinite.
+    struct PackingError {
+      double maxAbsolute;
+      double maxRelative;
+      double rms;
+      unsigned long long overflows;
+    };
+
     // Returns the value of the i'th feature
-    T ReadFeature(unsigned int i) const { return cases[currentCase]->F(i); }
+    T ReadFeature(unsigned int i) const {
+      if(storage != FullPrecision) {
+	return HalfFloat::Decode(packedColumns[i][currentCase], storage);
+      }
+      return data != 0 ? columns[i][currentCase] : cases[currentCase]->F(i);
+    }
+
+    // Reads the value of the i'th feature of each case in the window into values, in order, as
+    // ReadFeature would one case at a time, but decoding packed float16s a block at a time.
+    void ReadFeatures(unsigned int i, T* values) const;
 
     // Returns the value of register i
     T ReadRegister(unsigned int i) const { return registers.Read(i); }
@@ -34,17 +66,59 @@ namespace VUWLGP {
     // Sets all read/write registers to have a value of 0
     void ZeroRegisters() { registers.ZeroRegisters(); }
 
-    // Returns true if the feature vector for the first case could be loaded, false otherwise
-    bool LoadFirstCase() { currentCase = 0; return NumberOfCases() > 0; }
-
-    // Returns true if there was a "next case" to load
-    bool LoadNextCase() { return ++currentCase < NumberOfCases(); }
+    // Returns true if the feature vector for the first case (of the window) could be loaded,
+    // false otherwise
+    bool LoadFirstCase() { currentCase = windowBegin; return currentCase < WindowEnd(); }
+
+    // Returns true if there was a "next case" (in the window) to load
+    bool LoadNextCase() { return ++currentCase < WindowEnd(); }
+
+    // Restricts LoadFirstCase and LoadNextCase to cases [begin, end), e.g. so that a population
+    // can be evaluated against a block of cases at a time. SetWindow(0, NumberOfCases())
+    // restores the default of every case. Copies start with every case.
+    void SetWindow(unsigned int begin, unsigned int end) {
+      windowBegin = begin;
+      windowEnd = end;
+    }
+
+    // Return the first case of the window, and the end of the window of cases LoadNextCase
+    // stops at.
+    unsigned int WindowBegin() const { return windowBegin; }
+    unsigned int WindowEnd() const { return std::min(windowEnd, NumberOfCases()); }
+
+    // Advise the system that cases [begin, end) are about to be read, or won't be read again
+    // for a while - see Dataset::Prefetch and Dataset::Release. They only have an effect when
+    // evaluating against a mapped Dataset.
+    void PrefetchCases(unsigned int begin, unsigned int end) const {
+      if(data != 0) { data->Prefetch(first + begin, first + std::min(end, numDataCases)); }
+    }
+    void ReleaseCases(unsigned int begin, unsigned int end) const {
+      if(data != 0) { data->Release(first + begin, first + std::min(end, numDataCases)); }
+    }
 
     // Returns a pointer to the current case
-    const IFitnessCase<T>* CurrentCase() { return cases[currentCase]; }
+    const IFitnessCase<T>* CurrentCase() {
+      if(data != 0) {
+	view->View(*data, first + currentCase);
+	return view;
+      }
+      return cases[currentCase];
+    }
 
     // Returns the number of cases in this fitness environment:
-    unsigned int NumberOfCases() const { return cases.size(); }
+    unsigned int NumberOfCases() const { return data != 0 ? numDataCases : cases.size(); }
+
+    // Counts one evaluation of a program against these cases. The count is shared with every
+    // copy of the FitnessEnvironment, so it includes the evaluations on other threads.
+    void CountEvaluation() { ++*evaluations; }
+
+    // Returns the number of programs evaluated against these cases so far.
+    unsigned long long Evaluations() const { return evaluations->load(); }
+
+    // Makes this environment, and copies made of it from now on, count evaluations apart from
+    // the environment it was copied from, e.g. so trial evaluations (see
+    // IPopulation::Autotune) aren't counted as the run's.
+    void CountEvaluationsSeparately() { evaluations = &ownEvaluations; }
 
     // Adds the specified case to the FitnessEnvironment - these get passed to fitness measures
     // when a program's error is being updated, so that is where they should probably be checked
@@ -58,17 +132,66 @@ namespace VUWLGP {
     void AddCasesFromFile(std::string filePath, 
 			  IFitnessCase<T>* (*generator)(const std::string&));
 
+    // Makes this environment evaluate programs against cases [begin, end) of data where they
+    // are, rather than against cases of its own: features are read straight from data's
+    // columns, and the fitness measure is given a single case (built by generator) which is
+    // made to stand in for each case in turn (see IFitnessCase::View). Nothing is copied, so
+    // data must outlive this environment and its copies. Cases can't be added afterwards.
+    // Throws a std::string if the environment already has cases.
+    void UseDataset(const Dataset<T>& data, unsigned int begin, unsigned int end,
+		    IFitnessCase<T>* (*generator)(const Dataset<T>&, unsigned int));
+
+    // Adds a case for each case in data, built by generator from the data and the case's
+    // number, e.g. SymRegFitnessCase<T>::Generate. The cases are built on
+    // Config::NumberOfThreads() threads, so generator must be safe to call concurrently.
+    void AddCases(const Dataset<T>& data,
+		  IFitnessCase<T>* (*generator)(const Dataset<T>&, unsigned int));
+
+    // Stores a copy of the features of every case in format (see FeatureStorage), which
+    // ReadFeature reads instead from then on, so evaluating programs reads 2 bytes per feature
+    // rather than sizeof(T) - on datasets too big for the cache, that halves or quarters the
+    // memory traffic for features. The targets or classes are left as they are. Every case
+    // must have been added, and copies must be made, afterwards. Returns how much precision
+    // the features lost.
+    PackingError PackFeatures(FeatureStorage format);
+
     // Returns a string representation of this FitnessEnvironment, i.e. the value of the
     // features for the current fitness case and the current values of the registers. Does
     // not place a trailing new line after the string representation, even though its multiline.
     std::string ToString() const;
     
   private:
+    // Sets cases[first + i] to generator(data, i) for each i in [begin, end).
+    void GenerateCases(const Dataset<T>* data,
+		       IFitnessCase<T>* (*generator)(const Dataset<T>&, unsigned int),
+		       unsigned int begin, unsigned int end, unsigned int first);
+
     RegisterCollection<T> registers; // the read-write registers
     Config<T>* config; // the configuration variables
 
     std::vector<IFitnessCase<T>*> cases;
     unsigned int currentCase;
+    unsigned int windowBegin;
+    unsigned int windowEnd; // may be past the last case
+    bool ownsCases; // false if the cases are shared with another FitnessEnvironment
+
+    // Only used with UseDataset - the columns of cases [first, first + numDataCases) of data,
+    // and the case standing in for the current one:
+    const Dataset<T>* data;
+    std::vector<const T*> columns;
+    unsigned int first;
+    unsigned int numDataCases;
+    IFitnessCase<T>* (*viewGenerator)(const Dataset<T>&, unsigned int);
+    IFitnessCase<T>* view;
+
+    // Only used with PackFeatures - the feature columns (each NumberOfCases() long) in
+    // packed, which only the original holds:
+    FeatureStorage storage;
+    std::vector<unsigned short> packed;
+    std::vector<const unsigned short*> packedColumns;
+
+    std::atomic<unsigned long long> ownEvaluations;
+    std::atomic<unsigned long long>* evaluations; // ownEvaluations of the original
   };
 }
 
@@ -79,13 +202,53 @@ template <class T>
 VUWLGP::FitnessEnvironment<T>::FitnessEnvironment(VUWLGP::Config<T>* conf):
 registers(conf->numRegisters),
 config(conf),
-currentCase(0) {
+currentCase(0),
+windowBegin(0),
+windowEnd(~0u),
+ownsCases(true),
+data(0),
+first(0),
+numDataCases(0),
+viewGenerator(0),
+view(0),
+storage(FullPrecision),
+ownEvaluations(0),
+evaluations(&ownEvaluations) {
+}
+
+
+
+template <class T> 
+VUWLGP::FitnessEnvironment<T>::FitnessEnvironment(const VUWLGP::FitnessEnvironment<T>& rhs):
+registers(rhs.config->numRegisters),
+config(rhs.config),
+cases(rhs.cases),
+currentCase(0),
+windowBegin(0),
+windowEnd(~0u),
+ownsCases(false),
+data(rhs.data),
+columns(rhs.columns),
+first(rhs.first),
+numDataCases(rhs.numDataCases),
+viewGenerator(rhs.viewGenerator),
+view(rhs.view != 0 ? rhs.viewGenerator(*rhs.data, rhs.first) : 0),
+storage(rhs.storage),
+packedColumns(rhs.packedColumns),
+ownEvaluations(0),
+evaluations(rhs.evaluations) {
 }
 
 
 
 template <class T> 
 VUWLGP::FitnessEnvironment<T>::~FitnessEnvironment() {
+  delete view;
+
+  if(!ownsCases) {
+    return;
+  }
+
   for(unsigned int i = 0; i < cases.size(); ++i) {
     delete cases[i];
   }
@@ -106,6 +269,140 @@ VUWLGP::FitnessEnvironment<T>::AddCasesFromFile(std::string filePath,
 
 
 
+template <class T> void
+VUWLGP::FitnessEnvironment<T>::UseDataset(const VUWLGP::Dataset<T>& d, unsigned int begin,
+					  unsigned int end,
+					  IFitnessCase<T>* (*generator)(const Dataset<T>&,
+									unsigned int)) {
+  if(!cases.empty() || data != 0) {
+    throw std::string("FitnessEnvironment::UseDataset - the environment already has cases");
+  }
+
+  end = std::min(end, d.NumberOfCases());
+  begin = std::min(begin, end);
+
+  data = &d;
+  first = begin;
+  numDataCases = end - begin;
+  for(unsigned int i = 0; i < d.NumberOfFeatures(); ++i) {
+    columns.push_back(d.Feature(i) + begin);
+  }
+
+  viewGenerator = generator;
+  view = numDataCases > 0 ? generator(d, begin) : 0;
+}
+
+
+
+template <class T> void
+VUWLGP::FitnessEnvironment<T>::AddCases(const VUWLGP::Dataset<T>& data,
+					IFitnessCase<T>* (*generator)(const Dataset<T>&,
+								      unsigned int)) {
+  unsigned int first = cases.size();
+  cases.resize(first + data.NumberOfCases());
+
+  // Not worth a thread for fewer than 16384 cases:
+  unsigned int numThreads = std::max(1u, std::min(config->NumberOfThreads(),
+						  data.NumberOfCases() / 16384));
+  std::vector<std::thread> threads;
+  for(unsigned int i = 0; i < numThreads; ++i) {
+    unsigned int begin = static_cast<unsigned long long>(data.NumberOfCases()) * i / numThreads;
+    unsigned int end = static_cast<unsigned long long>(data.NumberOfCases()) * (i + 1) /
+      numThreads;
+    threads.push_back(std::thread(&FitnessEnvironment<T>::GenerateCases, this, &data,
+				  generator, begin, end, first));
+  }
+
+  for(unsigned int i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+}
+
+
+
+template <class T> void
+VUWLGP::FitnessEnvironment<T>::GenerateCases(const VUWLGP::Dataset<T>* data,
+					     IFitnessCase<T>* (*generator)(const Dataset<T>&,
+									   unsigned int),
+					     unsigned int begin, unsigned int end,
+					     unsigned int first) {
+  for(unsigned int i = begin; i < end; ++i) {
+    cases[first + i] = generator(*data, i);
+  }
+}
+
+
+
+template <class T>
+void VUWLGP::FitnessEnvironment<T>::ReadFeatures(unsigned int i, T* values) const {
+  unsigned int end = WindowEnd();
+  if(storage == Float16 && end > windowBegin) {
+    HalfFloat::DecodeFloat16s(packedColumns[i] + windowBegin, end - windowBegin, values);
+    return;
+  }
+
+  for(unsigned int c = windowBegin; c < end; ++c) {
+    if(storage != FullPrecision) {
+      values[c - windowBegin] = HalfFloat::Decode(packedColumns[i][c], storage);
+    }
+    else {
+      values[c - windowBegin] = data != 0 ? columns[i][c] : cases[c]->F(i);
+    }
+  }
+}
+
+
+
+template <class T> typename VUWLGP::FitnessEnvironment<T>::PackingError
+VUWLGP::FitnessEnvironment<T>::PackFeatures(VUWLGP::FeatureStorage format) {
+  PackingError error = { 0, 0, 0, 0 };
+  storage = FullPrecision;
+  packed.clear();
+  packedColumns.clear();
+  if(format == FullPrecision) {
+    return error;
+  }
+
+  unsigned int numFeatures = data != 0 ? columns.size() : config->numFeatures;
+  unsigned int numCases = NumberOfCases();
+  packed.resize(static_cast<size_t>(numFeatures) * numCases);
+
+  double sumSquares = 0;
+  unsigned long long measured = 0;
+  for(unsigned int f = 0; f < numFeatures; ++f) {
+    unsigned short* column = &packed[0] + static_cast<size_t>(f) * numCases;
+    for(unsigned int i = 0; i < numCases; ++i) {
+      double value = data != 0 ? columns[f][i] : cases[i]->F(f);
+      column[i] = HalfFloat::Encode(static_cast<float>(value), format);
+
+      // Infinities and NaNs stay as they are, and overflows are only counted:
+      double difference = std::fabs(HalfFloat::Decode(column[i], format) - value);
+      if(!std::isfinite(value)) {
+	continue;
+      }
+      else if(std::isinf(difference)) {
+	++error.overflows;
+	continue;
+      }
+      error.maxAbsolute = std::max(error.maxAbsolute, difference);
+      if(value != 0) {
+	error.maxRelative = std::max(error.maxRelative, difference / std::fabs(value));
+      }
+      sumSquares += difference * difference;
+      ++measured;
+    }
+    packedColumns.push_back(column);
+  }
+
+  if(measured > 0) {
+    error.rms = std::sqrt(sumSquares / measured);
+  }
+  storage = format;
+  return error;
+}
+
+
+
 template <class T> 
 std::string VUWLGP::FitnessEnvironment<T>::ToString() const {
   std::ostringstream buffer;
@@ -27,6 +27,11 @@ namespace VUWLGP {
 
   protected:
     void AddElite(unsigned int number, std::vector<IProgramSubclass*>& addTo);
+
+    // Called by IteratePopulation with each child (not elite) as soon as it has been bred and
+    // culled to size, e.g. so that it can be evaluated while the rest of the generation is
+    // bred. The child is already in the next generation and must not be deleted.
+    virtual void ChildBred(IProgramSubclass* child) { }
   };
 }
 
@@ -37,11 +42,12 @@ template <class IProgramSubclass, class T> void
 VUWLGP::GenerationalTournamentPopulation<IProgramSubclass, T>::IteratePopulation() {
   // Store the next population of programs into another vector temporarily:
   std::vector<IProgramSubclass*> nextGen;
-  nextGen.reserve(config->populationSize);
+  nextGen.reserve(this->config->populationSize);
 
   // Carry out the elitism, rounding down the number of individuals we create according 
   // to the proportion.
-  AddElite(static_cast<unsigned int>(proportionElitism * Size()), nextGen);
+  AddElite(static_cast<unsigned int>(proportionElitism * this->Size()), nextGen);
+  unsigned int numElite = nextGen.size();
 
   // Carry out the other evolutionary operations, weightings are percentages since 
   // they sum to 100:
@@ -51,20 +57,25 @@ VUWLGP::GenerationalTournamentPopulation<IProgramSubclass, T>::IteratePopulation
   o.AddElement(&IPopulation<IProgramSubclass, T>::MicroMutation, 30);
   o.AddElement(&IPopulation<IProgramSubclass, T>::CrossoverFree, 30);
 
-  while(nextGen.size() < Size()) {
-    nextGen.push_back((this->*o.GetRandomElement())());
+  while(nextGen.size() < this->Size()) {
+    IProgramSubclass* child = (this->*o.GetRandomElement())();
+    child->RandomlyCullToSize(this->config->maxLength);
+    nextGen.push_back(child);
+    ChildBred(child);
   }
   
   // Delete the existing generation and replace it with the one just built.
-  for(unsigned int i = 0; i < Size(); ++i) {
-    delete programs[i];
+  for(unsigned int i = 0; i < this->Size(); ++i) {
+    delete this->programs[i];
   }
 
-  programs.clear();
-  programs.reserve(nextGen.size());
+  this->programs.clear();
+  this->programs.reserve(nextGen.size());
   for(unsigned int i = 0; i < nextGen.size(); ++i) {
-    nextGen[i]->RandomlyCullToSize(config->maxLength);
-    programs.push_back(nextGen[i]);
+    if(i < numElite) {
+      nextGen[i]->RandomlyCullToSize(this->config->maxLength);
+    }
+    this->programs.push_back(nextGen[i]);
   }
 }
 
@@ -72,27 +83,28 @@ VUWLGP::GenerationalTournamentPopulation<IProgramSubclass, T>::IteratePopulation
 
 template <class IProgramSubclass, class T> const IProgramSubclass*
 VUWLGP::GenerationalTournamentPopulation<IProgramSubclass, T>::SelectProgByFitness() const {
-  if(Size() == 1) {
-    return dynamic_cast<IProgramSubclass*>(programs[0]);
+  if(this->Size() == 1) {
+    return dynamic_cast<IProgramSubclass*>(this->programs[0]);
   }
 
-  unsigned int bestProgIndex = Rand::Int(programs.size());
+  unsigned int bestProgIndex = Rand::Int(this->programs.size());
   unsigned int candidateProgIndex;
 
-  for(unsigned int i = 1; i < tournamentSize && i < Size(); ++i) {
-    candidateProgIndex = Rand::Int(Size());
+  for(unsigned int i = 1; i < tournamentSize && i < this->Size(); ++i) {
+    candidateProgIndex = Rand::Int(this->Size());
  
     // If the best program has a higher (worse) fitness than the candidate then the candidate is
     // the new best:
     if(bestProgIndex == candidateProgIndex) {
       --i; // Select another, different program
     }
-    else if(programs[bestProgIndex]->Fitness() > programs[candidateProgIndex]->Fitness()) {
+    else if(this->programs[bestProgIndex]->Fitness() > 
+	    this->programs[candidateProgIndex]->Fitness()) {
 	bestProgIndex = candidateProgIndex;
     }
   }
   
-  return dynamic_cast<IProgramSubclass*>(programs[bestProgIndex]);
+  return dynamic_cast<IProgramSubclass*>(this->programs[bestProgIndex]);
 }
 
 
@@ -100,9 +112,9 @@ VUWLGP::GenerationalTournamentPopulation<IProgramSubclass, T>::SelectProgByFitne
 template <class IProgramSubclass, class T> 
 void VUWLGP::GenerationalTournamentPopulation<IProgramSubclass, T>::AddElite
 (unsigned int number, std::vector<IProgramSubclass*>& addTo) {
-  SortFittestFirst();
+  this->SortFittestFirst();
   for(unsigned int i = 0; i < number; ++i) {
-    IProgramSubclass* temp = dynamic_cast<IProgramSubclass*>(programs[i]);
+    IProgramSubclass* temp = dynamic_cast<IProgramSubclass*>(this->programs[i]);
     addTo.push_back(new IProgramSubclass(*temp));
   }
 }
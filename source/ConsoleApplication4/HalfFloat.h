@@ -0,0 +1,179 @@
+
+  
+#ifndef HALFFLOAT_H
+#define HALFFLOAT_H
+
+#include <cstring>
+#include <string>
+
+#include "KernelDispatch.h"
+
+#if defined(__F16C__) || VUWLGP_KERNEL_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace VUWLGP {
+  // How the features of a FitnessEnvironment are stored (see
+  // FitnessEnvironment::PackFeatures): as T, as IEEE 754 half precision floats (5 exponent and
+  // 10 mantissa bits, so values are at most 65504 and have about 3 significant digits) or as
+  // bfloat16s (the top 16 bits of a float - its range, but only about 2 significant digits).
+  enum FeatureStorage { FullPrecision, Float16, BFloat16 };
+
+  // Converts floats to and from the 16 bit formats. Encoding rounds to the nearest value,
+  // ties to even. Decoding is exact. A single value is converted with the F16C instructions
+  // only when the build enables them (e.g. with -mf16c or -march=native), otherwise with a few
+  // integer operations; DecodeFloat16s uses them whenever the selected kernel level does.
+  class HalfFloat {
+  public:
+    // Returns the storage called name - "full", "float16" or "bfloat16" - and throws a
+    // std::string if there isn't one.
+    static FeatureStorage StorageNamed(const std::string& name);
+
+    static unsigned short Encode(float value, FeatureStorage format) {
+      return format == BFloat16 ? EncodeBFloat16(value) : EncodeFloat16(value);
+    }
+
+    static float Decode(unsigned short value, FeatureStorage format) {
+      return format == BFloat16 ? DecodeBFloat16(value) : DecodeFloat16(value);
+    }
+
+    static unsigned short EncodeFloat16(float value);
+    static float DecodeFloat16(unsigned short value);
+    static unsigned short EncodeBFloat16(float value);
+    static float DecodeBFloat16(unsigned short value) { return FromBits(value << 16); }
+
+    // Decodes the count float16s at values into out, giving the same values as DecodeFloat16
+    // (though a signalling NaN may come out quiet). At the AVX2 and AVX-512 kernel levels (see
+    // KernelDispatch) they are decoded eight at a time with the F16C instructions, which this
+    // is compiled for whatever the rest of the build is.
+    template <class U>
+    static void DecodeFloat16s(const unsigned short* values, unsigned int count, U* out);
+
+  private:
+    template <class U>
+    VUWLGP_KERNEL_TARGET("f16c")
+    static void DecodeFloat16sF16c(const unsigned short* values, unsigned int count, U* out);
+
+    static unsigned int ToBits(float value) {
+      unsigned int bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      return bits;
+    }
+
+    static float FromBits(unsigned int bits) {
+      float value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+  };
+}
+
+
+
+////////////////////////////////// Inline Function Definitions /////////////////////////////////
+inline VUWLGP::FeatureStorage VUWLGP::HalfFloat::StorageNamed(const std::string& name) {
+  if(name == "float16") {
+    return Float16;
+  }
+  else if(name == "bfloat16") {
+    return BFloat16;
+  }
+  else if(name != "full") {
+    throw "Unknown feature storage: " + name;
+  }
+  return FullPrecision;
+}
+
+
+
+inline unsigned short VUWLGP::HalfFloat::EncodeFloat16(float value) {
+#if defined(__F16C__)
+  return _cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT);
+#else
+  unsigned int bits = ToBits(value);
+  unsigned short sign = (bits >> 16) & 0x8000;
+  bits &= 0x7fffffff;
+
+  if(bits >= 0x7f800000) { // infinity stays infinity, NaN stays (a quiet) NaN
+    return sign | (bits > 0x7f800000 ? 0x7e00 : 0x7c00);
+  }
+  if(bits >= 0x477ff000) { // rounds to more than 65504
+    return sign | 0x7c00;
+  }
+  if(bits < 0x38800000) { // a subnormal half, or zero: let the float addition do the rounding
+    return sign | static_cast<unsigned short>(ToBits(FromBits(bits) + 0.5f) - 0x3f000000);
+  }
+
+  // Rebias the exponent and round the 13 dropped mantissa bits to nearest, ties to even:
+  unsigned int odd = (bits >> 13) & 1;
+  bits += 0xc8000fff + odd; // (15 - 127) << 23, plus the rounding
+  return sign | static_cast<unsigned short>(bits >> 13);
+#endif
+}
+
+
+
+inline float VUWLGP::HalfFloat::DecodeFloat16(unsigned short value) {
+#if defined(__F16C__)
+  return _cvtsh_ss(value);
+#else
+  unsigned int bits = (value & 0x7fffu) << 13;
+  unsigned int exponent = bits & 0x0f800000;
+  bits += (127 - 15) << 23;
+
+  if(exponent == 0x0f800000) { // infinity or NaN
+    bits += (128 - 16) << 23;
+  }
+  else if(exponent == 0) { // zero or subnormal: renormalise by subtracting 2^-14
+    bits = ToBits(FromBits(bits + (1 << 23)) - FromBits(113 << 23));
+  }
+  return FromBits(bits | (value & 0x8000u) << 16);
+#endif
+}
+
+
+
+template <class U>
+void VUWLGP::HalfFloat::DecodeFloat16s(const unsigned short* values, unsigned int count,
+				       U* out) {
+  if(KernelDispatch::Selected() != KernelsBaseline) {
+    DecodeFloat16sF16c(values, count, out);
+    return;
+  }
+  for(unsigned int i = 0; i < count; ++i) {
+    out[i] = DecodeFloat16(values[i]);
+  }
+}
+
+
+
+template <class U>
+VUWLGP_KERNEL_TARGET("f16c")
+void VUWLGP::HalfFloat::DecodeFloat16sF16c(const unsigned short* values, unsigned int count,
+					   U* out) {
+  unsigned int i = 0;
+#if VUWLGP_KERNEL_DISPATCH
+  for(float decoded[8]; i + 8 <= count; i += 8) {
+    __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+    _mm256_storeu_ps(decoded, _mm256_cvtph_ps(packed));
+    for(unsigned int j = 0; j < 8; ++j) {
+      out[i + j] = decoded[j];
+    }
+  }
+#endif
+  for(; i < count; ++i) {
+    out[i] = DecodeFloat16(values[i]);
+  }
+}
+
+
+
+inline unsigned short VUWLGP::HalfFloat::EncodeBFloat16(float value) {
+  unsigned int bits = ToBits(value);
+  if((bits & 0x7fffffff) > 0x7f800000) { // NaN, which rounding could make infinity
+    return static_cast<unsigned short>((bits >> 16) | 0x40);
+  }
+  bits += 0x7fff + ((bits >> 16) & 1);
+  return static_cast<unsigned short>(bits >> 16);
+}
+#endif
@@ -0,0 +1,69 @@
+// lgphistory - lists the generations recorded in a population history (see PopulationHistory.h)
+// and rebuilds their population dumps, exactly as they would have been written as text.
+//
+// Usage: lgphistory <history file>                          lists the generations recorded
+//        lgphistory <history file> <generation>             prints that generation's dump
+//        lgphistory <history file> <generation> <output>    writes that generation's dump
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "PopulationHistory.h"
+
+using namespace VUWLGP;
+
+// Does what main was asked to with a history of T registers.
+template <class T> static void Run(int argc, char** argv) {
+	PopulationHistoryReader<T> reader(argv[1]);
+
+	if (argc == 2) {
+		std::vector<std::string> identifiers = reader.Identifiers();
+		for (unsigned int i = 0; i < identifiers.size(); ++i) {
+			std::cout << identifiers[i] << std::endl;
+		}
+		return;
+	}
+
+	std::string text;
+	reader.FormatPopulation(argv[2], text);
+
+	if (argc == 3) {
+		std::cout << text;
+		return;
+	}
+
+	FILE* file = std::fopen(argv[3], "wb");
+	if (file == 0 || std::fwrite(text.data(), 1, text.size(), file) != text.size()) {
+		throw std::string("Could not write ") + argv[3];
+	}
+	std::fclose(file);
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2 || argc > 4) {
+		std::cerr << "Usage: " << argv[0] << " <history file> [generation [output file]]"
+			<< std::endl;
+		return 1;
+	}
+
+	try {
+		unsigned int typeSize = PopulationHistoryReader<double>::TypeSize(argv[1]);
+		if (typeSize == sizeof(double)) {
+			Run<double>(argc, argv);
+		}
+		else if (typeSize == sizeof(float)) {
+			Run<float>(argc, argv);
+		}
+		else {
+			throw std::string(argv[1]) + " has registers of an unsupported type";
+		}
+	}
+	catch (const std::string& e) {
+		std::cerr << e << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
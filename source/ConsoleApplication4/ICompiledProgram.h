@@ -0,0 +1,23 @@
+
+  
+#ifndef ICOMPILEDPROGRAM_H
+#define ICOMPILEDPROGRAM_H
+
+namespace VUWLGP {
+  template <class T> class FitnessEnvironment;
+  template <class T> class IProgram;
+
+  // An instance of a sub class of this class is a program compiled into a form which can be
+  // run without the interpreter, e.g. an ExecutionPlan or an OpSet's program, which
+  // populations evaluate whole generations with (see Config::evaluationEngine).
+  template <class T> class ICompiledProgram {
+  public:
+    virtual ~ICompiledProgram() { }
+
+    // Adds prog's error on the cases in fe's window as the compiled program computes its
+    // outputs to its fitness, as IProgram::AccumulateError does.
+    virtual void AccumulateError(IProgram<T>& prog, FitnessEnvironment<T>& fe) const = 0;
+  };
+}
+
+#endif
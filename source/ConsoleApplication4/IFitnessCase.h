@@ -3,9 +3,12 @@
 #ifndef IFITNESSCASE_H
 #define IFITNESSCASE_H
 
+#include <string>
 #include <vector>
 
 namespace VUWLGP {
+  template <class T> class Dataset;
+
   // Represents a single fitness case (e.g. case to be classified, point in a symreg) with
   // features of type T.
   template <class T> class IFitnessCase {
@@ -15,6 +18,14 @@ namespace VUWLGP {
     // Returns the value of the i'th feature.
     T F(unsigned int i) const { return features[i]; }
 
+    // Makes this case stand in for case i of data, for a FitnessEnvironment which reads the
+    // features straight from data's columns (see FitnessEnvironment::UseDataset): the case's
+    // target (e.g. class) becomes case i's, but its features are left as they are. Throws a
+    // std::string for kinds of case which can't stand in for a Dataset's cases.
+    virtual void View(const Dataset<T>& data, unsigned int i) {
+      throw std::string("This kind of fitness case can't be used with a Dataset");
+    }
+
     // Returns a new IFitnessCase of whichever class implements this function
     // The Config object currently is used, but who knows if it'll be needed in the future...
     // C++ doesn't allow abstract statics (for good reason, but it would be nice here if 
@@ -34,6 +34,10 @@ namespace VUWLGP {
     // Used mainly in the unit tests. Sets this fitness measure to some value in the range [0,1)
     virtual void RandomiseFitness() { fitness = Rand::Uniform(); }
 
+    // Restores a previously calculated overall fitness, e.g. when a program is deserialised
+    // or migrates from another population evaluated against the same fitness cases.
+    virtual void SetFitness(double f) { fitness = f; }
+
     // Returns a stringified fitness measure (it should be only one line, but not prefixed with
     // "//" or any other "I am a comment" indication - it should be naked text only.
     virtual std::string ToString() const = 0;
@@ -13,6 +13,8 @@ namespace VUWLGP {
   // An instance of this class is one argument (expression) in an instruction, e.g. r[2], f1.
   template <class T> class IInstructionArgument {
   public:
+    virtual ~IInstructionArgument() { }
+
     // Returns the value of this register in the fitness environment fe
     virtual T Value(const FitnessEnvironment<T>& fe) const = 0;
 
@@ -8,6 +8,7 @@
 #include "IInstructionArgument.h"
 #include "InstructionArgumentRegister.h"
 #include "FitnessEnvironment.h"
+#include "KernelDispatch.h"
 
 namespace VUWLGP {
   template <class T> class Config;
@@ -16,6 +17,14 @@ namespace VUWLGP {
   // e.g. +, -, if<, sqrt
   template<class T> class IInstructionOperation {
   public:
+    // A column of operand values for ExecuteBatch: value i is values[i * stride], so a
+    // register's or feature's column has a stride of 1, and a constant is broadcast with a
+    // stride of 0 (the only other stride).
+    struct Column {
+      const T* values;
+      unsigned int stride;
+    };
+
     // Default ctor, cctor (no InstructionOperator stores any values into memory)
     virtual ~IInstructionOperation() { }
 
@@ -27,6 +36,28 @@ namespace VUWLGP {
 			 const IInstructionArgument<T>* const second,
 			 FitnessEnvironment<T>& fe) const = 0;
 
+    // Returns true if the operation has a batch form (see ExecuteBatch), so vectorised
+    // engines can run it. Operations without one are run by the interpreter.
+    virtual bool ExecutesBatches() const { return false; }
+
+    // The batch form of Execute, which performs the operation on length cases at once: an
+    // assignment writes its result for case i to dest[i], for each i mask[i] is set for (or
+    // every i, if mask is 0), and a conditional clears mask[i] for each i it doesn't hold
+    // for, leaving dest alone. Each case must be computed exactly as Execute computes it, so
+    // engines get the same results either way. See ComputeBatch and HoldsBatch, which
+    // implement it for operations with a static Compute or Holds, at the KernelDispatch level
+    // selected. Throws a std::string if ExecutesBatches is false.
+    virtual void ExecuteBatch(T* dest, const Column& first, const Column& second,
+			      unsigned int length, unsigned char* mask) const {
+      throw std::string("IInstructionOperation::ExecuteBatch - ") + ToString() +
+	" has no batch form";
+    }
+
+    // Returns true if the operation only uses its first argument, e.g. sqrt. Its second is
+    // then ignored, so it isn't printed and its register doesn't make earlier instructions
+    // effective (see IProgram::MarkIntrons).
+    virtual bool IsUnary() const { return false; }
+
     // Clones a copy of this InstructionOperation. Caller is responsible for deallocating it.
     virtual IInstructionOperation* Clone() const = 0;
 
@@ -40,7 +71,197 @@ namespace VUWLGP {
     // Returns a string representation of the operation. If the instruction is a conditional
     // then the caller of this function needs to wrap, e.g. if(...) around the pieces.
     virtual std::string ToString() const = 0;
+
+  protected:
+    // ExecuteBatch for an assignment whose result Operation::Compute(first, second) computes.
+    template <class Operation>
+    static void ComputeBatch(T* dest, const Column& first, const Column& second,
+			     unsigned int length, const unsigned char* mask);
+
+    // ExecuteBatch for a conditional which holds if Operation::Holds(first, second).
+    template <class Operation>
+    static void HoldsBatch(const Column& first, const Column& second, unsigned int length,
+			   unsigned char* mask);
+
+  private:
+    // ComputeBatch with the operands' strides known, so the loops vectorise. Cases mask
+    // clears are computed too, and their old values written back, so there are no branches.
+    template <class Operation, unsigned int FirstStride, unsigned int SecondStride>
+    static VUWLGP_KERNEL_INLINE void ComputeColumns(T* dest, const T* first, const T* second,
+						    unsigned int length,
+						    const unsigned char* mask);
+
+    // Runs the copy of ComputeColumns for the selected KernelLevel; the others are it
+    // compiled for AVX2 and AVX-512.
+    template <class Operation, unsigned int FirstStride, unsigned int SecondStride>
+    static void DispatchColumns(T* dest, const T* first, const T* second, unsigned int length,
+				const unsigned char* mask);
+    template <class Operation, unsigned int FirstStride, unsigned int SecondStride>
+    VUWLGP_KERNEL_TARGET("avx2")
+    static void ComputeColumnsAvx2(T* dest, const T* first, const T* second,
+				   unsigned int length, const unsigned char* mask);
+    template <class Operation, unsigned int FirstStride, unsigned int SecondStride>
+    VUWLGP_KERNEL_TARGET("avx512f,avx512bw")
+    static void ComputeColumnsAvx512(T* dest, const T* first, const T* second,
+				     unsigned int length, const unsigned char* mask);
+
+    // HoldsBatch's loop, and it compiled for AVX2 and AVX-512.
+    template <class Operation>
+    static VUWLGP_KERNEL_INLINE void HoldsColumns(const Column& first, const Column& second,
+						  unsigned int length, unsigned char* mask);
+    template <class Operation>
+    VUWLGP_KERNEL_TARGET("avx2")
+    static void HoldsColumnsAvx2(const Column& first, const Column& second,
+				 unsigned int length, unsigned char* mask);
+    template <class Operation>
+    VUWLGP_KERNEL_TARGET("avx512f,avx512bw")
+    static void HoldsColumnsAvx512(const Column& first, const Column& second,
+				   unsigned int length, unsigned char* mask);
   };
 }
 
+
+
+////////////////////////////////// Inline Function Definitions /////////////////////////////////
+template <class T>
+template <class Operation>
+void VUWLGP::IInstructionOperation<T>::ComputeBatch(T* dest, const Column& first,
+						    const Column& second, unsigned int length,
+						    const unsigned char* mask) {
+  if(first.stride != 0 && second.stride != 0) {
+    DispatchColumns<Operation, 1, 1>(dest, first.values, second.values, length, mask);
+  }
+  else if(first.stride != 0) {
+    DispatchColumns<Operation, 1, 0>(dest, first.values, second.values, length, mask);
+  }
+  else if(second.stride != 0) {
+    DispatchColumns<Operation, 0, 1>(dest, first.values, second.values, length, mask);
+  }
+  else {
+    DispatchColumns<Operation, 0, 0>(dest, first.values, second.values, length, mask);
+  }
+}
+
+
+
+template <class T>
+template <class Operation>
+void VUWLGP::IInstructionOperation<T>::HoldsBatch(const Column& first, const Column& second,
+						  unsigned int length, unsigned char* mask) {
+  switch(KernelDispatch::Selected()) {
+  case KernelsAvx512:
+    HoldsColumnsAvx512<Operation>(first, second, length, mask);
+    break;
+  case KernelsAvx2:
+    HoldsColumnsAvx2<Operation>(first, second, length, mask);
+    break;
+  default:
+    HoldsColumns<Operation>(first, second, length, mask);
+  }
+}
+
+
+
+template <class T>
+template <class Operation, unsigned int FirstStride, unsigned int SecondStride>
+void VUWLGP::IInstructionOperation<T>::ComputeColumns(T* dest, const T* first,
+						      const T* second, unsigned int length,
+						      const unsigned char* mask) {
+  if(mask == 0) {
+    for(unsigned int i = 0; i < length; ++i) {
+      dest[i] = Operation::Compute(first[i * FirstStride], second[i * SecondStride]);
+    }
+    return;
+  }
+
+  for(unsigned int i = 0; i < length; ++i) {
+    T result = Operation::Compute(first[i * FirstStride], second[i * SecondStride]);
+    dest[i] = mask[i] ? result : dest[i];
+  }
+}
+
+
+
+template <class T>
+template <class Operation, unsigned int FirstStride, unsigned int SecondStride>
+void VUWLGP::IInstructionOperation<T>::DispatchColumns(T* dest, const T* first,
+						       const T* second, unsigned int length,
+						       const unsigned char* mask) {
+  switch(KernelDispatch::Selected()) {
+  case KernelsAvx512:
+    ComputeColumnsAvx512<Operation, FirstStride, SecondStride>(dest, first, second, length,
+							       mask);
+    break;
+  case KernelsAvx2:
+    ComputeColumnsAvx2<Operation, FirstStride, SecondStride>(dest, first, second, length, mask);
+    break;
+  default:
+    ComputeColumns<Operation, FirstStride, SecondStride>(dest, first, second, length, mask);
+  }
+}
+
+
+
+template <class T>
+template <class Operation, unsigned int FirstStride, unsigned int SecondStride>
+VUWLGP_KERNEL_TARGET("avx2")
+void VUWLGP::IInstructionOperation<T>::ComputeColumnsAvx2(T* dest, const T* first,
+							  const T* second, unsigned int length,
+							  const unsigned char* mask) {
+  ComputeColumns<Operation, FirstStride, SecondStride>(dest, first, second, length, mask);
+}
+
+
+
+template <class T>
+template <class Operation, unsigned int FirstStride, unsigned int SecondStride>
+VUWLGP_KERNEL_TARGET("avx512f,avx512bw")
+void VUWLGP::IInstructionOperation<T>::ComputeColumnsAvx512(T* dest, const T* first,
+							    const T* second,
+							    unsigned int length,
+							    const unsigned char* mask) {
+  ComputeColumns<Operation, FirstStride, SecondStride>(dest, first, second, length, mask);
+}
+
+
+
+template <class T>
+template <class Operation>
+void VUWLGP::IInstructionOperation<T>::HoldsColumns(const Column& first, const Column& second,
+						    unsigned int length, unsigned char* mask) {
+  // Every case is tested, even those mask is already clear for, so there are no branches.
+  // The columns are copied first, as mask could alias them as far as compilers know:
+  const T* firstValues = first.values;
+  const T* secondValues = second.values;
+  unsigned int firstStride = first.stride;
+  unsigned int secondStride = second.stride;
+  for(unsigned int i = 0; i < length; ++i) {
+    mask[i] &= Operation::Holds(firstValues[i * firstStride],
+				secondValues[i * secondStride]) ? 1 : 0;
+  }
+}
+
+
+
+template <class T>
+template <class Operation>
+VUWLGP_KERNEL_TARGET("avx2")
+void VUWLGP::IInstructionOperation<T>::HoldsColumnsAvx2(const Column& first,
+							const Column& second,
+							unsigned int length,
+							unsigned char* mask) {
+  HoldsColumns<Operation>(first, second, length, mask);
+}
+
+
+
+template <class T>
+template <class Operation>
+VUWLGP_KERNEL_TARGET("avx512f,avx512bw")
+void VUWLGP::IInstructionOperation<T>::HoldsColumnsAvx512(const Column& first,
+							  const Column& second,
+							  unsigned int length,
+							  unsigned char* mask) {
+  HoldsColumns<Operation>(first, second, length, mask);
+}
 #endif
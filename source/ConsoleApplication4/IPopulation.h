@@ -4,17 +4,36 @@
 #define IPOPULATION_H
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
 #include <fstream>
 #include <iomanip>
 #include <map>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "BatchProgram.h"
 #include "Config.h"
+#include "EngineAutotuner.h"
 #include "FitnessEnvironment.h"
+#include "ICompiledProgram.h"
 #include "Instruction.h"
+#include "LockstepEvaluator.h"
+#include "LogWriter.h"
+#include "OpcodeProfile.h"
+#include "ProgramSerialiser.h"
+#include "Rand.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 namespace VUWLGP {
   // Forward declarations:
@@ -31,12 +50,18 @@ namespace VUWLGP {
 
     // Evolves the population for up to the maximum number of generations against the fitness
     // cases in the FitnessEnvironment passed to it as a parameter. Returns true if a perfect
-    // solution (fitness < epsilon) is found, otherwise false.
+    // solution (fitness < epsilon) is found, otherwise false. If a checkpoint has been loaded
+    // evolution carries on from the generation after the checkpoint's. A checkpoint is saved
+    // to Config::checkpointFilePath every Config::checkpointInterval generations. If
+    // Config::autotune is set, the way generations are evaluated is tuned first, unless it
+    // already has been (see Autotune).
     virtual unsigned int Evolve(FitnessEnvironment<T>& fe);
 
     // Updates the fitness of all programs which currently have false fitness-is-correct status
     // flags. After this method is called all programs in this population will have their
-    // fitness values set correctly.
+    // fitness values set correctly. If Config::evaluationChunkSize or evaluationTileSize is
+    // set, or the programs are evaluated in lockstep (see UsesLockstep) or compiled, they are
+    // evaluated a block of cases at a time, see EvaluateInChunks.
     virtual void EvaluateFlaggedPrograms(FitnessEnvironment<T>& fe);
 
     // Returns true if a program with fitness <= epsilon exists.
@@ -76,16 +101,34 @@ namespace VUWLGP {
     // population. Also sorts the programs into fitness ascending (fittest first) order. 
     IProgramSubclass* GetFittestProgram();
 
+    // Appends pointers to the n fittest programs to addTo (fittest first). The population 
+    // retains ownership of them. Also sorts the programs into fitness ascending order.
+    void GetFittestPrograms(unsigned int n, std::vector<const IProgramSubclass*>& addTo);
+
+    // Replaces the least fit programs in the population with the programs in immigrants,
+    // e.g. when individuals migrate in from another population. The population takes 
+    // ownership of the immigrants.
+    void ReplaceLeastFit(const std::vector<IProgramSubclass*>& immigrants);
+
     // This method calls the statistics logging and full population logging functions. The 
     // method assumes the fitnesses are all correct and that the introns are correctly marked.
-    // Not const because LogStatistics isn't.
+    // Not const because LogStatistics isn't. If Config::asyncLogging is set, or the population
+    // is dumped to a history (see Config::popLogFormat), both logs are written by a LogWriter
+    // thread instead (LogStatistics and LogPopulation aren't called), and this method only
+    // takes a snapshot of the population. Also appends a metrics record (see LogMetrics) for
+    // generation 0.
     virtual void Log(std::string identifier);
 
     // Logs the statistics and sometimes the population, depending on the value of gen. The 
     // method assumes the fitnesses are all correct and that the introns are correctly marked.
-    // Not const because LogStatistics isn't.
+    // Not const because LogStatistics isn't. Also appends a metrics record for generation gen.
     virtual void Log(unsigned int gen);
 
+    // Waits for the LogWriter, if there is one, to write every log submitted so far. Throws a
+    // std::string if it couldn't write one. Returns the number of logs it dropped because it
+    // fell behind (see Config::dropLogsWhenBehind).
+    unsigned int FlushLogs();
+
     // Evolutionary Operators:
     IProgramSubclass* MacroMutation() const;
     IProgramSubclass* MicroMutation() const;
@@ -95,6 +138,31 @@ namespace VUWLGP {
     IProgramSubclass* AddRandomInstruction() const;
     IProgramSubclass* RemoveRandomInstruction() const;
     
+    // Writes the programs (with their fitnesses and intron flags), generation, the parameters
+    // which must match to load it and the state of the calling thread's random number
+    // generator to filePath, so that a run can be resumed exactly where it left off. The file
+    // is written to filePath + ".tmp" and then renamed over filePath, so filePath always holds
+    // a complete checkpoint even if the process dies while one is being written.
+    void SaveCheckpoint(const std::string& filePath, unsigned int generation) const;
+
+    // Replaces the programs in this population with those in the checkpoint at filePath,
+    // restores the calling thread's random number generator to its state when the checkpoint
+    // was saved and makes Evolve carry on from the generation after the checkpoint's. Throws
+    // a std::string if the file can't be read or was saved with an incompatible Config.
+    // Returns the generation the checkpoint was saved in.
+    unsigned int LoadCheckpoint(const std::string& filePath);
+
+    // The generation Evolve starts from - 0 unless a checkpoint has been loaded.
+    unsigned int StartGeneration() const { return startGeneration; }
+
+    // The counts of the opcode pairs and triples in the plans the "plan" evaluation engine has
+    // compiled so far (see Config::evaluationEngine).
+    const OpcodeProfile<T>& StepProfile() const { return stepProfile; }
+
+    // What the last Autotune chose and how, e.g. "batch, tile size 0, 4 threads (timed)", or
+    // an empty string if the population hasn't been tuned.
+    const std::string& TuningDecision() const { return tuningDecision; }
+
     // Returns a string representation of each program in the population. The fitness of each
     // program can optionally be printed, and the instructions which are currently marked as 
     // introns in each program will be commented out if the second parameter is true.
@@ -112,6 +180,66 @@ namespace VUWLGP {
     // whatever is already at filePath. The method assumes the fitnesses are all correct and
     // that the introns are correctly marked.
     virtual void LogPopulation(std::string filePath) const;
+
+    // Hands a snapshot of the population to the LogWriter, which writes the statistics log
+    // entry and, if popFilePath isn't empty, the population dump. Sorts the programs fittest
+    // first, as LogStatistics does, so evolution carries on exactly as it would have. last
+    // must be set for the run's last log (of its final generation or the one a solution was
+    // found in), which is never dropped, so the final best program is always logged.
+    void LogAsynchronously(const std::string& identifier, const std::string& popFilePath,
+			   bool last);
+
+    // Unless Config::metricsFormat is "none", appends one CSV line or JSON object to the
+    // metrics file (kept open between calls) with a single write: the generation, the number of
+    // evaluations so far, the best, mean and median fitness, the mean and maximum total and
+    // effective (non-intron) length, the number of distinct programs, the time spent breeding
+    // and evaluating the generation and logseconds spent on the other logs, the time since the
+    // previous record and, if Config::metricsBestProgram is set, the best program's text. CSV
+    // files get a header line when they are created. The method assumes the fitnesses are all
+    // correct and that the introns are correctly marked.
+    virtual void LogMetrics(unsigned int generation, double logSeconds);
+
+    // The two halves of LogMetrics, so the record can be written after a lock on the
+    // programs is released: MetricsRecord returns the record (empty if Config::metricsFormat
+    // is "none") and sets header to the CSV header line, and AppendMetrics appends record to
+    // the metrics file, after header if the file is a new CSV file, throwing a std::string if
+    // it can't.
+    std::string MetricsRecord(unsigned int generation, double logSeconds, std::string& header);
+    void AppendMetrics(const std::string& record, const std::string& header);
+
+    // Returns true if Config::evaluationEngine means whole generations should be evaluated
+    // against fe with LockstepEvaluators. Throws a std::string if it names an unknown engine.
+    bool UsesLockstep(const FitnessEnvironment<T>& fe) const;
+
+    // Updates the fitness of the flagged programs against Config::evaluationChunkSize cases of
+    // fe at a time (or all of them at once, if it is 0): every program is evaluated against
+    // one block of cases before any is evaluated against the next. The next block is
+    // prefetched while one is evaluated and released once it has been, so only about two
+    // blocks of a mapped dataset need to be in memory at once. Within a block, batches of
+    // Config::evaluationProgramBatch programs are shared among Config::NumberOfThreads()
+    // threads, and each batch is run over Config::evaluationTileSize cases at a time (see
+    // EvaluateTiles). In lockstep the programs are sorted by effective length and each batch
+    // is run by LockstepEvaluators of programs of similar lengths (and, with the "auto"
+    // engine, the programs they can't run by BatchPrograms). With the "plan" engine each
+    // program is compiled into an ExecutionPlan, fused with the superinstructions stepProfile
+    // chooses from the plans of the generations before, with the "compiled" engine by
+    // Config::programCompiler, and with the "batch" engine into a BatchProgram. Each program
+    // adds up its errors in the same order as UpdateFitness, so the fitnesses are exactly the
+    // same.
+    void EvaluateInChunks(FitnessEnvironment<T>& fe);
+
+    // Sets Config::evaluationEngine, evaluationTileSize and numThreads to the setting which
+    // evaluates the population against fe fastest - the EngineAutotuner's cached decision for
+    // this machine and problem shape, if it has one, otherwise the fastest found by timing
+    // the candidates on the population, which is then cached. Each part of the setting is
+    // chosen in turn, the engine first, keeping the best of the others so far. The
+    // candidates share Config::autotuneSeconds, and are timed on as many of the programs as
+    // the first can evaluate in its share. Each trial is given an equal share of what is left
+    // of the budget, so the retries with smaller samples come out of the later trials' time
+    // rather than adding to it. The trial evaluations are neither counted nor
+    // kept, so the population is left as it was, and the run goes on exactly as it would
+    // have, if at a different speed.
+    void Autotune(FitnessEnvironment<T>& fe);
     
 
     // The bool in each pair indicates whether or not the associated program has been changed
@@ -119,6 +247,58 @@ namespace VUWLGP {
     std::vector<IProgram<T>*> programs;
 
     Config<T>* config;
+
+    unsigned int startGeneration;
+
+    LogWriter<T>* logWriter; // created by the first asynchronous Log
+
+    // For the metrics - the environment the programs were last evaluated against and the time
+    // spent breeding and evaluating the latest generation, set by Evolve (left 0 by loops
+    // which interleave the two):
+    const FitnessEnvironment<T>* evaluationEnvironment;
+    double breedSeconds;
+    double evaluateSeconds;
+
+    OpcodeProfile<T> stepProfile; // counted by EvaluateInChunks for the "plan" engine
+    std::string tuningDecision;
+
+  private:
+    // Returns an equal share, for each of numTrials trials, of the part of
+    // Config::autotuneSeconds which hasn't passed since start.
+    double TuningShare(std::chrono::steady_clock::time_point start,
+		       unsigned int numTrials) const;
+
+    // Returns the shortest time, in seconds, which evaluating the first sampleSize programs
+    // against fe with setting takes, repeating the evaluation until seconds have passed (at
+    // least once). Leaves the programs flagged for evaluation.
+    double TimeEvaluation(FitnessEnvironment<T>& fe, unsigned int sampleSize,
+			  const typename EngineAutotuner<T>::Setting& setting, double seconds);
+
+    // Takes batches of batchSize programs in turn (batch nextBatch, which is shared between
+    // threads) until there are none left, and accumulates each batch's error on cases
+    // [begin, end) of fe, tileSize cases at a time: every program in the batch is run over one
+    // tile before any is run over the next. Program i is run by (*groups)[i / Lanes] if there
+    // is one, so batchSize must be a multiple of Lanes, otherwise by (*compiled)[i] if there
+    // is one, otherwise by the interpreter. Catches anything thrown (a std::string, or a
+    // std::exception's what()) into error.
+    static void EvaluateTiles(FitnessEnvironment<T>* fe,
+			      const std::vector<IProgram<T>*>* programs,
+			      const std::vector<LockstepEvaluator<T>*>* groups,
+			      const std::vector<ICompiledProgram<T>*>* compiled,
+			      std::atomic<unsigned int>* nextBatch, unsigned int batchSize,
+			      unsigned int begin, unsigned int end, unsigned int tileSize,
+			      std::string* error);
+
+    // The parameters a checkpoint records and checks when it is loaded, in order:
+    static std::vector<unsigned int> CheckpointParameters(const Config<T>* c);
+
+    // Appends value (with the given number of significant figures) to record, as a field
+    // called name if json is set, otherwise as a CSV column with its name appended to header.
+    static void AppendMetric(const char* name, double value, int precision, bool json,
+			     std::string& header, std::string& record);
+
+    FILE* metricsFile; // opened by the first AppendMetrics
+    std::chrono::steady_clock::time_point lastMetricsTime;
   };
 
 
@@ -146,7 +326,14 @@ namespace VUWLGP {
 ////////////////////////////////// Inline Function Definitions ////////////////////////////////
 template <class IProgramSubclass, class T> 
 VUWLGP::IPopulation<IProgramSubclass, T>::IPopulation(VUWLGP::Config<T>* conf):
-config(conf) {
+config(conf),
+startGeneration(0),
+logWriter(0),
+evaluationEnvironment(0),
+breedSeconds(0),
+evaluateSeconds(0),
+metricsFile(0),
+lastMetricsTime(std::chrono::steady_clock::now()) {
   programs.reserve(config->populationSize);
 
   // Now construct the programs, uniformly distributed in size over the range of sizes specified
@@ -166,6 +353,11 @@ config(conf) {
 
 template <class IProgramSubclass, class T>
 VUWLGP::IPopulation<IProgramSubclass, T>::~IPopulation() {
+  delete logWriter; // finishes writing any logs still queued
+  if(metricsFile != 0) {
+    std::fclose(metricsFile);
+  }
+
   for(unsigned int i = 0; i < programs.size(); ++i) {
     delete programs[i];
   }
@@ -175,16 +367,34 @@ VUWLGP::IPopulation<IProgramSubclass, T>::~IPopulation() {
 
 template <class IProgramSubclass, class T> unsigned int 
 VUWLGP::IPopulation<IProgramSubclass, T>::Evolve(VUWLGP::FitnessEnvironment<T>& fe) {
-  EvaluateFlaggedPrograms(fe);
-  Log("initial");
+  if(config->autotune && tuningDecision.empty()) {
+    Autotune(fe);
+  }
+  evaluationEnvironment = &fe;
+
+  if(startGeneration == 0) {
+    EvaluateFlaggedPrograms(fe);
+    Log("initial");
  
-  if(SolutionExists()) { return 0; }
+    if(SolutionExists()) { return 0; }
+  }
 
-  for(unsigned int generation = 1; generation <= config->maxGenerations; ++generation) {
+  for(unsigned int generation = startGeneration + 1; generation <= config->maxGenerations;
+      ++generation) {
+     std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
      IteratePopulation();
+     std::chrono::steady_clock::time_point bred = std::chrono::steady_clock::now();
      EvaluateFlaggedPrograms(fe);
+     breedSeconds = std::chrono::duration<double>(bred - start).count();
+     evaluateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - bred)
+       .count();
+
      Log(generation);
      if(SolutionExists()) { return generation; }
+
+     if(config->checkpointInterval != 0 && generation % config->checkpointInterval == 0) {
+       SaveCheckpoint(config->checkpointFilePath + ".bin", generation);
+     }
   }
 
   return config->maxGenerations + 1;
@@ -194,6 +404,13 @@ VUWLGP::IPopulation<IProgramSubclass, T>::Evolve(VUWLGP::FitnessEnvironment<T>&
 
 template <class IProgSub, class T> void
 VUWLGP::IPopulation<IProgSub, T>::EvaluateFlaggedPrograms(VUWLGP::FitnessEnvironment<T>& fe) {
+  evaluationEnvironment = &fe;
+  if(config->evaluationChunkSize != 0 || config->evaluationTileSize != 0 ||
+     UsesLockstep(fe) || config->evaluationEngine != "interpreter") {
+    EvaluateInChunks(fe);
+    return;
+  }
+
   for(unsigned int i = 0; i < Size(); ++i) {
     if(!programs[i]->FitnessStatusReference()) {
       programs[i]->UpdateFitness(fe);
@@ -203,6 +420,335 @@ VUWLGP::IPopulation<IProgSub, T>::EvaluateFlaggedPrograms(VUWLGP::FitnessEnviron
 
 
 
+template <class IProgSub, class T> bool
+VUWLGP::IPopulation<IProgSub, T>::UsesLockstep(const VUWLGP::FitnessEnvironment<T>& fe) const {
+  std::string engine = config->EvaluationEngineFor(fe.NumberOfCases());
+  if(engine != "lockstep" && engine != "interpreter" && engine != "plan" &&
+     engine != "compiled" && engine != "batch") {
+    throw std::string("Unknown evaluation engine: ") + engine;
+  }
+  return engine == "lockstep";
+}
+
+
+
+template <class IProgSub, class T> void
+VUWLGP::IPopulation<IProgSub, T>::EvaluateInChunks(VUWLGP::FitnessEnvironment<T>& fe) {
+  std::vector<IProgram<T>*> flagged;
+  for(unsigned int i = 0; i < Size(); ++i) {
+    if(!programs[i]->FitnessStatusReference()) {
+      programs[i]->ZeroFitness();
+      programs[i]->MarkIntrons();
+      flagged.push_back(programs[i]);
+    }
+  }
+
+  if(flagged.empty()) {
+    return;
+  }
+  if(fe.NumberOfCases() == 0) {
+    throw std::string("No fitness cases in fe to evaluate against");
+  }
+
+  // In lockstep, the programs the evaluators can run come first, in order of effective
+  // length, and are grouped Lanes at a time:
+  unsigned int batchSize = std::max(1u, config->evaluationProgramBatch);
+  std::vector<LockstepEvaluator<T>*> groups;
+  if(UsesLockstep(fe)) {
+    const unsigned int lanes = LockstepEvaluator<T>::Lanes;
+    std::vector<std::pair<unsigned int, unsigned int> > order; // (length, index)
+    std::vector<IProgram<T>*> others;
+    for(unsigned int i = 0; i < flagged.size(); ++i) {
+      if(LockstepEvaluator<T>::CanEvaluate(*flagged[i])) {
+	order.push_back(std::make_pair(LockstepEvaluator<T>::EffectiveLength(*flagged[i]), i));
+      }
+      else {
+	others.push_back(flagged[i]);
+      }
+    }
+    std::sort(order.begin(), order.end());
+
+    std::vector<IProgram<T>*> sorted;
+    for(unsigned int i = 0; i < order.size(); ++i) {
+      sorted.push_back(flagged[order[i].second]);
+    }
+    for(unsigned int i = 0; i < sorted.size(); i += lanes) {
+      groups.push_back(new LockstepEvaluator<T>(&sorted[i],
+						std::min<unsigned int>(lanes, sorted.size() - i),
+						config));
+    }
+    sorted.insert(sorted.end(), others.begin(), others.end());
+    flagged.swap(sorted);
+
+    batchSize = (batchSize + lanes - 1) / lanes * lanes;
+  }
+
+  // The plan engine fuses the superinstructions chosen before this generation is counted, so
+  // the choice doesn't depend on the order the programs are compiled in:
+  std::string engine = config->EvaluationEngineFor(fe.NumberOfCases());
+  std::vector<ICompiledProgram<T>*> compiled;
+  if(engine == "plan") {
+    std::vector<bool> fused = stepProfile.Choose(config->fusionThreshold);
+    for(unsigned int i = 0; i < flagged.size(); ++i) {
+      ExecutionPlan<T>* plan = 0;
+      if(ExecutionPlan<T>::CanCompile(*flagged[i])) {
+	plan = new ExecutionPlan<T>(*flagged[i], config);
+	plan->Optimise(config);
+	stepProfile.Count(*plan);
+	plan->Fuse(fused);
+      }
+      compiled.push_back(plan);
+    }
+  }
+  else if(engine == "compiled") {
+    if(!config->programCompiler) {
+      throw std::string("The compiled evaluation engine needs Config::programCompiler");
+    }
+    for(unsigned int i = 0; i < flagged.size(); ++i) {
+      compiled.push_back(config->programCompiler(*flagged[i], config));
+    }
+  }
+  else if(engine == "batch") {
+    for(unsigned int i = 0; i < flagged.size(); ++i) {
+      compiled.push_back(BatchProgram<T>::Compile(*flagged[i], config));
+    }
+  }
+  else if(engine == "lockstep" && config->evaluationEngine == "auto") {
+    // The programs the evaluators can't run, after the grouped ones, are run as BatchPrograms:
+    for(unsigned int i = 0; i < flagged.size(); ++i) {
+      bool grouped = LockstepEvaluator<T>::CanEvaluate(*flagged[i]);
+      compiled.push_back(grouped ? 0 : BatchProgram<T>::Compile(*flagged[i], config));
+    }
+  }
+
+  // Each thread evaluates against its own copy of fe, as the copies share fe's cases:
+  unsigned int numBatches = (flagged.size() + batchSize - 1) / batchSize;
+  unsigned int numThreads = std::min(config->NumberOfThreads(), numBatches);
+  std::vector<FitnessEnvironment<T>*> environments;
+  for(unsigned int i = 0; i < numThreads || i == 0; ++i) {
+    environments.push_back(new FitnessEnvironment<T>(fe));
+  }
+
+  std::string error;
+  unsigned int numCases = fe.NumberOfCases();
+  unsigned int chunkSize = config->evaluationChunkSize != 0 ? config->evaluationChunkSize :
+    numCases;
+  unsigned int tileSize = config->evaluationTileSize != 0 ? config->evaluationTileSize :
+    chunkSize;
+  fe.PrefetchCases(0, std::min(chunkSize, numCases));
+  for(unsigned int begin = 0; begin < numCases && error.empty(); ) {
+    unsigned int end = numCases - begin > chunkSize ? begin + chunkSize : numCases;
+    fe.PrefetchCases(end, numCases - end > chunkSize ? end + chunkSize : numCases);
+
+    std::atomic<unsigned int> nextBatch(0);
+    std::vector<std::thread> threads;
+    std::vector<std::string> errors(environments.size());
+    for(unsigned int i = 1; i < environments.size(); ++i) {
+      threads.push_back(std::thread(&IPopulation<IProgSub, T>::EvaluateTiles, environments[i],
+				    &flagged, &groups, &compiled, &nextBatch, batchSize, begin,
+				    end, tileSize, &errors[i]));
+    }
+    EvaluateTiles(environments[0], &flagged, &groups, &compiled, &nextBatch, batchSize, begin,
+		  end, tileSize, &errors[0]);
+
+    for(unsigned int i = 0; i < threads.size(); ++i) {
+      threads[i].join();
+    }
+    for(unsigned int i = 0; i < errors.size() && error.empty(); ++i) {
+      error = errors[i];
+    }
+
+    fe.ReleaseCases(begin, end);
+    begin = end;
+  }
+
+  for(unsigned int i = 0; i < environments.size(); ++i) {
+    delete environments[i];
+  }
+  for(unsigned int i = 0; i < groups.size(); ++i) {
+    delete groups[i];
+  }
+  for(unsigned int i = 0; i < compiled.size(); ++i) {
+    delete compiled[i];
+  }
+  if(!error.empty()) {
+    throw error;
+  }
+
+  // The programs' fitness measures now have the correct fitness values:
+  for(unsigned int i = 0; i < flagged.size(); ++i) {
+    flagged[i]->FitnessStatusReference() = true;
+    fe.CountEvaluation();
+  }
+}
+
+
+
+template <class IProgSub, class T> void
+VUWLGP::IPopulation<IProgSub, T>::Autotune(VUWLGP::FitnessEnvironment<T>& fe) {
+  typedef typename EngineAutotuner<T>::Setting Setting;
+  EngineAutotuner<T> tuner(config, fe, Size());
+  Setting best;
+  if(tuner.Load(best)) {
+    EngineAutotuner<T>::Apply(best, config);
+    tuningDecision = best.ToString() + " (from " + config->tuningCacheFilePath + ")";
+    return;
+  }
+
+  // The trials run against a copy of fe which counts its evaluations apart, and the
+  // programs' flags are put back afterwards:
+  FitnessEnvironment<T> trial(fe);
+  trial.CountEvaluationsSeparately();
+  std::vector<bool> evaluated(Size());
+  for(unsigned int i = 0; i < Size(); ++i) {
+    evaluated[i] = programs[i]->FitnessStatusReference();
+  }
+
+  std::vector<std::string> engines = tuner.Engines();
+  std::vector<unsigned int> tileSizes = tuner.TileSizes();
+  std::vector<unsigned int> threadCounts = tuner.ThreadCounts();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  unsigned int numTrials = 1 + engines.size() + tileSizes.size() + threadCounts.size();
+  double share = config->autotuneSeconds / numTrials;
+
+  // The sample is halved until the current setting can evaluate it in its share:
+  best = EngineAutotuner<T>::Current(config, fe);
+  unsigned int sampleSize = Size();
+  double bestSeconds = TimeEvaluation(trial, sampleSize, best, TuningShare(start, numTrials));
+  while(bestSeconds > share && sampleSize > 1) {
+    sampleSize = (sampleSize + 1) / 2;
+    bestSeconds = TimeEvaluation(trial, sampleSize, best, TuningShare(start, numTrials));
+  }
+  --numTrials;
+
+  for(unsigned int part = 0; part < 3; ++part) {
+    unsigned int numCandidates = part == 0 ? engines.size() :
+      part == 1 ? tileSizes.size() : threadCounts.size();
+    Setting fastest = best;
+    for(unsigned int i = 0; i < numCandidates; ++i) {
+      Setting candidate = best;
+      if(part == 0) {
+	candidate.engine = engines[i];
+      }
+      else if(part == 1) {
+	candidate.tileSize = tileSizes[i];
+      }
+      else {
+	candidate.numThreads = threadCounts[i];
+      }
+
+      double seconds = TimeEvaluation(trial, sampleSize, candidate,
+				      TuningShare(start, numTrials--));
+      if(seconds < bestSeconds) {
+	fastest = candidate;
+	bestSeconds = seconds;
+      }
+    }
+    best = fastest;
+  }
+
+  for(unsigned int i = 0; i < Size(); ++i) {
+    programs[i]->FitnessStatusReference() = evaluated[i];
+  }
+  stepProfile = OpcodeProfile<T>();
+  EngineAutotuner<T>::Apply(best, config);
+  tuner.Save(best);
+
+  std::ostringstream buffer;
+  buffer << best.ToString() << " (timed on " << sampleSize << " programs)";
+  tuningDecision = buffer.str();
+}
+
+
+
+template <class IProgSub, class T> double
+VUWLGP::IPopulation<IProgSub, T>::TuningShare(std::chrono::steady_clock::time_point start,
+					      unsigned int numTrials) const {
+  double passed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+    .count();
+  return std::max(0.0, config->autotuneSeconds - passed) / std::max(1u, numTrials);
+}
+
+
+
+template <class IProgSub, class T> double
+VUWLGP::IPopulation<IProgSub, T>::TimeEvaluation(
+  VUWLGP::FitnessEnvironment<T>& fe, unsigned int sampleSize,
+  const typename VUWLGP::EngineAutotuner<T>::Setting& setting, double seconds) {
+  EngineAutotuner<T>::Apply(setting, config);
+
+  double shortest = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for(unsigned int repetition = 0; ; ++repetition) {
+    for(unsigned int i = 0; i < Size(); ++i) {
+      programs[i]->FitnessStatusReference() = i >= sampleSize;
+    }
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    IPopulation<IProgSub, T>::EvaluateFlaggedPrograms(fe);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    double taken = std::chrono::duration<double>(end - begin).count();
+    shortest = repetition == 0 ? taken : std::min(shortest, taken);
+    if(std::chrono::duration<double>(end - start).count() >= seconds) {
+      break;
+    }
+  }
+
+  for(unsigned int i = 0; i < sampleSize; ++i) {
+    programs[i]->FitnessStatusReference() = false;
+  }
+  return shortest;
+}
+
+
+
+template <class IProgSub, class T> void
+VUWLGP::IPopulation<IProgSub, T>::EvaluateTiles(VUWLGP::FitnessEnvironment<T>* fe,
+						const std::vector<IProgram<T>*>* programs,
+						const std::vector<LockstepEvaluator<T>*>* groups,
+						const std::vector<ICompiledProgram<T>*>* compiled,
+						std::atomic<unsigned int>* nextBatch,
+						unsigned int batchSize, unsigned int begin,
+						unsigned int end, unsigned int tileSize,
+						std::string* error) {
+  try {
+    for(unsigned int batch = (*nextBatch)++; batch * batchSize < programs->size();
+	batch = (*nextBatch)++) {
+      unsigned int first = batch * batchSize;
+      unsigned int last = std::min<unsigned int>(first + batchSize, programs->size());
+
+      for(unsigned int tile = begin; tile < end; ) {
+	unsigned int tileEnd = end - tile > tileSize ? tile + tileSize : end;
+	fe->SetWindow(tile, tileEnd);
+	for(unsigned int i = first; i < last; ) {
+	  const unsigned int lanes = LockstepEvaluator<T>::Lanes;
+	  if(i % lanes == 0 && i / lanes < groups->size()) {
+	    (*groups)[i / lanes]->AccumulateErrors(*fe);
+	    i += (*groups)[i / lanes]->NumberOfPrograms();
+	  }
+	  else if(!compiled->empty() && (*compiled)[i]) {
+	    (*compiled)[i]->AccumulateError(*(*programs)[i], *fe);
+	    ++i;
+	  }
+	  else {
+	    (*programs)[i++]->AccumulateError(*fe);
+	  }
+	}
+	tile = tileEnd;
+      }
+    }
+  }
+  catch(const std::string& e) {
+    *error = e;
+  }
+  catch(const std::exception& e) {
+    *error = std::string("IPopulation - ") + e.what();
+  }
+}
+
+
+
 template <class IProgramSubclass, class T>
 bool VUWLGP::IPopulation<IProgramSubclass, T>::SolutionExists() const {
   for(unsigned int i = 0; i < Size(); ++i) {
@@ -247,10 +793,49 @@ IProgramSubclass* VUWLGP::IPopulation<IProgramSubclass, T>::GetFittestProgram()
 
 
 
+template <class IProgramSubclass, class T> void
+VUWLGP::IPopulation<IProgramSubclass, T>::GetFittestPrograms(unsigned int n,
+							     std::vector<const IProgramSubclass*>& addTo) {
+  SortFittestFirst();
+  for(unsigned int i = 0; i < n && i < Size(); ++i) {
+    addTo.push_back(dynamic_cast<IProgramSubclass*>(programs[i]));
+  }
+}
+
+
+
+template <class IProgramSubclass, class T> void
+VUWLGP::IPopulation<IProgramSubclass, T>::ReplaceLeastFit(const std::vector<IProgramSubclass*>& 
+							  immigrants) {
+  SortFittestLast();
+  for(unsigned int i = 0; i < immigrants.size(); ++i) {
+    if(i < Size()) {
+      delete programs[i];
+      programs[i] = immigrants[i];
+    }
+    else {
+      delete immigrants[i]; // more immigrants than programs, so there is no room for them
+    }
+  }
+}
+
+
+
 template <class IProgramSubclass, class T>
 void VUWLGP::IPopulation<IProgramSubclass, T>::Log(std::string identifier) {
-  this->LogStatistics(config->statsLogFilePath + ".txt", identifier);
-  this->LogPopulation(config->popLogFilePath + "." + identifier + ".txt");
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  if(config->asyncLogging || config->popLogFormat != "text") {
+    LogAsynchronously(identifier, config->popLogFilePath + "." + identifier + ".txt",
+		      SolutionExists());
+  }
+  else {
+    this->LogStatistics(config->statsLogFilePath + ".txt", identifier);
+    this->LogPopulation(config->popLogFilePath + "." + identifier + ".txt");
+  }
+
+  this->LogMetrics(0, std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+		   .count());
 }
 
 
@@ -260,12 +845,23 @@ void VUWLGP::IPopulation<IProgramSubclass, T>::Log(unsigned int gen) {
   std::ostringstream conv;
   conv << gen;
   std::string genString = conv.str();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
-  this->LogStatistics((config->statsLogFilePath + ".txt").c_str(), genString);
+  if(config->asyncLogging || config->popLogFormat != "text") {
+    LogAsynchronously(genString, gen % config->popLogInterval == 0 ?
+		      config->popLogFilePath + "." + genString + ".txt" : "",
+		      gen >= config->maxGenerations || SolutionExists());
+  }
+  else {
+    this->LogStatistics((config->statsLogFilePath + ".txt").c_str(), genString);
 
-  if(gen % config->popLogInterval == 0) {
-    this->LogPopulation(config->popLogFilePath + "." + genString + ".txt");
+    if(gen % config->popLogInterval == 0) {
+      this->LogPopulation(config->popLogFilePath + "." + genString + ".txt");
+    }
   }
+
+  this->LogMetrics(gen, std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+		   .count());
 }
 
 
@@ -312,6 +908,366 @@ VUWLGP::IPopulation<IProgramSubclass, T>::LogPopulation(std::string filePath) co
 
 
 
+template <class IProgramSubclass, class T> void
+VUWLGP::IPopulation<IProgramSubclass, T>::LogMetrics(unsigned int generation,
+						     double logSeconds) {
+  std::string header;
+  std::string record = MetricsRecord(generation, logSeconds, header);
+  AppendMetrics(record, header);
+}
+
+
+
+template <class IProgramSubclass, class T> std::string
+VUWLGP::IPopulation<IProgramSubclass, T>::MetricsRecord(
+  unsigned int generation, double logSeconds, std::string& header) {
+  if(config->metricsFormat == "none" || Size() == 0) {
+    return "";
+  }
+
+  bool json = config->metricsFormat == "jsonl";
+  if(!json && config->metricsFormat != "csv") {
+    throw std::string("Unknown metrics format: ") + config->metricsFormat;
+  }
+
+  // Gather everything in one pass over the programs:
+  double fitnessSum = 0;
+  double lengthSum = 0;
+  double effectiveLengthSum = 0;
+  unsigned int maxLength = 0;
+  unsigned int maxEffectiveLength = 0;
+  unsigned int best = 0;
+  std::vector<double> fitnesses;
+  fitnesses.reserve(Size());
+
+  // Programs are distinct if their instructions or fitnesses differ, as in LogStatistics:
+  ProgramSerialiser<T> serialiser(config);
+  std::unordered_set<std::string> distinctPrograms;
+  std::vector<unsigned char> serialised;
+
+  for(unsigned int i = 0; i < Size(); ++i) {
+    double fitness = programs[i]->Fitness();
+    fitnesses.push_back(fitness);
+    fitnessSum += fitness;
+    if(fitness < fitnesses[best]) {
+      best = i;
+    }
+
+    const std::vector<Instruction<T>*>& instrs =
+      programs[i]->ConstRawAccessToTheInternalInstructions();
+    unsigned int effectiveLength = 0;
+    for(unsigned int j = 0; j < instrs.size(); ++j) {
+      effectiveLength += instrs[j]->IsIntron ? 0 : 1;
+    }
+    lengthSum += instrs.size();
+    effectiveLengthSum += effectiveLength;
+    maxLength = std::max(maxLength, static_cast<unsigned int>(instrs.size()));
+    maxEffectiveLength = std::max(maxEffectiveLength, effectiveLength);
+
+    serialised.clear();
+    serialiser.Write(*programs[i], serialised);
+    distinctPrograms.insert(std::string(serialised.begin(), serialised.end()));
+  }
+
+  unsigned int middle = Size() / 2;
+  std::nth_element(fitnesses.begin(), fitnesses.begin() + middle, fitnesses.end());
+  double median = fitnesses[middle];
+  if(Size() % 2 == 0) {
+    median = (median + *std::max_element(fitnesses.begin(), fitnesses.begin() + middle)) / 2;
+  }
+
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  double elapsed = std::chrono::duration<double>(now - lastMetricsTime).count();
+  lastMetricsTime = now;
+
+  header.clear();
+  std::string record = json ? "{" : "";
+  AppendMetric("generation", generation, 10, json, header, record);
+  AppendMetric("evaluations", evaluationEnvironment != 0 ?
+	       evaluationEnvironment->Evaluations() : 0, 17, json, header, record);
+  AppendMetric("best_fitness", programs[best]->Fitness(), 17, json, header, record);
+  AppendMetric("mean_fitness", fitnessSum / Size(), 17, json, header, record);
+  AppendMetric("median_fitness", median, 17, json, header, record);
+  AppendMetric("mean_length", lengthSum / Size(), 6, json, header, record);
+  AppendMetric("max_length", maxLength, 10, json, header, record);
+  AppendMetric("mean_effective_length", effectiveLengthSum / Size(), 6, json, header, record);
+  AppendMetric("max_effective_length", maxEffectiveLength, 10, json, header, record);
+  AppendMetric("diversity", distinctPrograms.size(), 10, json, header, record);
+  AppendMetric("breed_seconds", breedSeconds, 6, json, header, record);
+  AppendMetric("evaluate_seconds", evaluateSeconds, 6, json, header, record);
+  AppendMetric("log_seconds", logSeconds, 6, json, header, record);
+  AppendMetric("elapsed_seconds", elapsed, 6, json, header, record);
+
+  if(config->metricsBestProgram) {
+    // Quoted and escaped, as a JSON string or a CSV field:
+    std::string text = programs[best]->ToString(false, true);
+    record += json ? "\"best_program\":\"" : "\"";
+    header += "best_program,";
+    for(std::string::const_iterator c = text.begin(); c != text.end(); ++c) {
+      if(json && (*c == '"' || *c == '\\')) {
+	record += '\\';
+	record += *c;
+      }
+      else if(json && *c == '\n') {
+	record += "\\n";
+      }
+      else if(json && *c == '\t') {
+	record += "\\t";
+      }
+      else {
+	record += *c == '"' ? "\"\"" : std::string(1, *c);
+      }
+    }
+    record += "\",";
+  }
+
+  record[record.size() - 1] = json ? '}' : '\n';
+  record += json ? "\n" : "";
+  header[header.size() - 1] = '\n';
+  return record;
+}
+
+
+
+template <class IProgramSubclass, class T> void
+VUWLGP::IPopulation<IProgramSubclass, T>::AppendMetrics(const std::string& record,
+							const std::string& header) {
+  if(record.empty()) {
+    return;
+  }
+
+  bool json = config->metricsFormat == "jsonl";
+  std::string filePath = config->metricsFilePath + (json ? ".jsonl" : ".csv");
+  if(metricsFile == 0) {
+    metricsFile = std::fopen(filePath.c_str(), "ab");
+    if(metricsFile == 0) {
+      throw "IPopulation::AppendMetrics - could not open " + filePath;
+    }
+
+    std::fseek(metricsFile, 0, SEEK_END);
+    if(!json && std::ftell(metricsFile) == 0 &&
+       std::fwrite(header.data(), 1, header.size(), metricsFile) != header.size()) {
+      throw "IPopulation::AppendMetrics - could not write " + filePath;
+    }
+  }
+
+  bool written = std::fwrite(record.data(), 1, record.size(), metricsFile) == record.size();
+  if(std::fflush(metricsFile) != 0 || !written) {
+    throw "IPopulation::AppendMetrics - could not write " + filePath;
+  }
+}
+
+
+
+// The checkpoint format is: the 8 byte tag "VUWLGPCK", unsigned int version (1), the
+// unsigned int parameters from CheckpointParameters, double epsilon, unsigned int generation,
+// the Rand::State, unsigned int number of programs and then each program as written by
+// ProgramSerialiser. Values are stored in the native byte order.
+template <class IProgramSubclass, class T> void
+VUWLGP::IPopulation<IProgramSubclass, T>::SaveCheckpoint(const std::string& filePath,
+							 unsigned int generation) const {
+  typedef ProgramSerialiser<T> PS;
+  PS serialiser(config);
+  std::vector<unsigned char> out;
+  out.reserve(1024 + Size() * PS::MaximumSize(config->maxLength));
+
+  out.insert(out.end(), "VUWLGPCK", "VUWLGPCK" + 8);
+  PS::template Append<unsigned int>(1, out);
+
+  std::vector<unsigned int> parameters = CheckpointParameters(config);
+  for(unsigned int i = 0; i < parameters.size(); ++i) {
+    PS::template Append<unsigned int>(parameters[i], out);
+  }
+  PS::template Append<double>(config->epsilon, out);
+  PS::template Append<unsigned int>(generation, out);
+  PS::template Append<Rand::State>(Rand::GetState(), out);
+
+  PS::template Append<unsigned int>(Size(), out);
+  for(unsigned int i = 0; i < Size(); ++i) {
+    serialiser.Write(*programs[i], out);
+  }
+
+  // Write the whole thing somewhere else first, so that filePath is only ever replaced by a
+  // complete checkpoint:
+  std::string tempPath = filePath + ".tmp";
+  FILE* file = std::fopen(tempPath.c_str(), "wb");
+  if(file == 0) {
+    throw "IPopulation::SaveCheckpoint - could not open " + tempPath;
+  }
+
+  bool written = std::fwrite(&out[0], 1, out.size(), file) == out.size() &&
+    std::fflush(file) == 0;
+#ifndef _WIN32
+  written = written && fsync(fileno(file)) == 0;
+#endif
+  written = std::fclose(file) == 0 && written;
+
+#ifdef _WIN32
+  std::remove(filePath.c_str()); // rename won't replace an existing file on Windows
+#endif
+  if(!written || std::rename(tempPath.c_str(), filePath.c_str()) != 0) {
+    std::remove(tempPath.c_str());
+    throw "IPopulation::SaveCheckpoint - could not write " + filePath;
+  }
+}
+
+
+
+template <class IProgramSubclass, class T> unsigned int
+VUWLGP::IPopulation<IProgramSubclass, T>::LoadCheckpoint(const std::string& filePath) {
+  typedef ProgramSerialiser<T> PS;
+
+  std::vector<unsigned char> in;
+  FILE* file = std::fopen(filePath.c_str(), "rb");
+  if(file == 0) {
+    throw "IPopulation::LoadCheckpoint - could not open " + filePath;
+  }
+
+  std::fseek(file, 0, SEEK_END);
+  long fileSize = std::ftell(file);
+  std::fseek(file, 0, SEEK_SET);
+  if(fileSize > 0) {
+    in.resize(fileSize);
+  }
+  bool read = fileSize > 0 && std::fread(&in[0], 1, in.size(), file) == in.size();
+  std::fclose(file);
+
+  std::vector<unsigned int> parameters = CheckpointParameters(config);
+  unsigned int headerSize = 8 + (parameters.size() + 3) * sizeof(unsigned int) + 
+    sizeof(double) + sizeof(Rand::State);
+  if(!read || in.size() < headerSize || std::memcmp(&in[0], "VUWLGPCK", 8) != 0) {
+    throw filePath + " is not a checkpoint";
+  }
+
+  unsigned int offset = 8;
+  if(PS::template Extract<unsigned int>(&in[0], offset) != 1) {
+    throw filePath + " is a checkpoint from an unsupported version";
+  }
+
+  for(unsigned int i = 0; i < parameters.size(); ++i) {
+    if(PS::template Extract<unsigned int>(&in[0], offset) != parameters[i]) {
+      throw filePath + " was saved with different numRegisters, numFeatures, maxLength, " +
+	"populationSize, operations or register type to this run";
+    }
+  }
+
+  PS::template Extract<double>(&in[0], offset); // epsilon, informational only
+  unsigned int generation = PS::template Extract<unsigned int>(&in[0], offset);
+  Rand::State state = PS::template Extract<Rand::State>(&in[0], offset);
+  unsigned int numPrograms = PS::template Extract<unsigned int>(&in[0], offset);
+
+  // Read everything before changing anything, so a truncated file leaves this population as
+  // it was:
+  PS serialiser(config);
+  std::vector<IProgram<T>*> loaded;
+  loaded.reserve(numPrograms);
+  try {
+    for(unsigned int i = 0; i < numPrograms; ++i) {
+      loaded.push_back(serialiser.template Read<IProgramSubclass>(&in[0], in.size(), offset));
+    }
+  }
+  catch(const std::string& e) {
+    for(unsigned int i = 0; i < loaded.size(); ++i) {
+      delete loaded[i];
+    }
+    throw filePath + ": " + e;
+  }
+
+  for(unsigned int i = 0; i < programs.size(); ++i) {
+    delete programs[i];
+  }
+  programs.swap(loaded);
+
+  Rand::SetState(state);
+  startGeneration = generation;
+  return generation;
+}
+
+
+
+template <class IProgramSubclass, class T> std::vector<unsigned int>
+VUWLGP::IPopulation<IProgramSubclass, T>::CheckpointParameters(const VUWLGP::Config<T>* c) {
+  std::vector<unsigned int> parameters;
+  parameters.push_back(sizeof(T));
+  parameters.push_back(c->numRegisters);
+  parameters.push_back(c->numFeatures);
+  parameters.push_back(c->maxLength);
+  parameters.push_back(c->populationSize);
+  parameters.push_back(c->instructionOperations->NumberOfElements());
+  return parameters;
+}
+
+
+
+template <class IProgramSubclass, class T> void
+VUWLGP::IPopulation<IProgramSubclass, T>::AppendMetric(const char* name, double value,
+						       int precision, bool json, std::string& header,
+						       std::string& record) {
+  char field[64];
+  if(json && (value != value || value - value != 0)) {
+    std::snprintf(field, sizeof(field), "\"%s\":null,", name); // JSON has no inf or nan
+  }
+  else if(json) {
+    std::snprintf(field, sizeof(field), "\"%s\":%.*g,", name, precision, value);
+  }
+  else {
+    std::snprintf(field, sizeof(field), "%.*g,", precision, value);
+  }
+
+  record += field;
+  header += name;
+  header += ",";
+}
+
+
+
+template <class IProgramSubclass, class T> unsigned int
+VUWLGP::IPopulation<IProgramSubclass, T>::FlushLogs() {
+  if(logWriter == 0) {
+    return 0;
+  }
+  logWriter->Flush();
+  return logWriter->NumberOfDropped();
+}
+
+
+
+template <class IProgramSubclass, class T> void
+VUWLGP::IPopulation<IProgramSubclass, T>::LogAsynchronously(const std::string& identifier,
+							    const std::string& popFilePath,
+							    bool last) {
+  if(logWriter == 0) {
+    logWriter = new LogWriter<T>(config);
+  }
+
+  typename LogWriter<T>::Snapshot snapshot;
+  snapshot.identifier = identifier;
+  snapshot.statsFilePath = config->statsLogFilePath + ".txt";
+  snapshot.popFilePath = popFilePath;
+  snapshot.programs.reserve(Size() *
+			    ProgramSerialiser<T>::MaximumSize(config->initialMaxLength));
+  snapshot.offsets.reserve(Size());
+
+  // The statistics are summed in the current order, the best program and dump are sorted:
+  std::map<const IProgram<T>*, unsigned int> unsortedIndex;
+  for(unsigned int i = 0; i < Size(); ++i) {
+    snapshot.offsets.push_back(snapshot.programs.size());
+    logWriter->Serialiser().Write(*programs[i], snapshot.programs);
+    unsortedIndex[programs[i]] = i;
+  }
+
+  SortFittestFirst();
+
+  snapshot.sortedOrder.reserve(Size());
+  for(unsigned int i = 0; i < Size(); ++i) {
+    snapshot.sortedOrder.push_back(unsortedIndex[programs[i]]);
+  }
+
+  logWriter->Submit(snapshot, last);
+}
+
+
+
 template <class IProgramSubclass, class T> std::string 
 VUWLGP::IPopulation<IProgramSubclass, T>::ToString(bool printFitness, 
 						   bool commentIntrons) const {
@@ -43,6 +43,17 @@ namespace VUWLGP {
     // FitnessEnvironment passed to it.
     void UpdateFitness(FitnessEnvironment<T>& fe);
 
+    // Adds the error on the cases in fe's window (see FitnessEnvironment::SetWindow) to the
+    // program's fitness, without zeroing it first or marking it as correct, so that a fitness
+    // can be built up a block of cases at a time. The introns must already have been marked.
+    void AccumulateError(FitnessEnvironment<T>& fe);
+
+    // Adds the error of the final register values fRV on the case fc to the program's
+    // fitness, for evaluators which execute the program themselves (e.g. LockstepEvaluator).
+    void UpdateError(const RegisterCollection<T>& fRV, const IFitnessCase<T>* fc) {
+      fitnessMeasure->UpdateError(fRV, fc);
+    }
+
     // Sets the IsIntron flag to true for each instruction in the program if that 
     // instruction is a structural intron, false otherwise. Marking structural introns 
     // can massively speed up execution on long programs.
@@ -56,6 +67,10 @@ namespace VUWLGP {
     // randomly cull to size:
     void RemoveRandomInstruction();
 
+    // Returns the number of registers, from r[0] on, whose final values the fitness measure
+    // reads - all of them unless a subclass says otherwise.
+    virtual unsigned int NumberOfOutputs() const { return config->numRegisters; }
+
     // Returns the number of instructions (both introns and exons) in the program.
     virtual unsigned int Size() const { return instructions.size(); }
 
@@ -69,6 +84,10 @@ namespace VUWLGP {
     // the unit tests
     void RandomiseFitness() {fitnessStatus = false; fitnessMeasure->RandomiseFitness();}
 
+    // Restores a fitness which is known to be correct for this program, e.g. one which was
+    // serialised with it, and marks the fitness as correct.
+    void SetFitness(double f) { fitnessStatus = true; fitnessMeasure->SetFitness(f); }
+
     // NOTE: THIS METHOD VIOLATES THE WHOLE OBJECT ENCAPSULATION SCHEMATA. It is 
     // necessary though, else all of the EvolutionaryOperationFunc methods would have to
     // be declared as friends of this class or be members and that is just annoying for 
@@ -84,6 +103,7 @@ namespace VUWLGP {
     // true if it is accurate, false if it is not or is unknown (the latter is more 
     // frequent/likely).
     bool& FitnessStatusReference() { return fitnessStatus; }
+    bool FitnessStatus() const { return fitnessStatus; }
 
     // Returns a C++-style function as a string representation of this program.
     virtual std::string 
@@ -195,15 +215,26 @@ void VUWLGP::IProgram<T>::UpdateFitness(VUWLGP::FitnessEnvironment<T>& fe) {
   if(!fe.LoadFirstCase()) { 
     throw std::string("No fitness cases in fe to evaluate against"); 
   }
-  
+  AccumulateError(fe);
+
+  // This program's fitness measure now has the correct fitness values:
+  fitnessStatus = true;
+  fe.CountEvaluation();
+}
+
+
+
+template <class T>
+void VUWLGP::IProgram<T>::AccumulateError(VUWLGP::FitnessEnvironment<T>& fe) {
+  if(!fe.LoadFirstCase()) {
+    return;
+  }
+
   do {
     fe.ZeroRegisters();
     Execute(fe);
     fitnessMeasure->UpdateError(finalRegisterValues, fe.CurrentCase());
   } while(fe.LoadNextCase());
-
-  // This program's fitness measure now has the correct fitness values:
-  fitnessStatus = true;
 }
 
 
@@ -282,7 +313,8 @@ void VUWLGP::IProgram<T>::MarkIntrons() {
 	  usedRegisters.insert((*ri)->FirstArgumentIndex());
 	}
 	
-	if((*ri)->SecondArgumentType() == ArgumentTypeRegister) {
+	if((*ri)->SecondArgumentType() == ArgumentTypeRegister &&
+	   !(*ri)->Operation()->IsUnary()) {
 	  usedRegisters.insert((*ri)->SecondArgumentIndex());
 	}
       }
@@ -23,6 +23,12 @@ namespace VUWLGP {
   public:
     Instruction(Config<T>* conf);
     Instruction(const Instruction& rhs);
+
+    // Builds an instruction from the given parts (e.g. when deserialising a program). The 
+    // instruction takes ownership of, and will delete, each of the parts passed to it.
+    Instruction(Config<T>* conf, IInstructionOperation<T>* operation, 
+		InstructionArgumentRegister<T>* dest, IInstructionArgument<T>* first,
+		IInstructionArgument<T>* second);
     virtual ~Instruction();
 
     // Executes this instruction (via op). Writes its result, if any, to r and returns
@@ -52,6 +58,11 @@ namespace VUWLGP {
     unsigned int FirstArgumentIndex() const { return firstArgument->ArgumentIndex(); }
     unsigned int SecondArgumentType() const { return secondArgument->ArgumentType(); }
     unsigned int SecondArgumentIndex() const { return secondArgument->ArgumentIndex(); }
+
+    // Read-only access to the parts of this instruction, e.g. for serialising it:
+    const IInstructionOperation<T>* Operation() const { return op; }
+    const IInstructionArgument<T>* FirstArgument() const { return firstArgument; }
+    const IInstructionArgument<T>* SecondArgument() const { return secondArgument; }
     
   private:
     IInstructionOperation<T>* op;
@@ -85,7 +96,7 @@ template <class T> VUWLGP::Instruction<T>::Instruction(const Instruction<T>& rhs
   // It should always be an IAR, but dynamic_cast it, rather than static_cast, just for 
   // safety:
   destination = 
-    dynamic_cast<InstructionArgumentRegister<double>*>(rhs.destination->Clone());
+    dynamic_cast<InstructionArgumentRegister<T>*>(rhs.destination->Clone());
   firstArgument = rhs.firstArgument->Clone();
   secondArgument = rhs.secondArgument->Clone();
   config = rhs.config;
@@ -94,6 +105,21 @@ template <class T> VUWLGP::Instruction<T>::Instruction(const Instruction<T>& rhs
 
 
 
+template <class T> VUWLGP::Instruction<T>::Instruction(Config<T>* conf, 
+						       IInstructionOperation<T>* operation,
+						       InstructionArgumentRegister<T>* dest,
+						       IInstructionArgument<T>* first,
+						       IInstructionArgument<T>* second):
+IsIntron(false),
+op(operation),
+destination(dest),
+firstArgument(first),
+secondArgument(second),
+config(conf) {
+}
+
+
+
 template <class T> VUWLGP::Instruction<T>::~Instruction() {
   // We do not deallocate config - everything else is owned by this object:
   delete op;
@@ -169,6 +195,10 @@ template <class T> std::string VUWLGP::Instruction<T>::ToString(bool commentIntr
     buffer << "if(" << firstArgument->ToString() << " " << op->ToString() << " " 
 	   << secondArgument->ToString() << ")";
   }
+  else if(op->IsUnary()) {
+    buffer << destination->ToString() << " = " << op->ToString() << "("
+	   << firstArgument->ToString() << ");";
+  }
   else {
     buffer << destination->ToString() << " = " << firstArgument->ToString() << " "
 	   << op->ToString() << " " << secondArgument->ToString() << ";";
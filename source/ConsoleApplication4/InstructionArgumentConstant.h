@@ -16,10 +16,14 @@ namespace VUWLGP {
     class InstructionArgumentConstant: public IInstructionArgument<T> {
   public:
     InstructionArgumentConstant(Config<T>* conf); // default cctor, dtor
+    InstructionArgumentConstant(Config<T>* conf, T val); // e.g. when deserialising
     
     // Returns the value of the register in the fitness environment fe this instance specifies
     T Value(const FitnessEnvironment<T>& fe) const { return value; }
 
+    // Returns the value of this constant without needing a fitness environment
+    T Constant() const { return value; }
+
     // Copies this InstructionArgument in every respect. Caller is responsible for the memory.
     IInstructionArgument<T>* Clone() const;
 
@@ -52,6 +56,14 @@ config(conf) {
 
 
 
+template <class T> 
+VUWLGP::InstructionArgumentConstant<T>::InstructionArgumentConstant(Config<T>* conf, T val):
+value(val),
+config(conf) {
+}
+
+
+
 template <class T>
 VUWLGP::IInstructionArgument<T>* VUWLGP::InstructionArgumentConstant<T>::Clone() const {
   return static_cast<IInstructionArgument<T>*>(new InstructionArgumentConstant<T>(*this));
@@ -15,6 +15,7 @@ namespace VUWLGP {
   template <class T> class InstructionArgumentFeature: public IInstructionArgument<T> {
   public:
     InstructionArgumentFeature(Config<T>* conf); // default cctor, dtor
+    InstructionArgumentFeature(Config<T>* conf, unsigned int index); // e.g. deserialising
 
     // Returns the value of the register in the fitness environment fe this instance specifies
     T Value(const FitnessEnvironment<T>& fe) const { return fe.ReadFeature(featureIndex); }
@@ -51,6 +52,14 @@ config(conf) {
 
 
 
+template <class T> VUWLGP::InstructionArgumentFeature<T>::
+InstructionArgumentFeature(Config<T>* conf, unsigned int index):
+featureIndex(index),
+config(conf) {
+}
+
+
+
 template <class T>
 VUWLGP::IInstructionArgument<T>* VUWLGP::InstructionArgumentFeature<T>::Clone() const {
   return static_cast<IInstructionArgument<T>*>(new InstructionArgumentFeature<T>(*this));
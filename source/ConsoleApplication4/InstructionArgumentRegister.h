@@ -15,6 +15,7 @@ namespace VUWLGP {
   template <class T> class InstructionArgumentRegister: public IInstructionArgument<T> {
   public:
     InstructionArgumentRegister(Config<T>* conf); // default cctor, dtor
+    InstructionArgumentRegister(Config<T>* conf, unsigned int index); // e.g. deserialising
 
     // Returns the value of the register in the fitness environment fe this instance specifies
     T Value(const FitnessEnvironment<T>& fe) const { return fe.ReadRegister(registerIndex); }
@@ -52,6 +53,14 @@ config(conf) {
 
 
 
+template <class T> VUWLGP::InstructionArgumentRegister<T>::
+InstructionArgumentRegister(Config<T>* conf, unsigned int index):
+registerIndex(index),
+config(conf) {
+}
+
+
+
 template <class T>
 VUWLGP::IInstructionArgument<T>* VUWLGP::InstructionArgumentRegister<T>::Clone() const {
   return static_cast<IInstructionArgument<T>*>(new InstructionArgumentRegister<T>(*this));
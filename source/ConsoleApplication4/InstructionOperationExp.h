@@ -0,0 +1,82 @@
+
+  
+#ifndef INSTRUCTIONOPERATIONEXP_H
+#define INSTRUCTIONOPERATIONEXP_H
+
+#include "Config.h"
+#include "IInstructionArgument.h"
+#include "InstructionArgumentRegister.h"
+#include "IInstructionOperation.h"
+#include "RegisterCollection.h"
+#include "Transcendental.h"
+
+namespace VUWLGP {
+  // Represents an exponential operation. It is unary, so the second argument is ignored.
+  template<class T> class InstructionOperationExp: public IInstructionOperation<T> {
+  public:
+    virtual ~InstructionOperationExp() { }
+
+    bool Execute(InstructionArgumentRegister<T>* dest, 
+		 const IInstructionArgument<T>* const first,
+		 const IInstructionArgument<T>* const second,
+		 FitnessEnvironment<T>& fe) const;
+
+    typedef typename IInstructionOperation<T>::Column Column;
+
+    bool ExecutesBatches() const { return true; }
+    void ExecuteBatch(T* dest, const Column& first, const Column& second, unsigned int length,
+		      unsigned char* mask) const;
+
+    bool IsUnary() const { return true; }
+
+    IInstructionOperation<T>* Clone() const;
+
+    std::string ToString() const { return "exp"; }
+
+    // Returns e to the power of first (see Transcendental), as Execute writes it to the
+    // destination.
+    static T Compute(T first, T second) { return Transcendental<T>::Exp(first); }
+  
+    static IInstructionOperation<T>* Generate(Config<T>* conf);
+  };
+}
+
+
+
+///////////////////////////////// INLINE FUNCTION DEFINITIONS //////////////////////////////// 
+// Raises e to the power of first and writes the result to dest. Returns true to indicate
+// that execution should proceed to the next instruction.
+template <class T> bool
+VUWLGP::InstructionOperationExp<T>::Execute(InstructionArgumentRegister<T>* dest,
+					    const IInstructionArgument<T>* const first,
+					    const IInstructionArgument<T>* const second,
+					    FitnessEnvironment<T>& fe) const {
+  fe.WriteRegister(dest->Index(), Compute(first->Value(fe), 0));
+  return true;
+}
+
+
+
+// Computes each case as Execute does, and writes the results to dest for the cases mask is
+// set for (see IInstructionOperation::ExecuteBatch).
+template <class T> void
+VUWLGP::InstructionOperationExp<T>::ExecuteBatch(T* dest, const Column& first,
+						 const Column& second, unsigned int length,
+						 unsigned char* mask) const {
+  this->template ComputeBatch<InstructionOperationExp>(dest, first, second, length, mask);
+}
+
+
+
+template <class T> VUWLGP::IInstructionOperation<T>* 
+VUWLGP::InstructionOperationExp<T>::Clone() const {
+  return static_cast<IInstructionOperation<T>*>(new InstructionOperationExp());
+}
+
+
+
+template <class T> VUWLGP::IInstructionOperation<T>* 
+VUWLGP::InstructionOperationExp<T>::Generate(VUWLGP::Config<T>* conf) {
+  return new InstructionOperationExp();
+}
+#endif
@@ -21,9 +21,18 @@ namespace VUWLGP {
 		 const IInstructionArgument<T>* const second,
 		 FitnessEnvironment<T>& fe) const;
 
+    typedef typename IInstructionOperation<T>::Column Column;
+
+    bool ExecutesBatches() const { return true; }
+    void ExecuteBatch(T* dest, const Column& first, const Column& second, unsigned int length,
+		      unsigned char* mask) const;
+
     IInstructionOperation<T>* Clone() const;
 
     std::string ToString() const { return "<"; }
+
+    // Returns true if first < second, as Execute does.
+    static bool Holds(T first, T second) { return first < second; }
   
     static IInstructionOperation<T>* Generate(VUWLGP::Config<T>* conf);
   };
@@ -32,15 +41,24 @@ namespace VUWLGP {
 
 
 ///////////////////////////////// INLINE FUNCTION DEFINITIONS //////////////////////////////// 
-template <class T> class VUWLGP::IInstructionOperation;
-
 // Returns true if the first argument is less than the second
 template <class T> bool
 VUWLGP::InstructionOperationIflt<T>::Execute(InstructionArgumentRegister<T>* dest,
 						  const IInstructionArgument<T>* const first,
 						  const IInstructionArgument<T>* const second,
 						  FitnessEnvironment<T>& fe) const {
-  return first->Value(fe) < second->Value(fe);
+  return Holds(first->Value(fe), second->Value(fe));
+}
+
+
+
+// Clears mask for the cases whose first argument isn't less than their second (see
+// IInstructionOperation::ExecuteBatch).
+template <class T> void
+VUWLGP::InstructionOperationIflt<T>::ExecuteBatch(T* dest, const Column& first,
+						  const Column& second, unsigned int length,
+						  unsigned char* mask) const {
+  this->template HoldsBatch<InstructionOperationIflt>(first, second, length, mask);
 }
 
 
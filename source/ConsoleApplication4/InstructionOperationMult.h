@@ -20,9 +20,18 @@ namespace VUWLGP {
 		 const IInstructionArgument<T>* const second,
 		 FitnessEnvironment<T>& fe) const;
 
+    typedef typename IInstructionOperation<T>::Column Column;
+
+    bool ExecutesBatches() const { return true; }
+    void ExecuteBatch(T* dest, const Column& first, const Column& second, unsigned int length,
+		      unsigned char* mask) const;
+
     IInstructionOperation<T>* Clone() const;
 
     std::string ToString() const { return "*"; }
+
+    // Returns first * second, as Execute writes it to the destination.
+    static T Compute(T first, T second) { return first * second; }
   
     static IInstructionOperation<T>* Generate(Config<T>* conf);
   };
@@ -31,8 +40,6 @@ namespace VUWLGP {
 
 
 ///////////////////////////////// INLINE FUNCTION DEFINITIONS //////////////////////////////// 
-template <class T> class VUWLGP::IInstructionOperation;
-
 // Adds first to second and writes the result to dest. Returns true to indicate that
 // execution should proceed to the next instruction.
 template <class T> bool
@@ -40,12 +47,23 @@ VUWLGP::InstructionOperationMult<T>::Execute(InstructionArgumentRegister<T>* des
 						  const IInstructionArgument<T>* const first,
 						  const IInstructionArgument<T>* const second,
 						  FitnessEnvironment<T>& fe) const {
-  fe.WriteRegister(dest->Index(), first->Value(fe) * second->Value(fe));
+  fe.WriteRegister(dest->Index(), Compute(first->Value(fe), second->Value(fe)));
   return true;
 }
 
 
 
+// Multiplies each case's first by its second, as Execute does, and writes the results to dest
+// for the cases mask is set for (see IInstructionOperation::ExecuteBatch).
+template <class T> void
+VUWLGP::InstructionOperationMult<T>::ExecuteBatch(T* dest, const Column& first,
+						  const Column& second, unsigned int length,
+						  unsigned char* mask) const {
+  this->template ComputeBatch<InstructionOperationMult>(dest, first, second, length, mask);
+}
+
+
+
 template <class T> VUWLGP::IInstructionOperation<T>* 
 VUWLGP::InstructionOperationMult<T>::Clone() const {
   return static_cast<IInstructionOperation<T>*>(new InstructionOperationMult());
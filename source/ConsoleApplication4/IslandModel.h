@@ -0,0 +1,450 @@
+
+  
+#ifndef ISLANDMODEL_H
+#define ISLANDMODEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sched.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "Config.h"
+#include "FitnessEnvironment.h"
+#include "IPopulation.h"
+#include "ProgramSerialiser.h"
+#include "Rand.h"
+#include "SharedMemoryRing.h"
+
+namespace VUWLGP {
+  // What each island reports back to the coordinating process when it finishes. generations
+  // has the same meaning as the return value of IPopulation::Evolve, and cpuTicks is the
+  // value of clock() in the island's process at the end of its run.
+  struct IslandResult {
+    unsigned int generations;
+    double trainingFitness;
+    double testFitness;
+    long cpuTicks;
+    int finished;
+  };
+
+
+
+  // Runs Config::numIslands populations as separate processes which are fork()ed from the
+  // calling (coordinating) process. Each island builds its own population and fitness
+  // environments after it has started, so on a NUMA machine (if Config::bindIslandsToNumaNodes
+  // is set) they are allocated on the node the island is bound to. Every
+  // Config::migrationInterval generations each island sends copies of its
+  // Config::migrationSize fittest programs to the next island in a ring, through a
+  // SharedMemoryRing, where they replace the least fit programs. As soon as one island finds
+  // a solution (fitness <= Config::epsilon) every island stops at the end of its current
+  // generation. Each island logs to the usual files, with ".island<n>" inserted before the
+  // generation information. Only available on POSIX systems.
+  template <class IProgramSubclass, class T> class IslandModel {
+  public:
+    // Generator functions build (and give the caller ownership of) a population and the
+    // training and test fitness environments for an island. They are called in the island's
+    // process.
+    typedef IPopulation<IProgramSubclass, T>* (*PopulationGeneratorFunc)(Config<T>*);
+    typedef FitnessEnvironment<T>* (*EnvironmentGeneratorFunc)(Config<T>*);
+
+    IslandModel(Config<T>* conf, PopulationGeneratorFunc pg, EnvironmentGeneratorFunc train,
+		EnvironmentGeneratorFunc test);
+    ~IslandModel();
+
+    // Runs each of the islands to completion and returns the number of generations used by
+    // the best island, with the same meaning as the return value of IPopulation::Evolve.
+    unsigned int Evolve();
+
+    // The results of each island's run, and the index of the best island: the island that
+    // found a solution in the fewest generations, or if none did the island whose fittest
+    // program has the lowest training fitness. Only valid after Evolve has been called.
+    const IslandResult& Result(unsigned int island) const { return results[island]; }
+    unsigned int BestIsland() const;
+
+    // Appends the results of the best island to Config::runLogFilePath, in the same format
+    // as a single population run (generations, time, training fitness, test fitness).
+    void LogResults() const;
+
+  private:
+    // The shared memory holds the stop flag, then (64 bytes in) the island results and then
+    // one inbox ring per island, each a whole number of 64 byte lines.
+    struct ControlBlock {
+      std::atomic<unsigned int> stop;
+    };
+
+    // Runs island number island in the current (child) process, and then exits. Whatever it
+    // throws is reported on std::cerr and it exits with status 1.
+    void RunIsland(unsigned int island, unsigned int seed);
+
+    // Sends the fittest programs to the next island, and replaces the least fit programs
+    // with any that have arrived from the previous one.
+    void Migrate(unsigned int island, IPopulation<IProgramSubclass, T>& pop,
+		 const ProgramSerialiser<T>& serialiser);
+
+    // Restricts the calling process to the processors of one of the machine's NUMA nodes,
+    // chosen round-robin by island. Does nothing if there is only one node.
+    static void BindToNumaNode(unsigned int island);
+
+    // Parses a Linux cpulist/nodelist string like "0-3,8,10-11".
+    static std::vector<unsigned int> ParseList(const std::string& list);
+
+    SharedMemoryRing Inbox(unsigned int island, bool initialise) const;
+    size_t RingOffset(unsigned int island) const; // RingOffset(numIslands) is the total size
+    unsigned int SlotSize() const;
+
+    PopulationGeneratorFunc populationGenerator;
+    EnvironmentGeneratorFunc trainingGenerator;
+    EnvironmentGeneratorFunc testGenerator;
+
+    SharedMemorySegment* memory;
+    ControlBlock* control;
+    IslandResult* results;
+
+    Config<T>* config;
+  };
+}
+
+
+
+////////////////////////////////// INLINE FUNCTION DEFINITIONS /////////////////////////////////
+template <class IProgramSubclass, class T>
+VUWLGP::IslandModel<IProgramSubclass, T>::IslandModel(Config<T>* conf,
+						      PopulationGeneratorFunc pg,
+						      EnvironmentGeneratorFunc train,
+						      EnvironmentGeneratorFunc test):
+populationGenerator(pg),
+trainingGenerator(train),
+testGenerator(test),
+memory(0),
+control(0),
+results(0),
+config(conf) {
+  memory = new SharedMemorySegment(RingOffset(config->numIslands));
+  unsigned char* base = static_cast<unsigned char*>(memory->Address());
+
+  control = new (base) ControlBlock();
+  control->stop.store(0);
+  results = reinterpret_cast<IslandResult*>(base + 64);
+
+  for(unsigned int i = 0; i < config->numIslands; ++i) {
+    Inbox(i, true);
+  }
+}
+
+
+
+template <class IProgramSubclass, class T>
+VUWLGP::IslandModel<IProgramSubclass, T>::~IslandModel() {
+  delete memory;
+}
+
+
+
+template <class IProgramSubclass, class T>
+unsigned int VUWLGP::IslandModel<IProgramSubclass, T>::Evolve() {
+#ifndef _WIN32
+  unsigned int seed = config->seedSpecified ? config->randSeed : time(0);
+  std::vector<pid_t> islands;
+
+  // Flush anything buffered now, otherwise every island would write it again at exit:
+  std::cout.flush();
+
+  for(unsigned int i = 0; i < config->numIslands; ++i) {
+    pid_t pid = fork();
+
+    if(pid == 0) {
+      RunIsland(i, seed + i); // never returns
+    }
+    else if(pid < 0) {
+      // Don't leave the islands already started running, or unreaped:
+      control->stop.store(1);
+      for(unsigned int j = 0; j < islands.size(); ++j) {
+	kill(islands[j], SIGKILL);
+	waitpid(islands[j], 0, 0);
+      }
+      throw std::string("IslandModel::Evolve - could not start an island process");
+    }
+
+    islands.push_back(pid);
+  }
+
+  // Wait for every island before reporting any failure, so none are left running:
+  std::ostringstream failures;
+  for(unsigned int i = 0; i < islands.size(); ++i) {
+    int status;
+    waitpid(islands[i], &status, 0);
+
+    if(!WIFEXITED(status) || WEXITSTATUS(status) != 0 || !results[i].finished) {
+      failures << " " << i;
+    }
+  }
+
+  if(!failures.str().empty()) {
+    throw "IslandModel::Evolve - islands which did not finish:" + failures.str();
+  }
+
+  return results[BestIsland()].generations;
+#else
+  throw std::string("IslandModel::Evolve - island processes need a POSIX system");
+#endif
+}
+
+
+
+template <class IProgramSubclass, class T>
+unsigned int VUWLGP::IslandModel<IProgramSubclass, T>::BestIsland() const {
+  unsigned int best = 0;
+
+  for(unsigned int i = 1; i < config->numIslands; ++i) {
+    bool solved = results[i].generations <= config->maxGenerations;
+    bool bestSolved = results[best].generations <= config->maxGenerations;
+
+    if(solved && (!bestSolved || results[i].generations < results[best].generations)) {
+      best = i;
+    }
+    else if(!solved && !bestSolved &&
+	    results[i].trainingFitness < results[best].trainingFitness) {
+      best = i;
+    }
+  }
+
+  return best;
+}
+
+
+
+template <class IProgramSubclass, class T>
+void VUWLGP::IslandModel<IProgramSubclass, T>::LogResults() const {
+  const IslandResult& best = results[BestIsland()];
+  unsigned int generations = std::min(best.generations, config->maxGenerations);
+
+  for(unsigned int i = 0; i < config->numIslands; ++i) {
+    std::cout << "Island " << i << ": " << std::min(results[i].generations,
+						     config->maxGenerations) << ","
+	      << results[i].cpuTicks << "," << results[i].trainingFitness << ","
+	      << results[i].testFitness << std::endl;
+  }
+
+  std::ofstream fout(config->runLogFilePath.c_str(), std::ios::out | std::ios::app);
+  fout << generations << "," << best.cpuTicks << "," << best.trainingFitness << ","
+       << best.testFitness << std::endl;
+  fout.close();
+}
+
+
+
+template <class IProgramSubclass, class T>
+void VUWLGP::IslandModel<IProgramSubclass, T>::RunIsland(unsigned int island,
+							 unsigned int seed) {
+#ifndef _WIN32
+  IslandResult& result = results[island];
+  result.finished = 0;
+
+  try {
+    if(config->bindIslandsToNumaNodes) {
+      BindToNumaNode(island);
+    }
+
+    std::ostringstream suffix;
+    suffix << ".island" << island;
+    config->statsLogFilePath += suffix.str();
+    config->popLogFilePath += suffix.str();
+    config->metricsFilePath += suffix.str();
+
+    Rand::Init(seed);
+
+    // Everything the island uses is built here, after it has been bound to its node:
+    FitnessEnvironment<T>* train = trainingGenerator(config);
+    FitnessEnvironment<T>* test = testGenerator(config);
+    IPopulation<IProgramSubclass, T>* pop = populationGenerator(config);
+    ProgramSerialiser<T> serialiser(config);
+
+    // The same loop as IPopulation::Evolve, but with migration and the shared stop flag:
+    pop->EvaluateFlaggedPrograms(*train);
+    pop->Log("initial");
+    result.generations = pop->SolutionExists() ? 0 : config->maxGenerations + 1;
+
+    for(unsigned int generation = 1; result.generations > config->maxGenerations &&
+	  generation <= config->maxGenerations && !control->stop.load(); ++generation) {
+      pop->IteratePopulation();
+      pop->EvaluateFlaggedPrograms(*train);
+
+      if(config->numIslands > 1 && generation % config->migrationInterval == 0) {
+	Migrate(island, *pop, serialiser);
+      }
+
+      pop->Log(generation);
+
+      if(pop->SolutionExists()) {
+	result.generations = generation;
+      }
+    }
+
+    if(result.generations <= config->maxGenerations) {
+      control->stop.store(1);
+    }
+
+    IProgramSubclass* best = pop->GetFittestProgram();
+    result.trainingFitness = best->Fitness();
+    best->UpdateFitness(*test);
+    result.testFitness = best->Fitness();
+    result.cpuTicks = clock();
+    pop->FlushLogs();
+    result.finished = 1;
+
+    delete pop;
+    delete test;
+    delete train;
+  }
+  catch(std::string& error) {
+    std::cerr << "Island " << island << ": " << error << std::endl;
+  }
+  catch(std::exception& error) {
+    std::cerr << "Island " << island << ": " << error.what() << std::endl;
+  }
+  catch(...) {
+    // Nothing may unwind out of the child into the parent's code:
+    std::cerr << "Island " << island << ": unknown exception" << std::endl;
+  }
+
+  std::cout.flush();
+  _exit(result.finished ? 0 : 1);
+#endif
+}
+
+
+
+template <class IProgramSubclass, class T> void
+VUWLGP::IslandModel<IProgramSubclass, T>::Migrate(unsigned int island,
+						  IPopulation<IProgramSubclass, T>& pop,
+						  const ProgramSerialiser<T>& serialiser) {
+  // Emigration - a full inbox means the next island is behind, so the migrants are dropped:
+  SharedMemoryRing outbox = Inbox((island + 1) % config->numIslands, false);
+  std::vector<const IProgramSubclass*> emigrants;
+  std::vector<unsigned char> buffer;
+  pop.GetFittestPrograms(config->migrationSize, emigrants);
+
+  for(unsigned int i = 0; i < emigrants.size(); ++i) {
+    buffer.clear();
+    serialiser.Write(*emigrants[i], buffer);
+    outbox.Push(&buffer[0], buffer.size());
+  }
+
+  // Immigration - the immigrants' fitnesses were calculated against the same fitness cases,
+  // so they do not need to be re-evaluated:
+  SharedMemoryRing inbox = Inbox(island, false);
+  std::vector<IProgramSubclass*> immigrants;
+
+  while(inbox.Pop(buffer)) {
+    unsigned int offset = 0;
+    immigrants.push_back(serialiser.template Read<IProgramSubclass>(&buffer[0], buffer.size(),
+								    offset));
+  }
+
+  pop.ReplaceLeastFit(immigrants);
+}
+
+
+
+template <class IProgramSubclass, class T>
+void VUWLGP::IslandModel<IProgramSubclass, T>::BindToNumaNode(unsigned int island) {
+#if !defined(_WIN32) && defined(CPU_SET)
+  std::ifstream nodesIn("/sys/devices/system/node/online");
+  std::string nodeList;
+
+  if(!getline(nodesIn, nodeList)) {
+    return; // not Linux, or no NUMA information
+  }
+
+  std::vector<unsigned int> nodes = ParseList(nodeList);
+  if(nodes.size() < 2) {
+    return;
+  }
+
+  std::ostringstream path;
+  path << "/sys/devices/system/node/node" << nodes[island % nodes.size()] << "/cpulist";
+  std::ifstream cpusIn(path.str().c_str());
+  std::string cpuList;
+
+  if(!getline(cpusIn, cpuList)) {
+    return;
+  }
+
+  std::vector<unsigned int> cpus = ParseList(cpuList);
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+
+  for(unsigned int i = 0; i < cpus.size(); ++i) {
+    CPU_SET(cpus[i], &mask);
+  }
+
+  // Linux allocates pages on the node of the processor which first touches them, so from
+  // here on the island's memory is local to its node:
+  sched_setaffinity(0, sizeof(mask), &mask);
+#endif
+}
+
+
+
+template <class IProgramSubclass, class T> std::vector<unsigned int>
+VUWLGP::IslandModel<IProgramSubclass, T>::ParseList(const std::string& list) {
+  std::vector<unsigned int> result;
+  std::istringstream conv(list);
+  std::string range;
+
+  while(getline(conv, range, ',')) {
+    unsigned int first = 0;
+    unsigned int last = 0;
+    char dash;
+    std::istringstream rangeConv(range);
+
+    if(!(rangeConv >> first)) {
+      continue;
+    }
+
+    last = (rangeConv >> dash >> last) ? last : first;
+    for(unsigned int i = first; i <= last; ++i) {
+      result.push_back(i);
+    }
+  }
+
+  return result;
+}
+
+
+
+template <class IProgramSubclass, class T> VUWLGP::SharedMemoryRing
+VUWLGP::IslandModel<IProgramSubclass, T>::Inbox(unsigned int island, bool initialise) const {
+  unsigned char* base = static_cast<unsigned char*>(memory->Address());
+  return SharedMemoryRing(base + RingOffset(island), 4 * config->migrationSize, SlotSize(),
+			  initialise);
+}
+
+
+
+template <class IProgramSubclass, class T>
+size_t VUWLGP::IslandModel<IProgramSubclass, T>::RingOffset(unsigned int island) const {
+  size_t headerBytes = 64 + (config->numIslands * sizeof(IslandResult) + 63) / 64 * 64;
+  return headerBytes + 
+    island * SharedMemoryRing::RequiredBytes(4 * config->migrationSize, SlotSize());
+}
+
+
+
+template <class IProgramSubclass, class T>
+unsigned int VUWLGP::IslandModel<IProgramSubclass, T>::SlotSize() const {
+  return ProgramSerialiser<T>::MaximumSize(config->maxLength);
+}
+#endif
@@ -0,0 +1,124 @@
+
+  
+#ifndef KERNELDISPATCH_H
+#define KERNELDISPATCH_H
+
+#include <string>
+
+// The batch kernels (see IInstructionOperation::ExecuteBatch) are compiled once for each
+// level below with GCC's (and Clang's) target attribute, VUWLGP_KERNEL_INLINE making the
+// shared loops inline into each, so one binary has every kernel for every level. Other
+// compilers and processors only get the baseline.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VUWLGP_KERNEL_DISPATCH 1
+#define VUWLGP_KERNEL_TARGET(isa) __attribute__((target(isa)))
+#define VUWLGP_KERNEL_INLINE inline __attribute__((always_inline))
+#else
+#define VUWLGP_KERNEL_DISPATCH 0
+#define VUWLGP_KERNEL_TARGET(isa)
+#define VUWLGP_KERNEL_INLINE inline
+#endif
+
+namespace VUWLGP {
+  // The instruction set levels the batch kernels are compiled for: the SSE2 baseline every
+  // x86-64 processor has, AVX2 and AVX-512 (AVX512F and AVX512BW, for the masks' bytes). Both
+  // of the latter also need F16C (which every processor with them has), for decoding float16
+  // features (see HalfFloat::DecodeFloat16s).
+  enum KernelLevel { KernelsBaseline, KernelsAvx2, KernelsAvx512 };
+
+  // Chooses which copy of the batch kernels runs. The best level the processor supports is
+  // detected with cpuid the first time it is needed, and can be overridden, e.g. to
+  // benchmark the levels against each other. None of the levels enables FMA, so (with
+  // floating point contraction off, as the Makefile has it) every level computes exactly the
+  // same values, and only the speed differs.
+  class KernelDispatch {
+  public:
+    // The level the kernels run at - the best supported one unless Select chose another.
+    static KernelLevel Selected() { return SelectedLevel(); }
+
+    // Selects the level called name - "auto" for the best supported one, "sse2", "avx2" or
+    // "avx512". It must be called before any program is evaluated (e.g. from
+    // Config::evaluationKernels). Throws a std::string if there is no such level, or if the
+    // processor doesn't support it or this build doesn't have it.
+    static void Select(const std::string& name);
+
+    // Returns the best level both the processor and this build support.
+    static KernelLevel Detect();
+
+    static bool Supports(KernelLevel level);
+
+    // Returns level's name, as Select takes it.
+    static const char* Name(KernelLevel level);
+
+  private:
+    static KernelLevel& SelectedLevel() {
+      static KernelLevel level = Detect();
+      return level;
+    }
+  };
+}
+
+
+
+////////////////////////////////// Inline Function Definitions /////////////////////////////////
+inline void VUWLGP::KernelDispatch::Select(const std::string& name) {
+  if(name == "auto") {
+    SelectedLevel() = Detect();
+    return;
+  }
+
+  KernelLevel levels[] = { KernelsBaseline, KernelsAvx2, KernelsAvx512 };
+  for(unsigned int i = 0; i < sizeof(levels) / sizeof(levels[0]); ++i) {
+    if(name == Name(levels[i])) {
+      if(!Supports(levels[i])) {
+	throw "KernelDispatch::Select - " + name + " isn't supported here";
+      }
+      SelectedLevel() = levels[i];
+      return;
+    }
+  }
+  throw "KernelDispatch::Select - unknown kernel level " + name;
+}
+
+
+
+inline VUWLGP::KernelLevel VUWLGP::KernelDispatch::Detect() {
+  if(Supports(KernelsAvx512)) {
+    return KernelsAvx512;
+  }
+  return Supports(KernelsAvx2) ? KernelsAvx2 : KernelsBaseline;
+}
+
+
+
+inline bool VUWLGP::KernelDispatch::Supports(VUWLGP::KernelLevel level) {
+#if VUWLGP_KERNEL_DISPATCH
+  // The checks include the operating system saving the wider registers:
+  __builtin_cpu_init();
+  switch(level) {
+  case KernelsAvx512:
+    return __builtin_cpu_supports("avx512f") != 0 && __builtin_cpu_supports("avx512bw") != 0 &&
+      __builtin_cpu_supports("f16c") != 0;
+  case KernelsAvx2:
+    return __builtin_cpu_supports("avx2") != 0 && __builtin_cpu_supports("f16c") != 0;
+  default:
+    return true;
+  }
+#else
+  return level == KernelsBaseline;
+#endif
+}
+
+
+
+inline const char* VUWLGP::KernelDispatch::Name(VUWLGP::KernelLevel level) {
+  switch(level) {
+  case KernelsAvx512:
+    return "avx512";
+  case KernelsAvx2:
+    return "avx2";
+  default:
+    return "sse2";
+  }
+}
+#endif
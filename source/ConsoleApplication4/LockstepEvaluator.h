@@ -0,0 +1,206 @@
+
+  
+#ifndef LOCKSTEPEVALUATOR_H
+#define LOCKSTEPEVALUATOR_H
+
+#include <algorithm>
+#include <vector>
+
+#include "Config.h"
+#include "ExecutionPlan.h"
+#include "FitnessEnvironment.h"
+#include "IFitnessCase.h"
+#include "IProgram.h"
+#include "Instruction.h"
+#include "RegisterCollection.h"
+
+namespace VUWLGP {
+  // Evaluates a group of up to Lanes different programs at once, each in its own lane, on the
+  // same case at the same time: each program is compiled into an ExecutionPlan (optimised as
+  // the Config says), and step s of the group executes step s of every plan. This suits small
+  // datasets, where there are too few cases for evaluating a program against several cases at
+  // once to help, and it replaces the interpreter's virtual calls per instruction with a loop
+  // over the lanes which has no branches, so the compiler can vectorise it.
+  //
+  // Each lane's registers, the case's features and the lane's constants are kept in a bank of
+  // slots, laid out as the plans' slots are (with the features following the most registers
+  // any plan uses), so every operand is read the same way and plans which use fewer
+  // registers (see ExecutionPlan::RenameRegisters) need fewer zeroed per case. Every step
+  // computes the result of each operation for each lane and selects its lane's one, and a
+  // false conditional masks its lane (as the interpreter skips) until the next assignment.
+  // Plans shorter than the longest in the group are padded with steps which write to a
+  // scratch slot, so grouping programs of similar effective lengths wastes fewer steps.
+  //
+  // The plans compute every operation exactly as its class does, so the fitnesses are exactly
+  // the same as the interpreter's (see Config::assumeFiniteValues for the exception).
+  // Programs plans can't be compiled for (see CanEvaluate) must be evaluated by the
+  // interpreter, as must those of program classes which override IProgram::Execute.
+  template <class T> class LockstepEvaluator {
+  public:
+    static const unsigned int Lanes = 8;
+
+    // Compiles the programs[0, numPrograms), of which there must be at most Lanes. Their
+    // introns must be marked, and CanEvaluate must be true of each of them. The evaluator
+    // doesn't own the programs, which must outlive it and not change while it is used.
+    LockstepEvaluator(IProgram<T>* const* programs, unsigned int numPrograms,
+		      const Config<T>* conf);
+    // Default dtor, no cctor
+
+    // Adds the error of each program on the cases in fe's window (see
+    // FitnessEnvironment::SetWindow) to its fitness, as IProgram::AccumulateError does.
+    void AccumulateErrors(FitnessEnvironment<T>& fe);
+
+    unsigned int NumberOfPrograms() const { return programs.size(); }
+
+    // Returns true if prog can be compiled into an ExecutionPlan. prog's introns must be
+    // marked.
+    static bool CanEvaluate(const IProgram<T>& prog) {
+      return ExecutionPlan<T>::CanCompile(prog);
+    }
+
+    // Returns the number of instructions of prog which aren't introns.
+    static unsigned int EffectiveLength(const IProgram<T>& prog);
+
+  private:
+    LockstepEvaluator(const LockstepEvaluator<T>& rhs); // not copyable
+    LockstepEvaluator<T>& operator=(const LockstepEvaluator<T>& rhs);
+
+    std::vector<IProgram<T>*> programs;
+    unsigned int numRegisters; // the most registers any plan uses
+    unsigned int numFeatures;
+    unsigned int numSteps;
+
+    // The code of step s for lane l is at [s * Lanes + l]. Operands and destinations are
+    // the positions of their lane's values in bank (see below).
+    std::vector<unsigned char> opcodes;
+    std::vector<unsigned int> destinations;
+    std::vector<unsigned int> firsts;
+    std::vector<unsigned int> seconds;
+    unsigned int scratchSlot;
+
+    // The slots - the registers, then the features, then the constants, then the scratch
+    // slot. The value of slot i for lane l is at [i * Lanes + l].
+    std::vector<T> bank;
+    RegisterCollection<T> finalRegisterValues;
+  };
+}
+
+
+
+////////////////////////////////// Inline Function Definitions /////////////////////////////////
+template <class T>
+VUWLGP::LockstepEvaluator<T>::LockstepEvaluator(VUWLGP::IProgram<T>* const* progs,
+						unsigned int numPrograms,
+						const VUWLGP::Config<T>* conf):
+programs(progs, progs + numPrograms),
+numRegisters(0),
+numFeatures(conf->numFeatures),
+numSteps(0),
+finalRegisterValues(conf->numRegisters) {
+  // The constants go into each lane's own slots after the features, so the scratch slot
+  // follows the most constants any plan uses:
+  std::vector<ExecutionPlan<T> > plans;
+  unsigned int numConstants = 0;
+  for(unsigned int i = 0; i < programs.size(); ++i) {
+    plans.push_back(ExecutionPlan<T>(*programs[i], conf));
+    plans.back().Optimise(conf);
+    numSteps = std::max(numSteps, plans.back().NumberOfSteps());
+    numRegisters = std::max(numRegisters, plans.back().NumberOfRegisters());
+    numConstants = std::max<unsigned int>(numConstants, plans.back().Constants().size());
+  }
+  scratchSlot = numRegisters + numFeatures + numConstants;
+  bank.assign((scratchSlot + 1) * Lanes, 0);
+
+  opcodes.assign(numSteps * Lanes, ExecutionPlan<T>::OpPlus);
+  for(unsigned int s = 0; s < numSteps; ++s) {
+    for(unsigned int lane = 0; lane < Lanes; ++lane) {
+      destinations.push_back(scratchSlot * Lanes + lane);
+    }
+  }
+  firsts = destinations;
+  seconds = destinations;
+  for(unsigned int lane = 0; lane < plans.size(); ++lane) {
+    // The plan's features and constants move up past the registers other plans use:
+    const ExecutionPlan<T>& plan = plans[lane];
+    unsigned int shift = numRegisters - plan.NumberOfRegisters();
+    for(unsigned int s = 0; s < plan.NumberOfSteps(); ++s) {
+      const typename ExecutionPlan<T>::Step& step = plan.StepAt(s);
+      unsigned int at = s * Lanes + lane;
+      opcodes[at] = step.opcode;
+      destinations[at] = (ExecutionPlan<T>::IsConditional(step.opcode) ? scratchSlot :
+			  step.destination) * Lanes + lane;
+      unsigned int first = step.first + (step.first < plan.NumberOfRegisters() ? 0 : shift);
+      unsigned int second = step.second + (step.second < plan.NumberOfRegisters() ? 0 : shift);
+      firsts[at] = first * Lanes + lane;
+      seconds[at] = second * Lanes + lane;
+    }
+
+    for(unsigned int i = 0; i < plan.Constants().size(); ++i) {
+      bank[(plan.FirstConstantSlot() + shift + i) * Lanes + lane] = plan.Constants()[i];
+    }
+  }
+}
+
+
+
+template <class T>
+void VUWLGP::LockstepEvaluator<T>::AccumulateErrors(VUWLGP::FitnessEnvironment<T>& fe) {
+  if(!fe.LoadFirstCase()) {
+    return;
+  }
+
+  T* slots = &bank[0];
+  do {
+    for(unsigned int i = 0; i < numRegisters * Lanes; ++i) {
+      slots[i] = 0;
+    }
+    for(unsigned int f = 0; f < numFeatures; ++f) {
+      T value = fe.ReadFeature(f);
+      for(unsigned int lane = 0; lane < Lanes; ++lane) {
+	slots[(numRegisters + f) * Lanes + lane] = value;
+      }
+    }
+
+    // skipping[lane] is set while lane's program is skipping to its next assignment after a
+    // false conditional, as the interpreter's executeNextAssignment is clear:
+    bool skipping[Lanes] = { false };
+    for(unsigned int s = 0; s < numSteps; ++s) {
+      const unsigned char* opcode = &opcodes[s * Lanes];
+      const unsigned int* destination = &destinations[s * Lanes];
+      const unsigned int* first = &firsts[s * Lanes];
+      const unsigned int* second = &seconds[s * Lanes];
+
+      for(unsigned int lane = 0; lane < Lanes; ++lane) {
+	T a = slots[first[lane]];
+	T b = slots[second[lane]];
+	T result = ExecutionPlan<T>::Apply(opcode[lane], a, b);
+
+	bool conditional = ExecutionPlan<T>::IsConditional(opcode[lane]);
+	T& target = slots[destination[lane]];
+	target = skipping[lane] || conditional ? target : result;
+	skipping[lane] = conditional && (skipping[lane] || !(a < b));
+      }
+    }
+
+    const IFitnessCase<T>* fc = fe.CurrentCase();
+    for(unsigned int lane = 0; lane < programs.size(); ++lane) {
+      for(unsigned int r = 0; r < finalRegisterValues.Size(); ++r) {
+	finalRegisterValues.Write(r, r < numRegisters ? slots[r * Lanes + lane] : 0);
+      }
+      programs[lane]->UpdateError(finalRegisterValues, fc);
+    }
+  } while(fe.LoadNextCase());
+}
+
+
+
+template <class T>
+unsigned int VUWLGP::LockstepEvaluator<T>::EffectiveLength(const VUWLGP::IProgram<T>& prog) {
+  const std::vector<Instruction<T>*>& instrs = prog.ConstRawAccessToTheInternalInstructions();
+  unsigned int length = 0;
+  for(unsigned int i = 0; i < instrs.size(); ++i) {
+    length += !instrs[i]->IsIntron;
+  }
+  return length;
+}
+#endif
@@ -0,0 +1,401 @@
+
+  
+#ifndef LOGWRITER_H
+#define LOGWRITER_H
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Config.h"
+#include "PopulationHistory.h"
+#include "ProgramSerialiser.h"
+
+namespace VUWLGP {
+  // Writes a population's statistics log and population dumps on a background thread, so that
+  // evolution doesn't wait for the text to be formatted or for the disk. The population hands
+  // over a Snapshot - its programs serialised by a ProgramSerialiser, which is much cheaper
+  // than formatting them - and the writer produces exactly the same text as
+  // IPopulation::LogStatistics and IPopulation::LogPopulation would have, with each file
+  // written by a single large fwrite. Population dumps are written as text files, appended to
+  // a PopulationHistory or both, according to Config::popLogFormat.
+  //
+  // At most Config::logQueueLength snapshots wait to be written. When the queue is full Submit
+  // drops the snapshot and notes the missing generation in the statistics log instead, in its
+  // place among the others, so that evolution is never held up by a slow disk, unless
+  // Config::dropLogsWhenBehind is cleared or the snapshot must be kept (e.g. the last of a
+  // run), when it waits for room.
+  //
+  // An error writing the logs (e.g. a file which can't be opened) is kept by the writer thread
+  // and thrown, as a std::string, from the next call to Submit or Flush. The destructor can't
+  // throw it, so prints it to std::cerr if it hasn't been thrown yet.
+  template <class T> class LogWriter {
+  public:
+    // The state of the population at one call to IPopulation::Log. The programs are stored
+    // one after another in programs, in population order, starting at the given offsets.
+    // sortedOrder lists the programs fittest first, the order in which they are dumped.
+    struct Snapshot {
+      std::string identifier;
+      std::string statsFilePath;
+      std::string popFilePath; // empty if the population isn't dumped this time
+      std::vector<unsigned char> programs;
+      std::vector<unsigned int> offsets;
+      std::vector<unsigned int> sortedOrder;
+      std::vector<std::string> droppedBefore; // set by Submit, see dropped
+    };
+
+    LogWriter(Config<T>* conf);
+    ~LogWriter(); // writes everything already submitted before returning
+
+    // The serialiser snapshots should be written with.
+    const ProgramSerialiser<T>& Serialiser() const { return serialiser; }
+
+    // Queues snapshot to be written, taking its contents (snapshot is left empty). Returns
+    // false if it was dropped because the queue was full. If keep is set it is never
+    // dropped, and Submit waits for room instead.
+    bool Submit(Snapshot& snapshot, bool keep = false);
+
+    // Blocks until every snapshot submitted so far has been written.
+    void Flush();
+
+    // The number of snapshots Submit has dropped.
+    unsigned int NumberOfDropped();
+
+  private:
+    LogWriter(const LogWriter<T>& rhs); // not copyable
+    LogWriter<T>& operator=(const LogWriter<T>& rhs);
+
+    void Work();
+
+    // Appends the statistics log entry / population dump text for snapshot to out:
+    void FormatStatistics(const Snapshot& snapshot, std::string& out) const;
+    void FormatPopulation(const Snapshot& snapshot, std::string& out) const;
+
+    // Notes the snapshots called droppedIdentifiers in the statistics log at droppedPath,
+    // then writes snapshot's logs (if it isn't 0). Throws a std::string if they can't be
+    // written.
+    void Write(const Snapshot* snapshot, const std::vector<std::string>& droppedIdentifiers,
+	       const std::string& droppedPath);
+
+    // Throws the error the writer thread kept, if there is one, clearing it. lock must be
+    // held.
+    void ThrowError();
+
+    // Writes text to the end of the statistics log at filePath, which is kept open between
+    // snapshots, or over the file at filePath. Both throw a std::string if the file can't be
+    // opened or written in full (e.g. when the disk is full).
+    void AppendToStatistics(const std::string& filePath, const std::string& text);
+    static void WriteFile(const std::string& filePath, const std::string& text);
+
+    ProgramSerialiser<T> serialiser;
+    Config<T>* config;
+
+    // Only used by the writer thread:
+    FILE* statsFile;
+    std::string statsFileOpenPath;
+    PopulationHistoryWriter<T>* history; // created by the first dump appended to it
+
+    // Only accessed while holding lock:
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<Snapshot*> queue;
+    // The identifiers of the snapshots dropped since the last one queued. The next snapshot
+    // queued takes them as its droppedBefore, so they are noted just before its logs, or the
+    // writer notes them itself once the queue is empty, as they came after everything in it:
+    std::vector<std::string> dropped;
+    std::string droppedStatsFilePath;
+    unsigned int numDropped;
+    std::string error; // the writer thread's first error not yet thrown, or empty
+    bool writing; // true while the writer thread is writing a snapshot it has taken
+    bool stopping;
+
+    std::thread writer;
+  };
+}
+
+
+
+////////////////////////////////// Inline Function Definitions /////////////////////////////////
+template <class T>
+VUWLGP::LogWriter<T>::LogWriter(VUWLGP::Config<T>* conf):
+serialiser(conf),
+config(conf),
+statsFile(0),
+history(0),
+numDropped(0),
+writing(false),
+stopping(false) {
+  writer = std::thread(&LogWriter<T>::Work, this);
+}
+
+
+
+template <class T>
+VUWLGP::LogWriter<T>::~LogWriter() {
+  {
+    std::unique_lock<std::mutex> guard(lock);
+    stopping = true;
+  }
+  changed.notify_all();
+  writer.join();
+
+  if(!error.empty()) {
+    std::cerr << error << std::endl;
+  }
+  if(statsFile != 0) {
+    std::fclose(statsFile);
+  }
+  delete history;
+}
+
+
+
+template <class T>
+bool VUWLGP::LogWriter<T>::Submit(Snapshot& snapshot, bool keep) {
+  std::unique_lock<std::mutex> guard(lock);
+  ThrowError();
+
+  unsigned int queueLength = config->logQueueLength > 0 ? config->logQueueLength : 1;
+  if(queue.size() >= queueLength && config->dropLogsWhenBehind && !keep) {
+    dropped.push_back(snapshot.identifier);
+    droppedStatsFilePath = snapshot.statsFilePath;
+    ++numDropped;
+    snapshot = Snapshot();
+    changed.notify_all();
+    return false;
+  }
+
+  while(queue.size() >= queueLength) {
+    changed.wait(guard);
+  }
+
+  Snapshot* queued = new Snapshot();
+  std::swap(*queued, snapshot);
+  queued->droppedBefore.swap(dropped);
+  queue.push_back(queued);
+  changed.notify_all();
+  return true;
+}
+
+
+
+template <class T>
+void VUWLGP::LogWriter<T>::Flush() {
+  std::unique_lock<std::mutex> guard(lock);
+  while(!queue.empty() || writing) {
+    changed.wait(guard);
+  }
+  ThrowError();
+}
+
+
+
+template <class T>
+unsigned int VUWLGP::LogWriter<T>::NumberOfDropped() {
+  std::unique_lock<std::mutex> guard(lock);
+  return numDropped;
+}
+
+
+
+template <class T>
+void VUWLGP::LogWriter<T>::Work() {
+  std::unique_lock<std::mutex> guard(lock);
+  while(true) {
+    while(queue.empty() && dropped.empty() && !stopping) {
+      changed.wait(guard);
+    }
+
+    if(queue.empty() && dropped.empty()) { // and so stopping
+      return;
+    }
+
+    // The snapshots dropped before the next one are noted just before it. Any dropped since
+    // the last one queued are only noted once the queue is empty:
+    std::vector<std::string> droppedIdentifiers;
+    std::string droppedPath = droppedStatsFilePath;
+    Snapshot* snapshot = 0;
+    if(!queue.empty()) {
+      snapshot = queue.front();
+      queue.pop_front();
+      droppedIdentifiers.swap(snapshot->droppedBefore);
+    }
+    else {
+      droppedIdentifiers.swap(dropped);
+    }
+    writing = true;
+    guard.unlock();
+    changed.notify_all(); // there is room in the queue
+
+    // Only the first error is kept, but the later snapshots are still tried, as e.g. only
+    // the population dumps might be unwritable:
+    std::string failure;
+    try {
+      Write(snapshot, droppedIdentifiers, droppedPath);
+    }
+    catch(const std::string& e) {
+      failure = e;
+    }
+    catch(const std::exception& e) {
+      failure = std::string("LogWriter - ") + e.what();
+    }
+    delete snapshot;
+
+    guard.lock();
+    if(error.empty()) {
+      error = failure;
+    }
+    writing = false;
+    changed.notify_all();
+  }
+}
+
+
+
+template <class T>
+void VUWLGP::LogWriter<T>::Write(const Snapshot* snapshot,
+				 const std::vector<std::string>& droppedIdentifiers,
+				 const std::string& droppedPath) {
+  std::string text;
+  if(!droppedIdentifiers.empty()) {
+    for(unsigned int i = 0; i < droppedIdentifiers.size(); ++i) {
+      text += "############################## " + droppedIdentifiers[i] +
+	" ##############################\n" +
+	"(not logged - the log writer fell behind)\n\n\n\n\n";
+    }
+    AppendToStatistics(droppedPath, text);
+  }
+
+  if(snapshot != 0) {
+    text.clear();
+    FormatStatistics(*snapshot, text);
+    AppendToStatistics(snapshot->statsFilePath, text);
+
+    if(!snapshot->popFilePath.empty() && config->popLogFormat != "history") {
+      text.clear();
+      FormatPopulation(*snapshot, text);
+      WriteFile(snapshot->popFilePath, text);
+    }
+
+    if(!snapshot->popFilePath.empty() && config->popLogFormat != "text") {
+      if(history == 0) {
+	history = new PopulationHistoryWriter<T>(config->popLogFilePath + ".history.bin",
+						 serialiser, config->historyKeyframeInterval);
+      }
+      history->Append(snapshot->identifier, snapshot->programs.empty() ? 0 :
+		      &snapshot->programs[0], snapshot->offsets, snapshot->sortedOrder);
+    }
+  }
+}
+
+
+
+template <class T>
+void VUWLGP::LogWriter<T>::ThrowError() {
+  if(!error.empty()) {
+    std::string thrown;
+    thrown.swap(error);
+    throw thrown;
+  }
+}
+
+
+
+template <class T>
+void VUWLGP::LogWriter<T>::FormatStatistics(const Snapshot& snapshot, std::string& out) const {
+  const unsigned char* data = snapshot.programs.empty() ? 0 : &snapshot.programs[0];
+  unsigned int size = snapshot.offsets.size();
+
+  // Calculate the statistics in the same order as IPopulation::LogStatistics, so that the
+  // sums come out exactly the same:
+  double fitnessSum = 0;
+  double sizeSum = 0;
+  std::set<std::string> distinctPrograms;
+
+  for(unsigned int i = 0; i < size; ++i) {
+    fitnessSum += ProgramSerialiser<T>::FitnessOf(data + snapshot.offsets[i]);
+    sizeSum += ProgramSerialiser<T>::LengthOf(data + snapshot.offsets[i]);
+
+    std::string program;
+    unsigned int offset = snapshot.offsets[i];
+    serialiser.Format(data, offset, true, false, program);
+    distinctPrograms.insert(program);
+  }
+
+  char line[128];
+  out += "############################## " + snapshot.identifier +
+    " ##############################\n";
+  std::snprintf(line, sizeof(line), "%-17s%u / %u\n", "Diversity:",
+		static_cast<unsigned int>(distinctPrograms.size()), size);
+  out += line;
+  std::snprintf(line, sizeof(line), "%-17s%g\n", "Average Fitness:", fitnessSum / size);
+  out += line;
+  std::snprintf(line, sizeof(line), "%-17s%g\n\n", "Average Size:", sizeSum / size);
+  out += line;
+
+  out += "Current Best Program:\n";
+  if(!snapshot.sortedOrder.empty()) {
+    unsigned int offset = snapshot.offsets[snapshot.sortedOrder[0]];
+    serialiser.Format(data, offset, true, true, out);
+  }
+  out += "\n\n\n\n\n";
+}
+
+
+
+template <class T>
+void VUWLGP::LogWriter<T>::FormatPopulation(const Snapshot& snapshot, std::string& out) const {
+  const unsigned char* data = snapshot.programs.empty() ? 0 : &snapshot.programs[0];
+  out.reserve(snapshot.programs.size() * 4);
+
+  std::vector<const unsigned char*> sorted;
+  for(unsigned int i = 0; i < snapshot.sortedOrder.size(); ++i) {
+    sorted.push_back(data + snapshot.offsets[snapshot.sortedOrder[i]]);
+  }
+
+  serialiser.FormatPopulation(sorted, out);
+}
+
+
+
+template <class T>
+void VUWLGP::LogWriter<T>::AppendToStatistics(const std::string& filePath,
+					      const std::string& text) {
+  if(statsFile == 0 || statsFileOpenPath != filePath) {
+    if(statsFile != 0) {
+      std::fclose(statsFile);
+    }
+    statsFile = std::fopen(filePath.c_str(), "ab");
+    statsFileOpenPath = filePath;
+    if(statsFile == 0) {
+      throw "LogWriter - could not open " + filePath;
+    }
+  }
+
+  bool written = std::fwrite(text.data(), 1, text.size(), statsFile) == text.size();
+  if(std::fflush(statsFile) != 0 || !written) {
+    throw "LogWriter - could not write " + filePath;
+  }
+}
+
+
+
+template <class T>
+void VUWLGP::LogWriter<T>::WriteFile(const std::string& filePath, const std::string& text) {
+  FILE* file = std::fopen(filePath.c_str(), "wb");
+  if(file == 0) {
+    throw "LogWriter - could not open " + filePath;
+  }
+  bool written = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+  if(std::fclose(file) != 0 || !written) {
+    throw "LogWriter - could not write " + filePath;
+  }
+}
+#endif
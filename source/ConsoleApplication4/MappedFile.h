@@ -0,0 +1,143 @@
+
+  
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace VUWLGP {
+  // A read-only view of the whole of a file, memory-mapped so that it can be read without
+  // copying it (and by several threads at once). Where mmap isn't available the file is read
+  // into memory instead. Throws a std::string if the file can't be opened or mapped.
+  class MappedFile {
+  public:
+    // If sequential is set the file is expected to be read once from start to end, so the
+    // kernel reads ahead aggressively and drops the pages which have been read.
+    MappedFile(const std::string& filePath, bool sequential = true);
+    ~MappedFile();
+
+    // The contents of the file, which are not null terminated. Data is null if Size is 0.
+    const char* Data() const { return data; }
+    size_t Size() const { return size; }
+
+    // Tells the kernel that [begin, begin + length), which must be part of Data, is about to be
+    // read (needed) so it can start reading it in, or won't be read again for a while (!needed)
+    // so its pages can be dropped - they are read from the file again if they are used. Does
+    // nothing if the file was read rather than mapped.
+    void Advise(const char* begin, size_t length, bool needed) const;
+
+  private:
+    MappedFile(const MappedFile& rhs); // not copyable
+    MappedFile& operator=(const MappedFile& rhs);
+
+    const char* data;
+    size_t size;
+    bool mapped; // false if data points into contents
+    std::vector<char> contents;
+  };
+}
+
+
+
+////////////////////////////////// INLINE FUNCTION DEFINITIONS /////////////////////////////////
+inline VUWLGP::MappedFile::MappedFile(const std::string& filePath, bool sequential):
+data(0),
+size(0),
+mapped(false) {
+#ifndef _WIN32
+  int fd = open(filePath.c_str(), O_RDONLY);
+  if(fd < 0) {
+    throw "MappedFile - could not open " + filePath;
+  }
+
+  struct stat status;
+  if(fstat(fd, &status) != 0) {
+    close(fd);
+    throw "MappedFile - could not read the size of " + filePath;
+  }
+
+  size = status.st_size;
+  if(size > 0) {
+    void* address = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(address == MAP_FAILED) {
+      close(fd);
+      throw "MappedFile - could not map " + filePath;
+    }
+
+    if(sequential) {
+      madvise(address, size, MADV_SEQUENTIAL);
+    }
+    data = static_cast<const char*>(address);
+    mapped = true;
+  }
+  close(fd);
+#else
+  FILE* file = std::fopen(filePath.c_str(), "rb");
+  if(file == 0) {
+    throw "MappedFile - could not open " + filePath;
+  }
+
+  std::fseek(file, 0, SEEK_END);
+  long fileSize = std::ftell(file);
+  std::fseek(file, 0, SEEK_SET);
+  if(fileSize > 0) {
+    contents.resize(fileSize);
+    if(std::fread(&contents[0], 1, contents.size(), file) != contents.size()) {
+      std::fclose(file);
+      throw "MappedFile - could not read " + filePath;
+    }
+    data = &contents[0];
+    size = contents.size();
+  }
+  std::fclose(file);
+#endif
+}
+
+
+
+inline void VUWLGP::MappedFile::Advise(const char* begin, size_t length, bool needed) const {
+#ifndef _WIN32
+  if(!mapped || length == 0) {
+    return;
+  }
+
+  // madvise works on whole pages. Pages partly in the range are read in, but only dropped if
+  // they are wholly in it, as their other parts may be about to be read.
+  size_t page = sysconf(_SC_PAGESIZE);
+  size_t start = begin - data;
+  size_t end = start + length;
+  if(needed) {
+    start = start / page * page;
+  }
+  else {
+    start = (start + page - 1) / page * page;
+    end = end < size ? end / page * page : size;
+  }
+
+  if(start < end) {
+    madvise(const_cast<char*>(data) + start, end - start,
+	    needed ? MADV_WILLNEED : MADV_DONTNEED);
+  }
+#endif
+}
+
+
+
+inline VUWLGP::MappedFile::~MappedFile() {
+#ifndef _WIN32
+  if(mapped) {
+    munmap(const_cast<char*>(data), size);
+  }
+#endif
+}
+#endif
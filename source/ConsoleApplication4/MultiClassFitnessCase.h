@@ -6,6 +6,7 @@
 #include <sstream>
 #include <string>
 
+#include "Dataset.h"
 #include "IFitnessCase.h"
 
 namespace VUWLGP {
@@ -14,6 +15,9 @@ namespace VUWLGP {
     // Initialise a MultiClassFitnessCase from a pattern file string (see docs for format)
     MultiClassFitnessCase(const std::string& patternFileLine);
 
+    // Initialise a MultiClassFitnessCase from case i of a Patterns Dataset.
+    MultiClassFitnessCase(const Dataset<T>& data, unsigned int i);
+
     // Return the 0-base class number of the class this case represents.
     unsigned int ClassNumber() const { return classNumber; }
 
@@ -21,6 +25,12 @@ namespace VUWLGP {
     // FitnessEnvironment will do if it is just passed to FitnessEnvironment<T>::AddCase).
     static IFitnessCase<T>* Generate(const std::string& patternFileLine);
 
+    // Returns a new MultiClassFitnessCase for case i of data, for FitnessEnvironment::AddCases.
+    static IFitnessCase<T>* Generate(const Dataset<T>& data, unsigned int i);
+
+    // Takes the class number from case i of data.
+    void View(const Dataset<T>& data, unsigned int i) { classNumber = data.ClassNumber(i); }
+
   protected:
     // To make it non-abstract this method from IFitnessCase is instantiated
     void MakeAbstract() const { }
@@ -49,7 +59,19 @@ VUWLGP::MultiClassFitnessCase<T>::MultiClassFitnessCase(const std::string& line)
   while(conv) {
     conv >> bufDouble;
     if(!conv) { break; } // Hacky work around, but it'll do
-    features.push_back(bufDouble);
+    this->features.push_back(bufDouble);
+  }
+}
+
+
+
+template <class T> 
+VUWLGP::MultiClassFitnessCase<T>::MultiClassFitnessCase(const VUWLGP::Dataset<T>& data,
+							unsigned int i):
+classNumber(data.ClassNumber(i)) {
+  this->features.reserve(data.NumberOfFeatures());
+  for(unsigned int f = 0; f < data.NumberOfFeatures(); ++f) {
+    this->features.push_back(data.F(f, i));
   }
 }
 
@@ -59,4 +81,11 @@ template <class T>
 VUWLGP::IFitnessCase<T>* VUWLGP::MultiClassFitnessCase<T>::Generate(const std::string& pFL) {
   return dynamic_cast<VUWLGP::IFitnessCase<T>*>(new VUWLGP::MultiClassFitnessCase<T>(pFL));
 }
+
+
+
+template <class T> VUWLGP::IFitnessCase<T>*
+VUWLGP::MultiClassFitnessCase<T>::Generate(const VUWLGP::Dataset<T>& data, unsigned int i) {
+  return new MultiClassFitnessCase<T>(data, i);
+}
 #endif
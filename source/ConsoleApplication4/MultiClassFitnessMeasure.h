@@ -40,7 +40,7 @@ VUWLGP::MultiClassFitnessMeasure<T>::UpdateError(const VUWLGP::RegisterCollectio
   if( (mcfc = dynamic_cast<const MultiClassFitnessCase<T>*>(fc)) != 0) {
     // then its a valid FC for multi class
     if(fRV.LargestRegisterIndex() != mcfc->ClassNumber()) {
-      fitness += 1;
+      this->fitness += 1;
     }
   }
   else { // wrong type of fitness case
@@ -53,7 +53,7 @@ VUWLGP::MultiClassFitnessMeasure<T>::UpdateError(const VUWLGP::RegisterCollectio
 template <class T>
 std::string VUWLGP::MultiClassFitnessMeasure<T>::ToString() const {
   std::ostringstream buffer;
-  buffer << OverallFitness();
+  buffer << this->OverallFitness();
   return buffer.str();
 }
 #endif
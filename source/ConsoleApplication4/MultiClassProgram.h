@@ -30,13 +30,13 @@ namespace VUWLGP {
 template <class T> 
 VUWLGP::MultiClassProgram<T>::MultiClassProgram(unsigned int programSize, 
 						VUWLGP::Config<T>* conf):
-IProgram<T>(conf, new MultiClassFitnessMeasure<double>(conf)){ 
+IProgram<T>(conf, new MultiClassFitnessMeasure<T>(conf)){ 
   // Construct all the instructions, they will be delete'd in the IProgram dtor, as will the
   // FitnessMeasure passed to its ctor.
-  instructions.reserve(programSize);
+  this->instructions.reserve(programSize);
 
   for(unsigned int i = 0; i < programSize; ++i) {
-    instructions.push_back(InstructionFactory(config));
+    this->instructions.push_back(InstructionFactory(this->config));
   }
 }
 
@@ -49,6 +49,6 @@ IProgram<T>(rhs) {
   // variable which helps take a stupidly long line of code and breaks it up at least a little.
   VUWLGP::MultiClassFitnessMeasure<T>* temp;
   temp = dynamic_cast<VUWLGP::MultiClassFitnessMeasure<T>*>(rhs.fitnessMeasure);
-  fitnessMeasure = new VUWLGP::MultiClassFitnessMeasure<T>(*temp);
+  this->fitnessMeasure = new VUWLGP::MultiClassFitnessMeasure<T>(*temp);
 }
 #endif
@@ -0,0 +1,304 @@
+
+  
+#ifndef MULTIRUNDRIVER_H
+#define MULTIRUNDRIVER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Config.h"
+#include "FitnessEnvironment.h"
+#include "IPopulation.h"
+#include "Rand.h"
+
+namespace VUWLGP {
+  // The outcome of one run of a MultiRunDriver. generations is capped at maxGenerations, so
+  // solved says whether a solution was found. time is wall-clock time in clock ticks
+  // (CLOCKS_PER_SEC per second), as clock() measures the CPU time of every concurrent run.
+  struct RunResult {
+    unsigned int seed;
+    unsigned int generations;
+    bool solved;
+    long time;
+    double trainingFitness;
+    double testFitness;
+    bool finished;
+  };
+
+
+
+  // Carries out Config::numRuns independent runs, Config::numConcurrentRuns at a time, each on
+  // its own thread with its own copy of the Config. Run r is seeded with randSeed + r (or the
+  // time + r if no seed was given), so it is reproducible on its own, and logs to the usual
+  // files (and checkpoint) with ".run<r>" inserted before the generation information or
+  // extension. Runs always start afresh, Config::resumeFrom is ignored. As each run finishes
+  // the usual line "generations,time,training fitness,test fitness" is appended to
+  // Config::runLogFilePath, as for a single run, and the labelled line
+  // "run<r>,generations,time,training fitness,test fitness" to Config::runSummaryFilePath.
+  // Once they all have, lines giving the mean, standard deviation and median of each column
+  // are appended to runSummaryFilePath too.
+  template <class IProgramSubclass, class T> class MultiRunDriver {
+  public:
+    // Generator functions build (and give the caller ownership of) a population and the
+    // training and test fitness environments for a run. They are called on the run's thread,
+    // after its random number generator has been seeded, and must be safe to call concurrently.
+    typedef IPopulation<IProgramSubclass, T>* (*PopulationGeneratorFunc)(Config<T>*);
+    typedef FitnessEnvironment<T>* (*EnvironmentGeneratorFunc)(Config<T>*);
+
+    MultiRunDriver(Config<T>* conf, PopulationGeneratorFunc pg, EnvironmentGeneratorFunc train,
+		   EnvironmentGeneratorFunc test);
+    // Default dtor
+
+    // Carries out every run and logs the results. Throws a std::string naming any runs which
+    // failed once all of the others have finished.
+    void Run();
+
+    // The results of each run. Only valid after Run has been called.
+    const RunResult& Result(unsigned int run) const { return results[run]; }
+
+    // Appends the mean, standard deviation and median of each column to runSummaryFilePath
+    // and prints them. Called by Run.
+    void LogSummary() const;
+
+  private:
+    MultiRunDriver(const MultiRunDriver& rhs); // not copyable
+    MultiRunDriver& operator=(const MultiRunDriver& rhs);
+
+    // The loop each of Run's threads runs, taking the next run to do until there are none left.
+    void Work();
+
+    // Carries out run number run on the calling thread. Catches anything it throws, leaving
+    // the run unfinished.
+    void RunOne(unsigned int run);
+
+    // Formats one line of the results file, or of the summary file if label isn't empty.
+    static std::string Line(const std::string& label, double generations, double time,
+			    double trainingFitness, double testFitness);
+
+    // Returns the sample mean, standard deviation and median of values.
+    static void Summarise(std::vector<double> values, double& mean, double& sd, double& median);
+
+    PopulationGeneratorFunc populationGenerator;
+    EnvironmentGeneratorFunc trainingGenerator;
+    EnvironmentGeneratorFunc testGenerator;
+
+    std::vector<RunResult> results;
+    std::atomic<unsigned int> nextRun;
+    unsigned int firstSeed;
+    std::mutex logLock; // serialises writes to the results files and std::cout
+
+    Config<T>* config;
+  };
+}
+
+
+
+////////////////////////////////// INLINE FUNCTION DEFINITIONS /////////////////////////////////
+template <class IProgramSubclass, class T>
+VUWLGP::MultiRunDriver<IProgramSubclass, T>::MultiRunDriver(Config<T>* conf,
+							     PopulationGeneratorFunc pg,
+							     EnvironmentGeneratorFunc train,
+							     EnvironmentGeneratorFunc test):
+populationGenerator(pg),
+trainingGenerator(train),
+testGenerator(test),
+results(conf->numRuns),
+firstSeed(0),
+config(conf) {
+  nextRun.store(0);
+}
+
+
+
+template <class IProgramSubclass, class T>
+void VUWLGP::MultiRunDriver<IProgramSubclass, T>::Run() {
+  firstSeed = config->seedSpecified ? config->randSeed : time(0);
+  nextRun.store(0);
+
+  unsigned int numThreads = config->numConcurrentRuns;
+  if(numThreads == 0) {
+    numThreads = std::thread::hardware_concurrency();
+  }
+  numThreads = std::max(1u, std::min(numThreads, config->numRuns));
+
+  std::vector<std::thread> threads;
+  for(unsigned int i = 0; i < numThreads; ++i) {
+    threads.push_back(std::thread(&MultiRunDriver::Work, this));
+  }
+
+  for(unsigned int i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  std::ostringstream failures;
+  for(unsigned int i = 0; i < results.size(); ++i) {
+    if(!results[i].finished) {
+      failures << " " << i;
+    }
+  }
+
+  if(!failures.str().empty()) {
+    throw "MultiRunDriver::Run - runs which did not finish:" + failures.str();
+  }
+
+  LogSummary();
+}
+
+
+
+template <class IProgramSubclass, class T>
+void VUWLGP::MultiRunDriver<IProgramSubclass, T>::LogSummary() const {
+  std::vector<double> columns[4];
+  for(unsigned int i = 0; i < results.size(); ++i) {
+    columns[0].push_back(results[i].generations);
+    columns[1].push_back(results[i].time);
+    columns[2].push_back(results[i].trainingFitness);
+    columns[3].push_back(results[i].testFitness);
+  }
+
+  double means[4], sds[4], medians[4];
+  for(unsigned int i = 0; i < 4; ++i) {
+    Summarise(columns[i], means[i], sds[i], medians[i]);
+  }
+
+  std::string summary = Line("mean", means[0], means[1], means[2], means[3]) +
+    Line("sd", sds[0], sds[1], sds[2], sds[3]) +
+    Line("median", medians[0], medians[1], medians[2], medians[3]);
+
+  std::ofstream fout(config->runSummaryFilePath.c_str(), std::ios::out | std::ios::app);
+  fout << summary;
+  fout.close();
+
+  std::cout << summary;
+}
+
+
+
+template <class IProgramSubclass, class T>
+void VUWLGP::MultiRunDriver<IProgramSubclass, T>::Work() {
+  for(unsigned int run = nextRun++; run < results.size(); run = nextRun++) {
+    RunOne(run);
+  }
+}
+
+
+
+template <class IProgramSubclass, class T>
+void VUWLGP::MultiRunDriver<IProgramSubclass, T>::RunOne(unsigned int run) {
+  RunResult& result = results[run];
+  result.seed = firstSeed + run;
+  result.finished = false;
+
+  try {
+    Config<T> runConfig(*config);
+    std::ostringstream suffix;
+    suffix << ".run" << run;
+    runConfig.statsLogFilePath += suffix.str();
+    runConfig.popLogFilePath += suffix.str();
+    runConfig.metricsFilePath += suffix.str();
+    runConfig.checkpointFilePath += suffix.str();
+    runConfig.randSeed = result.seed;
+    runConfig.seedSpecified = true;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Built in the same order as main's single run, so that a run with the same seed matches:
+    Rand::Init(result.seed);
+    std::unique_ptr<IPopulation<IProgramSubclass, T> > pop(populationGenerator(&runConfig));
+    std::unique_ptr<FitnessEnvironment<T> > train(trainingGenerator(&runConfig));
+    std::unique_ptr<FitnessEnvironment<T> > test(testGenerator(&runConfig));
+
+    unsigned int generationsUsed = pop->Evolve(*train);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    IProgram<T>* best = pop->GetFittestProgram();
+
+    result.solved = generationsUsed <= config->maxGenerations;
+    result.generations = std::min(generationsUsed, config->maxGenerations);
+    result.time = static_cast<long>(elapsed.count() * CLOCKS_PER_SEC);
+    result.trainingFitness = best->Fitness();
+    best->UpdateFitness(*test);
+    result.testFitness = best->Fitness();
+
+    std::ostringstream label;
+    label << "run" << run;
+    std::string line = Line(label.str(), result.generations, result.time,
+			    result.trainingFitness, result.testFitness);
+
+    std::lock_guard<std::mutex> guard(logLock);
+    std::ofstream fout(config->runLogFilePath.c_str(), std::ios::out | std::ios::app);
+    fout << Line("", result.generations, result.time, result.trainingFitness,
+		 result.testFitness);
+    fout.close();
+    fout.open(config->runSummaryFilePath.c_str(), std::ios::out | std::ios::app);
+    fout << line;
+    fout.close();
+
+    std::cout << line.substr(0, line.size() - 1) << " (seed " << result.seed << ", "
+	      << (result.solved ? "solved" : "not solved") << ")" << std::endl;
+    result.finished = true;
+  }
+  catch(const std::string& e) {
+    std::lock_guard<std::mutex> guard(logLock);
+    std::cout << "Run " << run << " failed: " << e << std::endl;
+  }
+  catch(const std::exception& e) {
+    std::lock_guard<std::mutex> guard(logLock);
+    std::cout << "Run " << run << " failed: " << e.what() << std::endl;
+  }
+}
+
+
+
+template <class IProgramSubclass, class T> std::string
+VUWLGP::MultiRunDriver<IProgramSubclass, T>::Line(const std::string& label, double generations,
+						   double time, double trainingFitness,
+						   double testFitness) {
+  std::ostringstream line;
+  if(!label.empty()) {
+    line << label << ",";
+  }
+  line << generations << "," << time << "," << trainingFitness << ","
+       << testFitness << "\n";
+  return line.str();
+}
+
+
+
+template <class IProgramSubclass, class T>
+void VUWLGP::MultiRunDriver<IProgramSubclass, T>::Summarise(std::vector<double> values,
+							     double& mean, double& sd,
+							     double& median) {
+  mean = sd = median = 0;
+  if(values.empty()) {
+    return;
+  }
+
+  for(unsigned int i = 0; i < values.size(); ++i) {
+    mean += values[i];
+  }
+  mean /= values.size();
+
+  // The sample standard deviation, 0 for a single run:
+  for(unsigned int i = 0; i < values.size(); ++i) {
+    sd += (values[i] - mean) * (values[i] - mean);
+  }
+  sd = values.size() > 1 ? std::sqrt(sd / (values.size() - 1)) : 0;
+
+  std::sort(values.begin(), values.end());
+  unsigned int middle = values.size() / 2;
+  median = values.size() % 2 == 1 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+#endif
@@ -0,0 +1,286 @@
+
+  
+#ifndef OPSET_H
+#define OPSET_H
+
+#include <limits>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+#include "Config.h"
+#include "FitnessEnvironment.h"
+#include "ICompiledProgram.h"
+#include "IInstructionOperation.h"
+#include "IInstructionOperationConditional.h"
+#include "IProgram.h"
+#include "Instruction.h"
+#include "InstructionArgumentConstant.h"
+#include "RegisterCollection.h"
+
+namespace VUWLGP {
+  // A set of operations fixed at compile time, e.g.
+  //   OpSet<double, InstructionOperationPlus, InstructionOperationIflt>
+  // Each operation's opcode is its position in the set, and a Program runs a program's
+  // effective code with a dispatch loop in which every operation is inlined, instead of
+  // the interpreter's virtual calls through each instruction's arguments and operation.
+  //
+  // Register adds the set's operations to Config::instructionOperations, in order, just as
+  // adding them one at a time does, so the runtime-registered path (and operations other
+  // than the set's) still work, and makes the set Config::programCompiler, which the
+  // "compiled" evaluation engine uses. Each assignment in the set must have a static
+  // Compute(first, second), and each conditional (a subclass of
+  // IInstructionOperationConditional) a static Holds(first, second), which compute exactly
+  // what their Execute does, so the fitnesses are exactly the same as the interpreter's.
+  template <class T, template <class> class... Operations> class OpSet {
+    static_assert(sizeof...(Operations) > 0 && sizeof...(Operations) <= 256,
+		  "An OpSet needs between 1 and 256 operations");
+
+    // A step writes the result of operation opcode on its first and second operand to its
+    // destination, or for a conditional skips to after the next assignment if it doesn't
+    // hold. Operands and destinations are slots, laid out as ExecutionPlan's are: the
+    // registers, then the features, then the program's constants.
+    struct Step {
+      unsigned char opcode;
+      unsigned short destination;
+      unsigned short first;
+      unsigned short second;
+    };
+
+  public:
+    static const unsigned int NumberOfOperations = sizeof...(Operations);
+
+    // A program compiled for the set. If NumRegisters isn't 0 it must be the Config's
+    // number of registers, which is then a constant the loops over the registers unroll by.
+    template <unsigned int NumRegisters = 0> class Program: public ICompiledProgram<T> {
+    public:
+      // Compiles prog's effective (non-intron) code. prog's introns must be marked, and every
+      // effective instruction's operation must be in the set (see Compile).
+      Program(const IProgram<T>& prog, const Config<T>* conf);
+      // Default cctor, dtor
+
+      void AccumulateError(IProgram<T>& prog, FitnessEnvironment<T>& fe) const;
+
+      // Runs the program on slots, whose registers must be zeroed and whose features and
+      // constants must be loaded (see NumberOfSlots).
+      void Execute(T* slots) const;
+
+      unsigned int NumberOfSteps() const { return steps.size(); }
+      unsigned int NumberOfRegisters() const {
+	return NumRegisters != 0 ? NumRegisters : numRegisters;
+      }
+      unsigned int NumberOfSlots() const {
+	return NumberOfRegisters() + numFeatures + constants.size();
+      }
+
+    private:
+      unsigned int numRegisters;
+      unsigned int numFeatures;
+      std::vector<Step> steps;
+      std::vector<T> constants;
+    };
+
+    // Adds the set's operations to conf->instructionOperations, in order and each with
+    // weight 1, and makes Compile<NumRegisters> conf->programCompiler.
+    template <unsigned int NumRegisters = 0> static void Register(Config<T>* conf);
+
+    // Returns a new Program<NumRegisters> of prog, whose introns must be marked, or 0 if
+    // prog's effective code has operations which aren't in the set. The caller is
+    // responsible for deleting it.
+    template <unsigned int NumRegisters>
+    static ICompiledProgram<T>* Compile(const IProgram<T>& prog, const Config<T>* conf);
+
+    // Returns the opcode of op - the position of its class in the set - or -1 if it isn't in
+    // the set.
+    static int OpcodeOf(const IInstructionOperation<T>* op);
+
+    static bool IsConditional(unsigned int opcode);
+
+  private:
+    // Runs step, whose opcode must be at least I, with the I'th operation onwards. Returns
+    // false if it is a conditional which doesn't hold. The comparisons of the opcode with
+    // each I are unrolled at compile time, so compilers make them a jump table.
+    template <unsigned int I>
+    static typename std::enable_if<(I < sizeof...(Operations)), bool>::type
+    Dispatch(const Step& step, T* slots);
+    template <unsigned int I>
+    static typename std::enable_if<(I == sizeof...(Operations)), bool>::type
+    Dispatch(const Step& step, T* slots) { return true; }
+
+    // Runs step with Operation, a conditional if the last argument is std::true_type.
+    template <class Operation>
+    static bool Apply(const Step& step, T* slots, std::true_type conditional) {
+      return Operation::Holds(slots[step.first], slots[step.second]);
+    }
+    template <class Operation>
+    static bool Apply(const Step& step, T* slots, std::false_type conditional) {
+      slots[step.destination] = Operation::Compute(slots[step.first], slots[step.second]);
+      return true;
+    }
+  };
+}
+
+
+
+////////////////////////////////// Inline Function Definitions /////////////////////////////////
+template <class T, template <class> class... Operations>
+template <unsigned int NumRegisters>
+VUWLGP::OpSet<T, Operations...>::Program<NumRegisters>::Program(
+  const VUWLGP::IProgram<T>& prog, const VUWLGP::Config<T>* conf):
+numRegisters(conf->numRegisters),
+numFeatures(conf->numFeatures) {
+  if(NumRegisters != 0 && NumRegisters != conf->numRegisters) {
+    throw std::string("OpSet::Program - compiled for a different number of registers");
+  }
+
+  const std::vector<Instruction<T>*>& instrs = prog.ConstRawAccessToTheInternalInstructions();
+  const IInstructionArgument<T>* operands[2];
+  for(unsigned int i = 0; i < instrs.size(); ++i) {
+    if(instrs[i]->IsIntron) {
+      continue;
+    }
+
+    Step step;
+    step.opcode = OpcodeOf(instrs[i]->Operation());
+    step.destination = instrs[i]->DestinationIndex();
+    operands[0] = instrs[i]->FirstArgument();
+    operands[1] = instrs[i]->SecondArgument();
+    unsigned short slots[2];
+    for(unsigned int j = 0; j < 2; ++j) {
+      switch(operands[j]->ArgumentType()) {
+      case ArgumentTypeRegister:
+	slots[j] = operands[j]->ArgumentIndex();
+	break;
+      case ArgumentTypeFeature:
+	slots[j] = NumberOfRegisters() + operands[j]->ArgumentIndex();
+	break;
+      default:
+	if(NumberOfSlots() >= std::numeric_limits<unsigned short>::max()) {
+	  throw std::string("OpSet::Program - too many slots");
+	}
+	slots[j] = NumberOfSlots();
+	constants.push_back(static_cast<const InstructionArgumentConstant<T>*>(operands[j])
+			    ->Constant());
+      }
+    }
+    step.first = slots[0];
+    step.second = slots[1];
+    steps.push_back(step);
+  }
+}
+
+
+
+template <class T, template <class> class... Operations>
+template <unsigned int NumRegisters>
+void VUWLGP::OpSet<T, Operations...>::Program<NumRegisters>::AccumulateError(
+  VUWLGP::IProgram<T>& prog, VUWLGP::FitnessEnvironment<T>& fe) const {
+  std::vector<T> slots(NumberOfSlots());
+  RegisterCollection<T> finalRegisterValues(NumberOfRegisters());
+  for(unsigned int i = 0; i < constants.size(); ++i) {
+    slots[NumberOfRegisters() + numFeatures + i] = constants[i];
+  }
+
+  for(bool more = fe.LoadFirstCase(); more; more = fe.LoadNextCase()) {
+    for(unsigned int r = 0; r < NumberOfRegisters(); ++r) {
+      slots[r] = 0;
+    }
+    for(unsigned int f = 0; f < numFeatures; ++f) {
+      slots[NumberOfRegisters() + f] = fe.ReadFeature(f);
+    }
+
+    Execute(&slots[0]);
+    for(unsigned int r = 0; r < NumberOfRegisters(); ++r) {
+      finalRegisterValues.Write(r, slots[r]);
+    }
+    prog.UpdateError(finalRegisterValues, fe.CurrentCase());
+  }
+}
+
+
+
+template <class T, template <class> class... Operations>
+template <unsigned int NumRegisters>
+void VUWLGP::OpSet<T, Operations...>::Program<NumRegisters>::Execute(T* slots) const {
+  // As the interpreter does, a false conditional skips every step up to and including the
+  // next assignment:
+  bool skipping = false;
+  for(typename std::vector<Step>::const_iterator step = steps.begin(); step != steps.end();
+      ++step) {
+    if(skipping) {
+      skipping = IsConditional(step->opcode);
+    }
+    else {
+      skipping = !Dispatch<0>(*step, slots);
+    }
+  }
+}
+
+
+
+template <class T, template <class> class... Operations>
+template <unsigned int NumRegisters>
+void VUWLGP::OpSet<T, Operations...>::Register(VUWLGP::Config<T>* conf) {
+  typedef IInstructionOperation<T>* (*OperationGeneratorFunc)(Config<T>*);
+  OperationGeneratorFunc generators[] = { &Operations<T>::Generate... };
+  for(unsigned int i = 0; i < NumberOfOperations; ++i) {
+    conf->instructionOperations->AddElement(generators[i]);
+  }
+  conf->programCompiler = &Compile<NumRegisters>;
+}
+
+
+
+template <class T, template <class> class... Operations>
+template <unsigned int NumRegisters>
+VUWLGP::ICompiledProgram<T>*
+VUWLGP::OpSet<T, Operations...>::Compile(const VUWLGP::IProgram<T>& prog,
+					 const VUWLGP::Config<T>* conf) {
+  const std::vector<Instruction<T>*>& instrs = prog.ConstRawAccessToTheInternalInstructions();
+  for(unsigned int i = 0; i < instrs.size(); ++i) {
+    if(!instrs[i]->IsIntron && OpcodeOf(instrs[i]->Operation()) < 0) {
+      return 0;
+    }
+  }
+  return new Program<NumRegisters>(prog, conf);
+}
+
+
+
+template <class T, template <class> class... Operations>
+int VUWLGP::OpSet<T, Operations...>::OpcodeOf(const VUWLGP::IInstructionOperation<T>* op) {
+  static const std::type_info* types[] = { &typeid(Operations<T>)... };
+  for(unsigned int i = 0; i < NumberOfOperations; ++i) {
+    if(typeid(*op) == *types[i]) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+
+
+template <class T, template <class> class... Operations>
+bool VUWLGP::OpSet<T, Operations...>::IsConditional(unsigned int opcode) {
+  static const bool conditional[] = {
+    std::is_base_of<IInstructionOperationConditional<T>, Operations<T> >::value...
+  };
+  return conditional[opcode];
+}
+
+
+
+template <class T, template <class> class... Operations>
+template <unsigned int I>
+typename std::enable_if<(I < sizeof...(Operations)), bool>::type
+VUWLGP::OpSet<T, Operations...>::Dispatch(const Step& step, T* slots) {
+  typedef typename std::tuple_element<I, std::tuple<Operations<T>...> >::type Operation;
+  if(step.opcode != I) {
+    return Dispatch<I + 1>(step, slots);
+  }
+  return Apply<Operation>(step, slots,
+			  std::is_base_of<IInstructionOperationConditional<T>, Operation>());
+}
+#endif
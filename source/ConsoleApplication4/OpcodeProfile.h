@@ -0,0 +1,130 @@
+
+  
+#ifndef OPCODEPROFILE_H
+#define OPCODEPROFILE_H
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ExecutionPlan.h"
+
+namespace VUWLGP {
+  // Counts how often each pair and each triple of consecutive opcodes occurs in the
+  // ExecutionPlans it is shown, e.g. those a population compiles during a run, and chooses
+  // from the counts which superinstructions are worth fusing (see ExecutionPlan::Fuse).
+  template <class T> class OpcodeProfile {
+  public:
+    OpcodeProfile();
+    // Default cctor, dtor
+
+    // Adds the pairs and triples of opcodes in plan, which mustn't have been fused, to the
+    // counts.
+    void Count(const ExecutionPlan<T>& plan);
+
+    // Returns which superinstructions (indexed by opcode, for ExecutionPlan::Fuse) are made
+    // of pairs which are at least share of the pairs counted. None are before any are.
+    std::vector<bool> Choose(double share) const;
+
+    // Returns the numShown most common pairs and triples, and their shares of the counts.
+    std::string ToString(unsigned int numShown = 5) const;
+
+  private:
+    static const unsigned int NumBasicOpcodes = ExecutionPlan<T>::OpCopy + 1;
+
+    // Appends the numShown largest counts to buffer, each as its length (2 or 3) opcodes.
+    static void ListMostCommon(std::ostringstream& buffer,
+			       const std::vector<unsigned long>& counts, unsigned long total,
+			       unsigned int length, unsigned int numShown);
+
+    // The count of pair (a, b) is at [a * NumBasicOpcodes + b], and of triple (a, b, c) at
+    // [(a * NumBasicOpcodes + b) * NumBasicOpcodes + c].
+    std::vector<unsigned long> pairs;
+    std::vector<unsigned long> triples;
+    unsigned long numPairs;
+    unsigned long numTriples;
+  };
+}
+
+
+
+////////////////////////////////// Inline Function Definitions /////////////////////////////////
+template <class T>
+VUWLGP::OpcodeProfile<T>::OpcodeProfile():
+pairs(NumBasicOpcodes * NumBasicOpcodes, 0),
+triples(NumBasicOpcodes * NumBasicOpcodes * NumBasicOpcodes, 0),
+numPairs(0),
+numTriples(0) {
+}
+
+
+
+template <class T>
+void VUWLGP::OpcodeProfile<T>::Count(const VUWLGP::ExecutionPlan<T>& plan) {
+  for(unsigned int i = 0; i + 1 < plan.NumberOfSteps(); ++i) {
+    unsigned int pair = plan.StepAt(i).opcode * NumBasicOpcodes + plan.StepAt(i + 1).opcode;
+    ++pairs[pair];
+    ++numPairs;
+    if(i + 2 < plan.NumberOfSteps()) {
+      ++triples[pair * NumBasicOpcodes + plan.StepAt(i + 2).opcode];
+      ++numTriples;
+    }
+  }
+}
+
+
+
+template <class T>
+std::vector<bool> VUWLGP::OpcodeProfile<T>::Choose(double share) const {
+  std::vector<bool> chosen(ExecutionPlan<T>::NumberOfOpcodes, false);
+  for(unsigned int opcode = ExecutionPlan<T>::OpIfltPlus; opcode < chosen.size(); ++opcode) {
+    typename ExecutionPlan<T>::Step superinstruction = { 0 }, parts[2];
+    superinstruction.opcode = opcode;
+    ExecutionPlan<T>::Unfuse(superinstruction, parts);
+
+    unsigned long count = pairs[parts[0].opcode * NumBasicOpcodes + parts[1].opcode];
+    chosen[opcode] = count > 0 && count >= share * numPairs;
+  }
+  return chosen;
+}
+
+
+
+template <class T>
+std::string VUWLGP::OpcodeProfile<T>::ToString(unsigned int numShown) const {
+  std::ostringstream buffer;
+  buffer << "Most common step pairs:";
+  ListMostCommon(buffer, pairs, numPairs, 2, numShown);
+  buffer << "\nMost common step triples:";
+  ListMostCommon(buffer, triples, numTriples, 3, numShown);
+  return buffer.str();
+}
+
+
+
+template <class T>
+void VUWLGP::OpcodeProfile<T>::ListMostCommon(std::ostringstream& buffer,
+					      const std::vector<unsigned long>& counts,
+					      unsigned long total, unsigned int length,
+					      unsigned int numShown) {
+  std::vector<std::pair<unsigned long, unsigned int> > order; // (count, index)
+  for(unsigned int i = 0; i < counts.size(); ++i) {
+    if(counts[i] > 0) {
+      order.push_back(std::make_pair(counts[i], i));
+    }
+  }
+  std::sort(order.rbegin(), order.rend());
+
+  const char* names[] = { "+", "-", "*", "/", "if<", "=" };
+  for(unsigned int i = 0; i < order.size() && i < numShown; ++i) {
+    buffer << (i == 0 ? " " : ", ");
+    unsigned int divisor = length == 3 ? NumBasicOpcodes * NumBasicOpcodes : NumBasicOpcodes;
+    for(; divisor > 0; divisor /= NumBasicOpcodes) {
+      buffer << names[order[i].second / divisor % NumBasicOpcodes] << (divisor > 1 ? " " : "");
+    }
+    buffer << " " << 100.0 * order[i].first / total << "%";
+  }
+}
+#endif
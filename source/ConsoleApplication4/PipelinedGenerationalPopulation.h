@@ -0,0 +1,102 @@
+
+  
+#ifndef PIPELINEDGENERATIONALPOPULATION_H
+#define PIPELINEDGENERATIONALPOPULATION_H
+
+#include "EvaluationPool.h"
+#include "GenerationalTournamentPopulation.h"
+
+namespace VUWLGP {
+  // A GenerationalTournamentPopulation which overlaps breeding with evaluation. While Evolve
+  // runs, each child is handed to an EvaluationPool of Config::NumberOfThreads() threads as soon
+  // as it has been bred, so the serial breeding of a generation runs alongside the evaluation of
+  // its earlier children rather than in front of all of it. Selection for generation g + 1 needs
+  // every fitness of generation g, so the pipeline drains at the end of each generation.
+  //
+  // Children are bred in the same order, from the same random numbers, as in a
+  // GenerationalTournamentPopulation, and evaluation doesn't use random numbers, so a run with
+  // the same seed produces exactly the same results as the standard generational scheme.
+  template <class IProgramSubclass, class T>
+  class PipelinedGenerationalPopulation:
+    public GenerationalTournamentPopulation<IProgramSubclass, T> {
+  public:
+    // Uses the default cctor, dtor
+    PipelinedGenerationalPopulation(Config<T>* conf):
+      GenerationalTournamentPopulation<IProgramSubclass, T>(conf), pool(0) { }
+
+    unsigned int Evolve(FitnessEnvironment<T>& fe);
+
+    // Waits for the children already streamed to the pool, then evaluates any other flagged
+    // programs (e.g. the initial population) in parallel. Evaluates serially outside Evolve.
+    void EvaluateFlaggedPrograms(FitnessEnvironment<T>& fe);
+
+  protected:
+    // Streams the child to the evaluation pool, if Evolve is running.
+    void ChildBred(IProgramSubclass* child);
+
+    EvaluationPool<T>* pool; // only non-null during Evolve
+  };
+}
+
+
+
+////////////////////////////////// Inline Function Definitions /////////////////////////////////
+template <class IProgramSubclass, class T> unsigned int
+VUWLGP::PipelinedGenerationalPopulation<IProgramSubclass, T>::Evolve
+(VUWLGP::FitnessEnvironment<T>& fe) {
+  // The tuning decides whether there is a pool, and its number of threads:
+  if(this->config->autotune && this->TuningDecision().empty()) {
+    this->Autotune(fe);
+  }
+
+  // Children can't be streamed to the pool if each generation is to be evaluated a block of
+  // cases at a time:
+  if(this->config->evaluationChunkSize != 0 || this->config->evaluationTileSize != 0) {
+    return IPopulation<IProgramSubclass, T>::Evolve(fe);
+  }
+
+  EvaluationPool<T> evaluators(fe, this->config->NumberOfThreads());
+  pool = &evaluators;
+
+  try {
+    unsigned int result = IPopulation<IProgramSubclass, T>::Evolve(fe);
+    pool = 0;
+    return result;
+  }
+  catch(...) {
+    pool = 0;
+    throw;
+  }
+}
+
+
+
+template <class IProgramSubclass, class T> void
+VUWLGP::PipelinedGenerationalPopulation<IProgramSubclass, T>::EvaluateFlaggedPrograms
+(VUWLGP::FitnessEnvironment<T>& fe) {
+  if(pool == 0) {
+    IPopulation<IProgramSubclass, T>::EvaluateFlaggedPrograms(fe);
+    return;
+  }
+
+  pool->Wait();
+
+  for(unsigned int i = 0; i < this->Size(); ++i) {
+    if(!this->programs[i]->FitnessStatusReference()) {
+      pool->Submit(this->programs[i]);
+    }
+  }
+
+  pool->Wait();
+}
+
+
+
+template <class IProgramSubclass, class T> void
+VUWLGP::PipelinedGenerationalPopulation<IProgramSubclass, T>::ChildBred
+(IProgramSubclass* child) {
+  if(pool != 0) {
+    pool->Submit(child);
+  }
+}
+#endif
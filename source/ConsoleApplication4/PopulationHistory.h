@@ -0,0 +1,787 @@
+
+  
+#ifndef POPULATIONHISTORY_H
+#define POPULATIONHISTORY_H
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ProgramSerialiser.h"
+
+namespace VUWLGP {
+  // A population history file records every population dump of a run in one file, much more
+  // compactly than the text dumps. It starts with a header:
+  //
+  //   the 8 byte tag "VUWLGPPH", unsigned int version (2), unsigned int sizeof(T), unsigned int
+  //   number of operations, then for each operation an unsigned char of flags (bit 0 set for a
+  //   conditional, bit 1 for a unary operation) and its symbol as an unsigned int length
+  //   followed by the characters
+  //
+  // so that it can be read without the Config it was written with, followed by one record per
+  // dump:
+  //
+  //   unsigned char kind ('K' for a keyframe, 'D' for a delta), the identifier (generation) as
+  //   an unsigned int length and the characters, unsigned int number of programs, unsigned int
+  //   number of bytes in the rest of the record, then the programs
+  //
+  // The programs are in the order they are dumped (fittest first), each stored as an unsigned
+  // char kind followed by:
+  //
+  //   0: the source (see below) of an identical program, with the same fitness - e.g. an
+  //   elite, or a duplicate
+  //   1: the program in full, as written by ProgramSerialiser
+  //   2: the program as pieces of other programs: its fitness and fitness status as
+  //   ProgramSerialiser writes them, its length, its instructions' intron flags as a bit
+  //   each, then pieces, each count * 2 + 1 followed by the source and the position in it of
+  //   count instructions to copy, or count * 2 followed by count instructions in full
+  //
+  // A source is a position in the previous record, or the number of programs in the previous
+  // record plus a position earlier in this one. The copied instructions only have to match
+  // bar their intron flags. A mutated child is mostly one piece of its parent before and one
+  // after the mutation, and a crossed over child is pieces of its two parents, so most
+  // programs take a fraction of their size. Lengths, counts, sources and positions are
+  // stored as variable length unsigned integers (7 bits a byte, least significant first, the
+  // top bit set in all but the last). Keyframes only refer to programs within themselves,
+  // and every Config::historyKeyframeInterval'th record is one, so that a generation can be
+  // rebuilt without reading the history from the start. Values are stored in the native
+  // byte order. Version 1 histories, whose keyframes store every program in full without
+  // a kind and whose deltas only have kinds 0 and 1 (with unsigned int sources), can still
+  // be read.
+  template <class T> class PopulationHistoryWriter {
+  public:
+    // Appends to the history at filePath, writing the header first if the file is new. The
+    // first record appended is always a keyframe. Throws a std::string if the file can't be
+    // opened, or already holds a history with a different header (version, register type or
+    // operations), whose records the new ones couldn't be read with.
+    PopulationHistoryWriter(const std::string& filePath, const ProgramSerialiser<T>& ps,
+			    unsigned int keyframeInterval);
+    ~PopulationHistoryWriter();
+
+    // Appends a record of the programs at data + offsets[order[0]], data + offsets[order[1]]...
+    void Append(const std::string& identifier, const unsigned char* data,
+		const std::vector<unsigned int>& offsets, const std::vector<unsigned int>& order);
+
+    // Appends val to out as a variable length unsigned integer.
+    static void AppendVariable(unsigned int val, std::vector<unsigned char>& out);
+
+  private:
+    PopulationHistoryWriter(const PopulationHistoryWriter<T>& rhs); // not copyable
+    PopulationHistoryWriter<T>& operator=(const PopulationHistoryWriter<T>& rhs);
+
+    // The programs of a record, one after another, the offsets of each one's instructions
+    // (see ProgramSerialiser::InstructionOffsets) from its start, and the positions of the
+    // programs by Hash and of each pair of consecutive instructions in them (as the program
+    // and instruction) by PairHash:
+    struct Programs {
+      typedef std::unordered_multimap<unsigned long long, unsigned int> ByHash;
+      typedef std::unordered_multimap<unsigned long long,
+				      std::pair<unsigned int, unsigned int> > ByPair;
+
+      std::vector<unsigned char> data;
+      std::vector<unsigned int> offsets;
+      std::vector<std::vector<unsigned int> > instrs;
+      ByHash byHash;
+      ByPair byPair;
+
+      // Adds the program at program, with the given instructions and Hash.
+      void Add(const unsigned char* program, const std::vector<unsigned int>& programInstrs,
+	       unsigned long long hash);
+    };
+
+    // Appends the source of a program identical to program (of size bytes and hash hash) in
+    // previous, unless keyframe is set, or current to out. Returns false, appending nothing,
+    // if there isn't one.
+    bool AppendIdentical(const unsigned char* program, unsigned int size,
+			 unsigned long long hash, const Programs& current, bool keyframe,
+			 std::vector<unsigned char>& out) const;
+
+    // Appends program, with the given instructions, as pieces (kind 2) of itself and the
+    // programs in previous, unless keyframe is set, and current to out.
+    void AppendPieces(const unsigned char* program, const std::vector<unsigned int>& instrs,
+		      const Programs& current, bool keyframe, std::vector<unsigned char>& out)
+      const;
+
+    static unsigned long long Hash(const unsigned char* data, unsigned int size);
+
+    // Hashes the two instructions at first and second ignoring their intron flags, and
+    // compares two instructions ignoring their intron flags.
+    static unsigned long long PairHash(const unsigned char* first, const unsigned char* second);
+    static bool SameInstruction(const unsigned char* first, const unsigned char* second);
+
+    // The most places with the same pair of instructions AppendPieces tries to copy from, in
+    // each record:
+    static const unsigned int MaxPieceCandidates = 16;
+
+    FILE* file;
+    unsigned int keyframeInterval;
+    unsigned int recordsSinceKeyframe;
+    bool appended;
+    Programs previous;
+  };
+
+
+
+  // Reads a population history file, and rebuilds the populations recorded in it.
+  template <class T> class PopulationHistoryReader {
+  public:
+    // Reads the whole history at filePath into memory. Throws a std::string if it can't be
+    // read, isn't a history or was written with a different T.
+    PopulationHistoryReader(const std::string& filePath);
+    ~PopulationHistoryReader();
+
+    // Returns sizeof(T) for the history at filePath, so the caller can pick the reader to use.
+    static unsigned int TypeSize(const std::string& filePath);
+
+    // The identifiers of the records in the history, in the order they were written.
+    std::vector<std::string> Identifiers() const;
+
+    // Appends exactly the text IPopulation::LogPopulation would have written for the
+    // population the record with identifier records to out. Throws if there isn't one.
+    void FormatPopulation(const std::string& identifier, std::string& out) const;
+
+  private:
+    struct Record {
+      std::string identifier;
+      bool keyframe;
+      unsigned int numPrograms;
+      unsigned int start; // offset of the first program in contents
+      unsigned int end;
+    };
+
+    PopulationHistoryReader(const PopulationHistoryReader<T>& rhs); // not copyable
+    PopulationHistoryReader<T>& operator=(const PopulationHistoryReader<T>& rhs);
+
+    // Sets programs to the serialised programs of record number record.
+    void Rebuild(unsigned int record, std::vector<std::vector<unsigned char> >& programs) const;
+
+    // Sets program to the program of kind 2 at data[offset], whose sources are in previous
+    // and then current (the programs before it in its record), advancing offset. Throws a
+    // std::string if it refers to a program or instruction which isn't there or runs past
+    // end.
+    static void ReadPieces(const std::vector<std::vector<unsigned char> >& previous,
+			   const std::vector<std::vector<unsigned char> >& current,
+			   const unsigned char* data, unsigned int& offset, unsigned int end,
+			   std::vector<unsigned char>& program);
+
+    // Reads a variable length unsigned integer from data[offset], advancing offset. Throws a
+    // std::string if it runs past end.
+    static unsigned int ExtractVariable(const unsigned char* data, unsigned int& offset,
+					unsigned int end);
+
+    // Returns the program source refers to in previous and then current.
+    static const std::vector<unsigned char>&
+      Source(const std::vector<std::vector<unsigned char> >& previous,
+	     const std::vector<std::vector<unsigned char> >& current, unsigned int source);
+
+    unsigned int version;
+    std::vector<unsigned char> contents;
+    std::vector<Record> records;
+    ProgramSerialiser<T>* serialiser;
+  };
+}
+
+
+
+////////////////////////////////// Inline Function Definitions /////////////////////////////////
+template <class T>
+VUWLGP::PopulationHistoryWriter<T>::PopulationHistoryWriter(const std::string& filePath,
+							    const ProgramSerialiser<T>& ps,
+							    unsigned int interval):
+file(0),
+keyframeInterval(interval > 0 ? interval : 1),
+recordsSinceKeyframe(0),
+appended(false) {
+  typedef ProgramSerialiser<T> PS;
+  std::vector<unsigned char> header(reinterpret_cast<const unsigned char*>("VUWLGPPH"),
+				    reinterpret_cast<const unsigned char*>("VUWLGPPH") + 8);
+  PS::template Append<unsigned int>(2, header);
+  PS::template Append<unsigned int>(sizeof(T), header);
+  PS::template Append<unsigned int>(ps.NumberOfOperations(), header);
+
+  for(unsigned int i = 0; i < ps.NumberOfOperations(); ++i) {
+    const std::string& symbol = ps.OperationSymbol(i);
+    PS::template Append<unsigned char>((ps.OperationIsConditional(i) ? 1 : 0) |
+				       (ps.OperationIsUnary(i) ? 2 : 0), header);
+    PS::template Append<unsigned int>(symbol.size(), header);
+    header.insert(header.end(), symbol.begin(), symbol.end());
+  }
+
+  // An existing history is only appended to if it starts with the same header:
+  file = std::fopen(filePath.c_str(), "rb");
+  if(file != 0) {
+    std::vector<unsigned char> existing(header.size());
+    unsigned int read = std::fread(&existing[0], 1, existing.size(), file);
+    std::fclose(file);
+    file = 0;
+
+    if(read != 0 && (read != header.size() || existing != header)) {
+      throw "PopulationHistoryWriter - " + filePath + " was written with another version, " +
+	"register type or set of operations, so can't be appended to";
+    }
+  }
+
+  file = std::fopen(filePath.c_str(), "ab");
+  if(file == 0) {
+    throw "PopulationHistoryWriter - could not open " + filePath;
+  }
+
+  std::fseek(file, 0, SEEK_END);
+  if(std::ftell(file) == 0) {
+    std::fwrite(&header[0], 1, header.size(), file);
+  }
+}
+
+
+
+template <class T>
+VUWLGP::PopulationHistoryWriter<T>::~PopulationHistoryWriter() {
+  if(file != 0) {
+    std::fclose(file);
+  }
+}
+
+
+
+template <class T> void
+VUWLGP::PopulationHistoryWriter<T>::Append(const std::string& identifier,
+					   const unsigned char* data,
+					   const std::vector<unsigned int>& offsets,
+					   const std::vector<unsigned int>& order) {
+  typedef ProgramSerialiser<T> PS;
+  bool keyframe = !appended || recordsSinceKeyframe + 1 >= keyframeInterval;
+
+  std::vector<unsigned char> body;
+  std::vector<unsigned char> pieces;
+  Programs current;
+  std::vector<unsigned int> instrs;
+
+  for(unsigned int i = 0; i < order.size(); ++i) {
+    const unsigned char* program = data + offsets[order[i]];
+    PS::InstructionOffsets(program, instrs);
+    unsigned int size = instrs.back();
+    unsigned long long hash = Hash(program, size);
+
+    if(!AppendIdentical(program, size, hash, current, keyframe, body)) {
+      pieces.clear();
+      AppendPieces(program, instrs, current, keyframe, pieces);
+
+      PS::template Append<unsigned char>(pieces.size() < size ? 2 : 1, body);
+      if(pieces.size() < size) {
+	body.insert(body.end(), pieces.begin(), pieces.end());
+      }
+      else {
+	body.insert(body.end(), program, program + size);
+      }
+    }
+
+    current.Add(program, instrs, hash);
+  }
+
+  std::vector<unsigned char> header;
+  PS::template Append<unsigned char>(keyframe ? 'K' : 'D', header);
+  PS::template Append<unsigned int>(identifier.size(), header);
+  header.insert(header.end(), identifier.begin(), identifier.end());
+  PS::template Append<unsigned int>(order.size(), header);
+  PS::template Append<unsigned int>(body.size(), header);
+
+  std::fwrite(&header[0], 1, header.size(), file);
+  if(!body.empty()) {
+    std::fwrite(&body[0], 1, body.size(), file);
+  }
+  std::fflush(file);
+
+  recordsSinceKeyframe = keyframe ? 0 : recordsSinceKeyframe + 1;
+  appended = true;
+  std::swap(previous, current);
+}
+
+
+
+template <class T> void
+VUWLGP::PopulationHistoryWriter<T>::AppendVariable(unsigned int val,
+						   std::vector<unsigned char>& out) {
+  while(val >= 0x80) {
+    out.push_back(static_cast<unsigned char>(val | 0x80));
+    val >>= 7;
+  }
+  out.push_back(static_cast<unsigned char>(val));
+}
+
+
+
+template <class T> void
+VUWLGP::PopulationHistoryWriter<T>::Programs::Add(
+  const unsigned char* program, const std::vector<unsigned int>& programInstrs,
+  unsigned long long hash) {
+  unsigned int position = offsets.size();
+  byHash.insert(std::make_pair(hash, position));
+  for(unsigned int i = 0; i + 2 < programInstrs.size(); ++i) {
+    byPair.insert(std::make_pair(PairHash(program + programInstrs[i],
+					  program + programInstrs[i + 1]),
+				 std::make_pair(position, i)));
+  }
+
+  offsets.push_back(data.size());
+  instrs.push_back(programInstrs);
+  data.insert(data.end(), program, program + programInstrs.back());
+}
+
+
+
+template <class T> bool
+VUWLGP::PopulationHistoryWriter<T>::AppendIdentical(const unsigned char* program,
+						    unsigned int size, unsigned long long hash,
+						    const Programs& current, bool keyframe,
+						    std::vector<unsigned char>& out) const {
+  typedef typename Programs::ByHash::const_iterator Iterator;
+
+  const Programs* records[] = { &previous, &current };
+  unsigned int first = keyframe ? 1 : 0;
+  for(unsigned int r = first; r < 2; ++r) {
+    std::pair<Iterator, Iterator> matches = records[r]->byHash.equal_range(hash);
+
+    for(Iterator it = matches.first; it != matches.second; ++it) {
+      const unsigned char* candidate = &records[r]->data[records[r]->offsets[it->second]];
+      if(records[r]->instrs[it->second].back() == size &&
+	 std::memcmp(candidate, program, size) == 0) {
+	out.push_back(0);
+	AppendVariable((r == 1 && !keyframe ? previous.offsets.size() : 0) + it->second, out);
+	return true;
+      }
+    }
+  }
+  return false;
+}
+
+
+
+template <class T> void
+VUWLGP::PopulationHistoryWriter<T>::AppendPieces(const unsigned char* program,
+						 const std::vector<unsigned int>& instrs,
+						 const Programs& current, bool keyframe,
+						 std::vector<unsigned char>& out) const {
+  typedef typename Programs::ByPair::const_iterator Iterator;
+
+  unsigned int length = instrs.size() - 1;
+  out.insert(out.end(), program, program + sizeof(double) + 1);
+  AppendVariable(length, out);
+
+  std::vector<unsigned char> introns((length + 7) / 8);
+  for(unsigned int i = 0; i < length; ++i) {
+    introns[i / 8] |= (program[instrs[i] + 1] & 1) << (i % 8);
+  }
+  out.insert(out.end(), introns.begin(), introns.end());
+
+  // Greedily copy the longest run of instructions starting with the same pair as the next
+  // two, where that is smaller than storing them, and otherwise store the instruction:
+  const Programs* records[] = { &previous, &current };
+  unsigned int literals = 0; // the first instruction not yet stored or copied
+  unsigned int i = 0;
+  while(i < length) {
+    unsigned int bestSource = 0;
+    unsigned int bestStart = 0;
+    unsigned int bestCount = 0;
+    for(unsigned int r = keyframe ? 1 : 0; r < 2 && i + 1 < length; ++r) {
+      std::pair<Iterator, Iterator> matches =
+	records[r]->byPair.equal_range(PairHash(program + instrs[i], program + instrs[i + 1]));
+
+      unsigned int tried = 0;
+      for(Iterator it = matches.first; it != matches.second && tried < MaxPieceCandidates;
+	  ++it, ++tried) {
+	const unsigned char* source = &records[r]->data[records[r]->offsets[it->second.first]];
+	const std::vector<unsigned int>& sourceInstrs = records[r]->instrs[it->second.first];
+	unsigned int start = it->second.second;
+
+	unsigned int count = 0;
+	while(i + count < length && start + count + 1 < sourceInstrs.size() &&
+	      SameInstruction(program + instrs[i + count],
+			      source + sourceInstrs[start + count])) {
+	  ++count;
+	}
+
+	if(count > bestCount) {
+	  bestSource = (r == 1 && !keyframe ? previous.offsets.size() : 0) + it->second.first;
+	  bestStart = start;
+	  bestCount = count;
+	}
+      }
+    }
+
+    std::vector<unsigned char> copy;
+    if(bestCount > 0) {
+      AppendVariable(bestCount * 2 + 1, copy);
+      AppendVariable(bestSource, copy);
+      AppendVariable(bestStart, copy);
+    }
+
+    if(bestCount == 0 || copy.size() >= instrs[i + bestCount] - instrs[i]) {
+      ++i;
+      continue;
+    }
+
+    if(literals < i) {
+      AppendVariable((i - literals) * 2, out);
+      out.insert(out.end(), program + instrs[literals], program + instrs[i]);
+    }
+    out.insert(out.end(), copy.begin(), copy.end());
+    i += bestCount;
+    literals = i;
+  }
+
+  if(literals < length) {
+    AppendVariable((length - literals) * 2, out);
+    out.insert(out.end(), program + instrs[literals], program + instrs[length]);
+  }
+}
+
+
+
+template <class T> unsigned long long
+VUWLGP::PopulationHistoryWriter<T>::Hash(const unsigned char* data, unsigned int size) {
+  // 64 bit FNV-1a:
+  unsigned long long hash = 14695981039346656037ull;
+  for(unsigned int i = 0; i < size; ++i) {
+    hash = (hash ^ data[i]) * 1099511628211ull;
+  }
+  return hash;
+}
+
+
+
+template <class T> unsigned long long
+VUWLGP::PopulationHistoryWriter<T>::PairHash(const unsigned char* first,
+					     const unsigned char* second) {
+  const unsigned int maxSize = 3 + 2 * (sizeof(T) > 2 ? sizeof(T) : 2);
+  unsigned char masked[2 * maxSize];
+  unsigned int firstSize = ProgramSerialiser<T>::InstructionSizeOf(first);
+  unsigned int secondSize = ProgramSerialiser<T>::InstructionSizeOf(second);
+  std::memcpy(masked, first, firstSize);
+  std::memcpy(masked + firstSize, second, secondSize);
+  masked[1] &= ~1;
+  masked[firstSize + 1] &= ~1;
+  return Hash(masked, firstSize + secondSize);
+}
+
+
+
+template <class T> bool
+VUWLGP::PopulationHistoryWriter<T>::SameInstruction(const unsigned char* first,
+						    const unsigned char* second) {
+  unsigned int size = ProgramSerialiser<T>::InstructionSizeOf(first);
+  return size == ProgramSerialiser<T>::InstructionSizeOf(second) && first[0] == second[0] &&
+    (first[1] & ~1) == (second[1] & ~1) && std::memcmp(first + 2, second + 2, size - 2) == 0;
+}
+
+
+
+template <class T>
+VUWLGP::PopulationHistoryReader<T>::PopulationHistoryReader(const std::string& filePath):
+version(0),
+serialiser(0) {
+  typedef ProgramSerialiser<T> PS;
+
+  FILE* file = std::fopen(filePath.c_str(), "rb");
+  if(file == 0) {
+    throw "PopulationHistoryReader - could not open " + filePath;
+  }
+
+  std::fseek(file, 0, SEEK_END);
+  long fileSize = std::ftell(file);
+  std::fseek(file, 0, SEEK_SET);
+  if(fileSize > 0) {
+    contents.resize(fileSize);
+  }
+  bool read = fileSize > 0 && std::fread(&contents[0], 1, contents.size(), file) ==
+    contents.size();
+  std::fclose(file);
+
+  if(!read || contents.size() < 20 || std::memcmp(&contents[0], "VUWLGPPH", 8) != 0) {
+    throw filePath + " is not a population history";
+  }
+
+  const unsigned char* data = &contents[0];
+  unsigned int offset = 8;
+  version = PS::template Extract<unsigned int>(data, offset);
+  if((version != 1 && version != 2) ||
+     PS::template Extract<unsigned int>(data, offset) != sizeof(T)) {
+    throw filePath + " is from an unsupported version or has a different register type";
+  }
+
+  std::vector<std::string> symbols;
+  std::vector<bool> conditionals;
+  std::vector<bool> unaries;
+  unsigned int numOperations = PS::template Extract<unsigned int>(data, offset);
+  for(unsigned int i = 0; i < numOperations; ++i) {
+    if(offset + 5 > contents.size()) {
+      throw filePath + " has a truncated header";
+    }
+    unsigned char flags = PS::template Extract<unsigned char>(data, offset);
+    conditionals.push_back((flags & 1) != 0);
+    unaries.push_back((flags & 2) != 0);
+    unsigned int length = PS::template Extract<unsigned int>(data, offset);
+    if(offset + length > contents.size()) {
+      throw filePath + " has a truncated header";
+    }
+    symbols.push_back(std::string(data + offset, data + offset + length));
+    offset += length;
+  }
+  serialiser = new ProgramSerialiser<T>(symbols, conditionals, unaries);
+
+  // Index the records; a record cut short by the writer being stopped is ignored:
+  while(offset + 5 <= contents.size()) {
+    Record record;
+    record.keyframe = PS::template Extract<unsigned char>(data, offset) == 'K';
+    unsigned int length = PS::template Extract<unsigned int>(data, offset);
+    if(offset + length + 8 > contents.size()) {
+      break;
+    }
+    record.identifier.assign(data + offset, data + offset + length);
+    offset += length;
+    record.numPrograms = PS::template Extract<unsigned int>(data, offset);
+    unsigned int bodySize = PS::template Extract<unsigned int>(data, offset);
+    if(offset + bodySize > contents.size()) {
+      break;
+    }
+    record.start = offset;
+    record.end = offset + bodySize;
+    offset = record.end;
+
+    if(records.empty() && !record.keyframe) {
+      throw filePath + " doesn't start with a keyframe";
+    }
+    records.push_back(record);
+  }
+}
+
+
+
+template <class T>
+VUWLGP::PopulationHistoryReader<T>::~PopulationHistoryReader() {
+  delete serialiser;
+}
+
+
+
+template <class T>
+unsigned int VUWLGP::PopulationHistoryReader<T>::TypeSize(const std::string& filePath) {
+  unsigned char header[16];
+  FILE* file = std::fopen(filePath.c_str(), "rb");
+  bool read = file != 0 && std::fread(header, 1, sizeof(header), file) == sizeof(header);
+  if(file != 0) {
+    std::fclose(file);
+  }
+
+  if(!read || std::memcmp(header, "VUWLGPPH", 8) != 0) {
+    throw filePath + " is not a population history";
+  }
+
+  unsigned int offset = 12;
+  return ProgramSerialiser<T>::template Extract<unsigned int>(header, offset);
+}
+
+
+
+template <class T>
+std::vector<std::string> VUWLGP::PopulationHistoryReader<T>::Identifiers() const {
+  std::vector<std::string> identifiers;
+  for(unsigned int i = 0; i < records.size(); ++i) {
+    identifiers.push_back(records[i].identifier);
+  }
+  return identifiers;
+}
+
+
+
+template <class T> void
+VUWLGP::PopulationHistoryReader<T>::FormatPopulation(const std::string& identifier,
+						     std::string& out) const {
+  // The latest record with the identifier, in case a resumed run logged it twice:
+  for(unsigned int i = records.size(); i-- > 0; ) {
+    if(records[i].identifier == identifier) {
+      std::vector<std::vector<unsigned char> > programs;
+      Rebuild(i, programs);
+
+      std::vector<const unsigned char*> starts;
+      for(unsigned int p = 0; p < programs.size(); ++p) {
+	starts.push_back(&programs[p][0]);
+      }
+      serialiser->FormatPopulation(starts, out);
+      return;
+    }
+  }
+
+  throw "PopulationHistoryReader - there is no record of " + identifier;
+}
+
+
+
+template <class T> void
+VUWLGP::PopulationHistoryReader<T>::Rebuild(unsigned int record,
+					    std::vector<std::vector<unsigned char> >& programs)
+  const {
+  typedef ProgramSerialiser<T> PS;
+
+  unsigned int first = record;
+  while(!records[first].keyframe) {
+    --first;
+  }
+
+  // Play the deltas forward from the keyframe:
+  std::vector<std::vector<unsigned char> > previous;
+  for(unsigned int r = first; r <= record; ++r) {
+    const unsigned char* data = &contents[0];
+    unsigned int offset = records[r].start;
+    unsigned int end = records[r].end;
+    if(records[r].keyframe) {
+      previous.clear();
+    }
+    programs.clear();
+
+    for(unsigned int i = 0; i < records[r].numPrograms; ++i) {
+      bool kinds = version > 1 || !records[r].keyframe;
+      unsigned char kind = 1;
+      if(kinds && offset < end) {
+	kind = PS::template Extract<unsigned char>(data, offset);
+      }
+
+      std::vector<unsigned char> program;
+      if(kind == 0) {
+	unsigned int source = 0;
+	if(version > 1) {
+	  source = ExtractVariable(data, offset, end);
+	}
+	else if(offset + sizeof(unsigned int) <= end) {
+	  source = PS::template Extract<unsigned int>(data, offset);
+	}
+	const std::vector<unsigned char>& from = Source(previous, programs, source);
+	program.insert(program.end(), from.begin(), from.end());
+      }
+      else if(kind == 1) {
+	unsigned int size = offset < end ? PS::SizeOf(data + offset) : 0;
+	if(size == 0 || offset + size > end) {
+	  throw "PopulationHistoryReader - record " + records[r].identifier + " is corrupt";
+	}
+	program.assign(data + offset, data + offset + size);
+	offset += size;
+      }
+      else if(kind == 2) {
+	ReadPieces(previous, programs, data, offset, end, program);
+      }
+      else {
+	throw "PopulationHistoryReader - record " + records[r].identifier + " is corrupt";
+      }
+
+      programs.push_back(std::vector<unsigned char>());
+      programs.back().swap(program);
+    }
+
+    previous.swap(programs);
+  }
+
+  programs.swap(previous);
+}
+
+
+
+template <class T> void
+VUWLGP::PopulationHistoryReader<T>::ReadPieces(
+  const std::vector<std::vector<unsigned char> >& previous,
+  const std::vector<std::vector<unsigned char> >& current, const unsigned char* data,
+  unsigned int& offset, unsigned int end, std::vector<unsigned char>& program) {
+  typedef ProgramSerialiser<T> PS;
+  if(offset + sizeof(double) + 1 > end) {
+    throw std::string("PopulationHistoryReader - truncated program");
+  }
+
+  program.assign(data + offset, data + offset + sizeof(double) + 1);
+  offset += sizeof(double) + 1;
+  unsigned int length = ExtractVariable(data, offset, end);
+  PS::template Append<unsigned int>(length, program);
+
+  const unsigned char* introns = data + offset;
+  offset += (length + 7) / 8;
+  if(offset > end) {
+    throw std::string("PopulationHistoryReader - truncated program");
+  }
+
+  std::vector<unsigned int> instrs;
+  for(unsigned int i = 0; i < length; ) {
+    unsigned int code = ExtractVariable(data, offset, end);
+    unsigned int count = code / 2;
+    if(count == 0 || count > length - i) {
+      throw std::string("PopulationHistoryReader - bad piece");
+    }
+
+    if(code % 2 == 1) {
+      unsigned int source = ExtractVariable(data, offset, end);
+      unsigned int start = ExtractVariable(data, offset, end);
+      const std::vector<unsigned char>& from = Source(previous, current, source);
+
+      PS::InstructionOffsets(&from[0], instrs);
+      if(start >= instrs.size() || count > instrs.size() - 1 - start) {
+	throw std::string("PopulationHistoryReader - bad piece");
+      }
+      program.insert(program.end(), &from[0] + instrs[start], &from[0] + instrs[start + count]);
+    }
+    else {
+      unsigned int literal = offset;
+      for(unsigned int j = 0; j < count; ++j) {
+	if(offset + 3 > end) {
+	  throw std::string("PopulationHistoryReader - truncated program");
+	}
+	offset += PS::InstructionSizeOf(data + offset);
+      }
+      if(offset > end) {
+	throw std::string("PopulationHistoryReader - truncated program");
+      }
+      program.insert(program.end(), data + literal, data + offset);
+    }
+    i += count;
+  }
+
+  PS::InstructionOffsets(&program[0], instrs);
+  for(unsigned int i = 0; i < length; ++i) {
+    unsigned char& flags = program[instrs[i] + 1];
+    flags = (flags & ~1) | ((introns[i / 8] >> (i % 8)) & 1);
+  }
+}
+
+
+
+template <class T>
+unsigned int VUWLGP::PopulationHistoryReader<T>::ExtractVariable(const unsigned char* data,
+								 unsigned int& offset,
+								 unsigned int end) {
+  unsigned int val = 0;
+  for(unsigned int shift = 0; shift < 35; shift += 7) {
+    if(offset >= end) {
+      break;
+    }
+    unsigned char byte = data[offset++];
+    val |= static_cast<unsigned int>(byte & 0x7f) << shift;
+    if((byte & 0x80) == 0) {
+      return val;
+    }
+  }
+  throw std::string("PopulationHistoryReader - truncated or bad number");
+}
+
+
+
+template <class T> const std::vector<unsigned char>&
+VUWLGP::PopulationHistoryReader<T>::Source(
+  const std::vector<std::vector<unsigned char> >& previous,
+  const std::vector<std::vector<unsigned char> >& current, unsigned int source) {
+  if(source < previous.size()) {
+    return previous[source];
+  }
+  if(source - previous.size() >= current.size()) {
+    throw std::string("PopulationHistoryReader - bad reference");
+  }
+  return current[source - previous.size()];
+}
+#endif
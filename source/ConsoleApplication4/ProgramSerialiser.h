@@ -0,0 +1,579 @@
+
+  
+#ifndef PROGRAMSERIALISER_H
+#define PROGRAMSERIALISER_H
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "Config.h"
+#include "IInstructionArgument.h"
+#include "IInstructionOperation.h"
+#include "IInstructionOperationConditional.h"
+#include "IProgram.h"
+#include "Instruction.h"
+#include "InstructionArgumentConstant.h"
+#include "InstructionArgumentFeature.h"
+#include "InstructionArgumentRegister.h"
+
+namespace VUWLGP {
+  // Converts programs to and from a compact binary form, e.g. so that they can be sent
+  // between processes or written to a checkpoint. Each program is stored as:
+  //
+  //   double fitness, unsigned char fitnessStatus, unsigned int numberOfInstructions
+  //
+  // followed by each of its instructions:
+  //
+  //   unsigned char opcode, unsigned char flags, unsigned char destinationRegister,
+  //   first argument, second argument
+  //
+  // where the flags hold the intron flag (bit 0) and the ArgumentType of the first (bits 1-2)
+  // and second (bits 3-4) arguments, and each argument is a T if it is a constant or an
+  // unsigned short feature/register index otherwise. Opcodes are indexes into
+  // Config::instructionOperations, so the reader and writer must share the same operation
+  // set. Values are stored in the native byte order.
+  template <class T> class ProgramSerialiser {
+  public:
+    ProgramSerialiser(Config<T>* conf);
+    // Default cctor, dtor
+
+    // Builds a serialiser which can only Format programs, from the symbols and conditional
+    // (and unary, if given) flags of the operations the opcodes refer to (e.g. as stored in a
+    // population history file), for when the Config the programs were written with isn't
+    // available.
+    ProgramSerialiser(const std::vector<std::string>& operationSymbols,
+		      const std::vector<bool>& operationConditionals,
+		      const std::vector<bool>& operationUnaries = std::vector<bool>());
+
+    // Appends the serialised form of prog to the end of out.
+    void Write(const IProgram<T>& prog, std::vector<unsigned char>& out) const;
+
+    // Reads the program which starts at data[offset] into a new program of type P, which
+    // must have a constructor like P(unsigned int size, Config<T>* conf). offset is advanced
+    // to the end of the program. The caller is responsible for the memory returned.
+    template <class P>
+      P* Read(const unsigned char* data, unsigned int size, unsigned int& offset) const;
+
+    // Copies prog, whose registers and constants are of another type U, into a new program
+    // of type P (built as Read builds it) with this serialiser's Config, converting its
+    // constants to T - e.g. to evaluate a program evolved in float in double. Operations are
+    // matched by their symbols, so prog's Config must have the same operations as this one.
+    // The copy has prog's fitness, if prog's is up to date. The caller is responsible for the
+    // memory returned.
+    template <class P, class U> P* Convert(const IProgram<U>& prog) const;
+
+    // Appends the text IProgram::ToString(printFitness, commentIntrons) would return for the
+    // program which starts at data[offset] to out, without deserialising it, and advances
+    // offset to the end of the program. Numbers are formatted with snprintf, which gives the
+    // same text as the default ostream formatting but is much faster. data must have been
+    // produced by Write.
+    void Format(const unsigned char* data, unsigned int& offset, bool printFitness,
+		bool commentIntrons, std::string& out) const;
+
+    // Appends the text of a population dump, as IPopulation::LogPopulation writes it, of the
+    // serialised programs in programs (in the order they are to be printed) to out.
+    void FormatPopulation(const std::vector<const unsigned char*>& programs,
+			  std::string& out) const;
+
+    // The fitness, number of instructions and number of bytes of the serialised program at
+    // data.
+    static double FitnessOf(const unsigned char* data);
+    static unsigned int LengthOf(const unsigned char* data);
+    static unsigned int SizeOf(const unsigned char* data);
+
+    // Sets offsets to the offsets of the instructions of the serialised program at data from
+    // its start, followed by its size.
+    static void InstructionOffsets(const unsigned char* data,
+				   std::vector<unsigned int>& offsets);
+
+    // The number of bytes in the serialised instruction at data.
+    static unsigned int InstructionSizeOf(const unsigned char* data);
+
+    // Returns the largest number of bytes a program of length programLength can take up.
+    static unsigned int MaximumSize(unsigned int programLength);
+
+    // The operations the opcodes refer to - their symbols (IInstructionOperation::ToString)
+    // and whether or not they are conditionals or unary, e.g. so a reader can print programs
+    // without deserialising them.
+    unsigned int NumberOfOperations() const { return symbols.size(); }
+    const std::string& OperationSymbol(unsigned int opcode) const { return symbols[opcode]; }
+    bool OperationIsConditional(unsigned int opcode) const { return conditionals[opcode]; }
+    bool OperationIsUnary(unsigned int opcode) const { return unaries[opcode]; }
+
+    // Returns the opcode of op; throws if op is not in Config::instructionOperations.
+    unsigned char Opcode(const IInstructionOperation<T>* op) const;
+
+    // Appends the bytes of val to out, and reads a V from data[offset] (advancing offset),
+    // e.g. for the plain values stored alongside programs in a checkpoint. The caller must
+    // check there are sizeof(V) bytes left to read.
+    template <class V> static void Append(const V& val, std::vector<unsigned char>& out);
+    template <class V> static V Extract(const unsigned char* data, unsigned int& offset);
+
+  private:
+    // Orders type_info pointers so that they can be used as map keys:
+    struct TypeInfoLess {
+      bool operator()(const std::type_info* left, const std::type_info* right) const {
+	return left->before(*right) != 0;
+      }
+    };
+
+    static unsigned int ArgumentSize(unsigned int type) {
+      return type == ArgumentTypeConstant ? sizeof(T) : sizeof(unsigned short);
+    }
+
+    // Appends the text of an argument (as its ToString would return), and of a number as
+    // operator<< would format it.
+    void FormatArgument(unsigned int type, const unsigned char* data, unsigned int& offset,
+			std::string& out) const;
+    static void AppendNumber(double val, std::string& out);
+    static void AppendNumber(float val, std::string& out) { AppendNumber(double(val), out); }
+    static void AppendNumber(unsigned int val, std::string& out);
+    template <class V> static void AppendNumber(const V& val, std::string& out);
+
+    IInstructionArgument<T>* ReadArgument(unsigned int type, const unsigned char* data,
+					  unsigned int& offset) const;
+    void WriteArgument(const IInstructionArgument<T>* arg,
+		       std::vector<unsigned char>& out) const;
+
+    std::map<const std::type_info*, unsigned char, TypeInfoLess> opcodes;
+    std::vector<std::string> symbols;
+    std::vector<bool> conditionals;
+    std::vector<bool> unaries;
+
+    Config<T>* config;
+  };
+}
+
+
+
+////////////////////////////////// INLINE FUNCTION DEFINITIONS /////////////////////////////////
+template <class T>
+VUWLGP::ProgramSerialiser<T>::ProgramSerialiser(VUWLGP::Config<T>* conf):
+config(conf) {
+  // Build one instance of each operation so that it can be recognised when writing and
+  // described to readers:
+  for(unsigned int i = 0; i < config->instructionOperations->NumberOfElements(); ++i) {
+    IInstructionOperation<T>* op = config->instructionOperations->GetElement(i)(config);
+
+    if(opcodes.find(&typeid(*op)) == opcodes.end()) {
+      opcodes[&typeid(*op)] = static_cast<unsigned char>(i);
+    }
+    symbols.push_back(op->ToString());
+    conditionals.push_back(dynamic_cast<IInstructionOperationConditional<T>*>(op) != 0);
+    unaries.push_back(op->IsUnary());
+
+    delete op;
+  }
+}
+
+
+
+template <class T>
+VUWLGP::ProgramSerialiser<T>::ProgramSerialiser(const std::vector<std::string>& operationSymbols,
+						const std::vector<bool>& operationConditionals,
+						const std::vector<bool>& operationUnaries):
+symbols(operationSymbols),
+conditionals(operationConditionals),
+unaries(operationUnaries),
+config(0) {
+  unaries.resize(symbols.size(), false);
+}
+
+
+
+template <class T> void
+VUWLGP::ProgramSerialiser<T>::Write(const VUWLGP::IProgram<T>& prog,
+				   std::vector<unsigned char>& out) const {
+  const std::vector<Instruction<T>*>& instrs = prog.ConstRawAccessToTheInternalInstructions();
+
+  Append<double>(prog.Fitness(), out);
+  Append<unsigned char>(prog.FitnessStatus() ? 1 : 0, out);
+  Append<unsigned int>(instrs.size(), out);
+
+  for(unsigned int i = 0; i < instrs.size(); ++i) {
+    const Instruction<T>* instr = instrs[i];
+    unsigned char flags = (instr->IsIntron ? 1 : 0) |
+      (instr->FirstArgumentType() << 1) | (instr->SecondArgumentType() << 3);
+
+    Append<unsigned char>(Opcode(instr->Operation()), out);
+    Append<unsigned char>(flags, out);
+    Append<unsigned char>(static_cast<unsigned char>(instr->DestinationIndex()), out);
+    WriteArgument(instr->FirstArgument(), out);
+    WriteArgument(instr->SecondArgument(), out);
+  }
+}
+
+
+
+template <class T> template <class P> P*
+VUWLGP::ProgramSerialiser<T>::Read(const unsigned char* data, unsigned int size,
+				   unsigned int& offset) const {
+  if(offset + sizeof(double) + 1 + sizeof(unsigned int) > size) {
+    throw std::string("ProgramSerialiser::Read - truncated program header");
+  }
+
+  double fitness = Extract<double>(data, offset);
+  bool fitnessStatus = Extract<unsigned char>(data, offset) != 0;
+  unsigned int length = Extract<unsigned int>(data, offset);
+
+  P* result = new P(0, config);
+  std::vector<Instruction<T>*>& instrs = result->RawAccessToTheInternalInstructions();
+  instrs.reserve(length);
+
+  for(unsigned int i = 0; i < length; ++i) {
+    if(offset + 3 > size) {
+      delete result;
+      throw std::string("ProgramSerialiser::Read - truncated instruction");
+    }
+
+    unsigned char opcode = Extract<unsigned char>(data, offset);
+    unsigned char flags = Extract<unsigned char>(data, offset);
+    unsigned char dest = Extract<unsigned char>(data, offset);
+
+    if(opcode >= NumberOfOperations()) {
+      delete result;
+      throw std::string("ProgramSerialiser::Read - unknown opcode");
+    }
+
+    // Both argument types are checked before either argument is allocated, so nothing is
+    // left to leak when one is unknown:
+    unsigned int firstType = (flags >> 1) & 3;
+    unsigned int secondType = (flags >> 3) & 3;
+    if(firstType > ArgumentTypeRegister || secondType > ArgumentTypeRegister) {
+      delete result;
+      throw std::string("ProgramSerialiser::Read - unknown argument type");
+    }
+
+    if(offset + ArgumentSize(firstType) + ArgumentSize(secondType) > size) {
+      delete result;
+      throw std::string("ProgramSerialiser::Read - truncated instruction");
+    }
+
+    IInstructionArgument<T>* first = ReadArgument(firstType, data, offset);
+    IInstructionArgument<T>* second = ReadArgument(secondType, data, offset);
+
+    Instruction<T>* instr =
+      new Instruction<T>(config, config->instructionOperations->GetElement(opcode)(config),
+			 new InstructionArgumentRegister<T>(config, dest), first, second);
+    instr->IsIntron = (flags & 1) != 0;
+    instrs.push_back(instr);
+  }
+
+  if(fitnessStatus) {
+    result->SetFitness(fitness);
+  }
+
+  return result;
+}
+
+
+
+template <class T> template <class P, class U> P*
+VUWLGP::ProgramSerialiser<T>::Convert(const VUWLGP::IProgram<U>& prog) const {
+  const std::vector<Instruction<U>*>& from = prog.ConstRawAccessToTheInternalInstructions();
+
+  P* result = new P(0, config);
+  std::vector<Instruction<T>*>& instrs = result->RawAccessToTheInternalInstructions();
+  instrs.reserve(from.size());
+
+  for(unsigned int i = 0; i < from.size(); ++i) {
+    std::string symbol = from[i]->Operation()->ToString();
+    unsigned int opcode = 0;
+    while(opcode < NumberOfOperations() && symbols[opcode] != symbol) {
+      ++opcode;
+    }
+    if(opcode == NumberOfOperations()) {
+      delete result;
+      throw "ProgramSerialiser::Convert - operation " + symbol + " not in the configuration";
+    }
+
+    IInstructionArgument<T>* args[2];
+    const IInstructionArgument<U>* fromArgs[2] = { from[i]->FirstArgument(),
+						   from[i]->SecondArgument() };
+    for(unsigned int j = 0; j < 2; ++j) {
+      if(fromArgs[j]->ArgumentType() == ArgumentTypeConstant) {
+	args[j] = new InstructionArgumentConstant<T>(config, static_cast<T>(
+	  static_cast<const InstructionArgumentConstant<U>*>(fromArgs[j])->Constant()));
+      }
+      else if(fromArgs[j]->ArgumentType() == ArgumentTypeFeature) {
+	args[j] = new InstructionArgumentFeature<T>(config, fromArgs[j]->ArgumentIndex());
+      }
+      else {
+	args[j] = new InstructionArgumentRegister<T>(config, fromArgs[j]->ArgumentIndex());
+      }
+    }
+
+    InstructionArgumentRegister<T>* dest =
+      new InstructionArgumentRegister<T>(config, from[i]->DestinationIndex());
+    Instruction<T>* instr =
+      new Instruction<T>(config, config->instructionOperations->GetElement(opcode)(config),
+			 dest, args[0], args[1]);
+    instr->IsIntron = from[i]->IsIntron;
+    instrs.push_back(instr);
+  }
+
+  if(prog.FitnessStatus()) {
+    result->SetFitness(prog.Fitness());
+  }
+
+  return result;
+}
+
+
+
+template <class T> void
+VUWLGP::ProgramSerialiser<T>::Format(const unsigned char* data, unsigned int& offset,
+				    bool printFitness, bool commentIntrons,
+				    std::string& out) const {
+  double fitness = Extract<double>(data, offset);
+  Extract<unsigned char>(data, offset); // fitness status
+  unsigned int length = Extract<unsigned int>(data, offset);
+
+  if(printFitness) {
+    out += "// Fitness Information: ";
+    AppendNumber(fitness, out);
+    out += "\n";
+  }
+
+  out += "template <class T>\n";
+  out += "void VUWLGP::Program::Execute(std::vector<T>& r, const std::vector<T>& cf) {\n";
+
+  for(unsigned int i = 0; i < length; ++i) {
+    unsigned char opcode = Extract<unsigned char>(data, offset);
+    unsigned char flags = Extract<unsigned char>(data, offset);
+    unsigned char dest = Extract<unsigned char>(data, offset);
+
+    out += "\t";
+    if(commentIntrons && (flags & 1) != 0) {
+      out += "//";
+    }
+
+    if(conditionals[opcode]) {
+      out += "if(";
+      FormatArgument((flags >> 1) & 3, data, offset, out);
+      out += " " + symbols[opcode] + " ";
+      FormatArgument((flags >> 3) & 3, data, offset, out);
+      out += ")";
+    }
+    else if(unaries[opcode]) {
+      // The second argument is skipped over, as the operation ignores it:
+      std::string unused;
+      out += "r[";
+      AppendNumber(static_cast<unsigned int>(dest), out);
+      out += "] = " + symbols[opcode] + "(";
+      FormatArgument((flags >> 1) & 3, data, offset, out);
+      FormatArgument((flags >> 3) & 3, data, offset, unused);
+      out += ");";
+    }
+    else {
+      out += "r[";
+      AppendNumber(static_cast<unsigned int>(dest), out);
+      out += "] = ";
+      FormatArgument((flags >> 1) & 3, data, offset, out);
+      out += " " + symbols[opcode] + " ";
+      FormatArgument((flags >> 3) & 3, data, offset, out);
+      out += ";";
+    }
+    out += "\n";
+  }
+
+  out += "}";
+}
+
+
+
+template <class T> void
+VUWLGP::ProgramSerialiser<T>::FormatPopulation(const std::vector<const unsigned char*>& programs,
+					       std::string& out) const {
+  char line[32];
+  for(unsigned int i = 0; i < programs.size(); ++i) {
+    std::snprintf(line, sizeof(line), "Program %u:\n", i);
+    out += line;
+
+    unsigned int offset = 0;
+    Format(programs[i], offset, true, true, out);
+    out += "\n\n";
+  }
+  out += "\n";
+}
+
+
+
+template <class T>
+double VUWLGP::ProgramSerialiser<T>::FitnessOf(const unsigned char* data) {
+  unsigned int offset = 0;
+  return Extract<double>(data, offset);
+}
+
+
+
+template <class T>
+unsigned int VUWLGP::ProgramSerialiser<T>::LengthOf(const unsigned char* data) {
+  unsigned int offset = sizeof(double) + 1;
+  return Extract<unsigned int>(data, offset);
+}
+
+
+
+template <class T>
+unsigned int VUWLGP::ProgramSerialiser<T>::SizeOf(const unsigned char* data) {
+  unsigned int offset = sizeof(double) + 1 + sizeof(unsigned int);
+  unsigned int length = LengthOf(data);
+
+  for(unsigned int i = 0; i < length; ++i) {
+    offset += InstructionSizeOf(data + offset);
+  }
+
+  return offset;
+}
+
+
+
+template <class T>
+void VUWLGP::ProgramSerialiser<T>::InstructionOffsets(const unsigned char* data,
+						      std::vector<unsigned int>& offsets) {
+  unsigned int offset = sizeof(double) + 1 + sizeof(unsigned int);
+  unsigned int length = LengthOf(data);
+
+  offsets.clear();
+  for(unsigned int i = 0; i < length; ++i) {
+    offsets.push_back(offset);
+    offset += InstructionSizeOf(data + offset);
+  }
+  offsets.push_back(offset);
+}
+
+
+
+template <class T>
+unsigned int VUWLGP::ProgramSerialiser<T>::InstructionSizeOf(const unsigned char* data) {
+  unsigned char flags = data[1];
+  return 3 + ArgumentSize((flags >> 1) & 3) + ArgumentSize((flags >> 3) & 3);
+}
+
+
+
+template <class T>
+unsigned int VUWLGP::ProgramSerialiser<T>::MaximumSize(unsigned int programLength) {
+  unsigned int argumentSize = sizeof(T) > sizeof(unsigned short) ?
+    sizeof(T) : sizeof(unsigned short);
+  return sizeof(double) + 1 + sizeof(unsigned int) + programLength * (3 + 2 * argumentSize);
+}
+
+
+
+template <class T> unsigned char
+VUWLGP::ProgramSerialiser<T>::Opcode(const VUWLGP::IInstructionOperation<T>* op) const {
+  typename std::map<const std::type_info*, unsigned char, TypeInfoLess>::const_iterator it =
+    opcodes.find(&typeid(*op));
+
+  if(it == opcodes.end()) {
+    throw std::string("ProgramSerialiser::Opcode - operation not in the configuration");
+  }
+
+  return it->second;
+}
+
+
+
+template <class T> void
+VUWLGP::ProgramSerialiser<T>::FormatArgument(unsigned int type, const unsigned char* data,
+					     unsigned int& offset, std::string& out) const {
+  switch(type) {
+  case ArgumentTypeConstant:
+    AppendNumber(Extract<T>(data, offset), out);
+    break;
+  case ArgumentTypeFeature:
+    out += "cf[";
+    AppendNumber(static_cast<unsigned int>(Extract<unsigned short>(data, offset)), out);
+    out += "]";
+    break;
+  default:
+    out += "r[";
+    AppendNumber(static_cast<unsigned int>(Extract<unsigned short>(data, offset)), out);
+    out += "]";
+  }
+}
+
+
+
+template <class T>
+void VUWLGP::ProgramSerialiser<T>::AppendNumber(double val, std::string& out) {
+  // %g is what operator<< uses for doubles with the default flags and precision:
+  char buffer[32];
+  int length = std::snprintf(buffer, sizeof(buffer), "%g", val);
+  out.append(buffer, length);
+}
+
+
+
+template <class T>
+void VUWLGP::ProgramSerialiser<T>::AppendNumber(unsigned int val, std::string& out) {
+  char buffer[16];
+  int length = std::snprintf(buffer, sizeof(buffer), "%u", val);
+  out.append(buffer, length);
+}
+
+
+
+template <class T> template <class V>
+void VUWLGP::ProgramSerialiser<T>::AppendNumber(const V& val, std::string& out) {
+  std::ostringstream buffer;
+  buffer << val;
+  out += buffer.str();
+}
+
+
+
+template <class T> VUWLGP::IInstructionArgument<T>*
+VUWLGP::ProgramSerialiser<T>::ReadArgument(unsigned int type, const unsigned char* data,
+					   unsigned int& offset) const {
+  switch(type) {
+  case ArgumentTypeConstant:
+    return new InstructionArgumentConstant<T>(config, Extract<T>(data, offset));
+  case ArgumentTypeFeature:
+    return new InstructionArgumentFeature<T>(config, Extract<unsigned short>(data, offset));
+  case ArgumentTypeRegister:
+    return new InstructionArgumentRegister<T>(config, Extract<unsigned short>(data, offset));
+  default:
+    throw std::string("ProgramSerialiser::ReadArgument - unknown argument type");
+  }
+}
+
+
+
+template <class T> void
+VUWLGP::ProgramSerialiser<T>::WriteArgument(const VUWLGP::IInstructionArgument<T>* arg,
+					    std::vector<unsigned char>& out) const {
+  if(arg->ArgumentType() == ArgumentTypeConstant) {
+    Append<T>(static_cast<const InstructionArgumentConstant<T>*>(arg)->Constant(), out);
+  }
+  else {
+    Append<unsigned short>(static_cast<unsigned short>(arg->ArgumentIndex()), out);
+  }
+}
+
+
+
+template <class T> template <class V> void
+VUWLGP::ProgramSerialiser<T>::Append(const V& val, std::vector<unsigned char>& out) {
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&val);
+  out.insert(out.end(), bytes, bytes + sizeof(V));
+}
+
+
+
+template <class T> template <class V> V
+VUWLGP::ProgramSerialiser<T>::Extract(const unsigned char* data, unsigned int& offset) {
+  // memcpy rather than a cast, as nothing in the stream is aligned:
+  V val;
+  std::memcpy(&val, data + offset, sizeof(V));
+  offset += sizeof(V);
+  return val;
+}
+#endif
@@ -5,39 +5,133 @@
 
 #include "Rand.h"
 
+// Visual C++ 2013 predates thread_local, but has an equivalent for plain data:
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define thread_local __declspec(thread)
+#endif
+
+namespace {
+  // The state of glibc's TYPE_3 random(): x[i] = x[i - 3] + x[i - 31], of which the top 31 bits
+  // are returned. Only the last 31 values are needed to carry on the sequence.
+  struct Generator {
+    unsigned int table[31];
+    unsigned int front; // index of x[i - 3]
+    unsigned int rear;  // index of x[i - 31]
+    bool initialised;
+  };
+
+  thread_local Generator generator = { { 0 }, 0, 0, false };
+
+
+
+  // Seeds the table with the minimal standard LCG (in Schrage's form, as glibc does) and then
+  // discards the first 310 outputs, exactly as srand does.
+  void Seed(Generator& g, unsigned int seed) {
+    int word = static_cast<int>(seed == 0 ? 1 : seed);
+    g.table[0] = static_cast<unsigned int>(word);
+
+    for(unsigned int i = 1; i < 31; ++i) {
+      int hi = word / 127773;
+      int lo = word % 127773;
+      word = 16807 * lo - 2836 * hi;
+      if(word < 0) {
+	word += 2147483647;
+      }
+      g.table[i] = static_cast<unsigned int>(word);
+    }
+
+    g.front = 3;
+    g.rear = 0;
+    g.initialised = true;
+
+    for(unsigned int i = 0; i < 310; ++i) {
+      g.table[g.front] += g.table[g.rear];
+      g.front = (g.front + 1) % 31;
+      g.rear = (g.rear + 1) % 31;
+    }
+  }
+
+
+
+  // Returns the next value in the calling thread's sequence, in the range [0, Rand::Max].
+  unsigned int Next() {
+    Generator& g = generator;
+    if(!g.initialised) {
+      Seed(g, 1);
+    }
+
+    g.table[g.front] += g.table[g.rear];
+    unsigned int result = g.table[g.front] >> 1;
+    g.front = (g.front + 1) % 31;
+    g.rear = (g.rear + 1) % 31;
+    return result;
+  }
+}
+
+
+
 // Initialise the random number generator with a time-dependent seed.
-void VUWLGP::Rand::Init() { srand(time(0)); }
+void VUWLGP::Rand::Init() { Seed(generator, time(0)); }
 
 
 
 // Initialise the random number generated with a specified seed.
-void VUWLGP::Rand::Init(unsigned int seed) { srand(seed); }
+void VUWLGP::Rand::Init(unsigned int seed) { Seed(generator, seed); }
 
 
 
-// Returns a random integer in the range [0, ceiling). ceiling is at most RAND_MAX (~2*10^9)
+// Returns the state of the calling thread's generator.
+VUWLGP::Rand::State VUWLGP::Rand::GetState() {
+  if(!generator.initialised) {
+    Seed(generator, 1);
+  }
+
+  State state;
+  for(unsigned int i = 0; i < 31; ++i) {
+    state.table[i] = generator.table[i];
+  }
+  state.front = generator.front;
+  state.rear = generator.rear;
+  return state;
+}
+
+
+
+// Restores a state returned by GetState to the calling thread's generator.
+void VUWLGP::Rand::SetState(const VUWLGP::Rand::State& state) {
+  for(unsigned int i = 0; i < 31; ++i) {
+    generator.table[i] = state.table[i];
+  }
+  generator.front = state.front % 31;
+  generator.rear = state.rear % 31;
+  generator.initialised = true;
+}
+
+
+
+// Returns a random integer in the range [0, ceiling). ceiling is at most Rand::Max (~2*10^9)
 // Returns 0 if ceiling == 0
 unsigned int VUWLGP::Rand::Int(unsigned int ceiling) {
-  return ceiling != 0 ? rand() % ceiling : 0;
+  return ceiling != 0 ? Next() % ceiling : 0;
 }
 
 
 
-// Returns a random unsigned integer in the range [0, 2 * RAND_MAX].
-// NB: Because rand returns in the range [0, RAND_MAX] , which on this system is the maximum 
-// value of a signed integer, rand() needs to be called twice and the two values added to 
-// exploit the full range of the unsigned int. This makes 0 and the unsigned integer maximum 
-// only half as likely as any one other value in the range.
+// Returns a random unsigned integer in the range [0, 2 * Rand::Max].
+// NB: Because the generator returns in the range [0, Rand::Max], which is the maximum value of
+// a signed integer, it needs to be called twice and the two values added to exploit the full
+// range of the unsigned int. This makes 0 and the unsigned integer maximum only half as likely
+// as any one other value in the range.
 unsigned int VUWLGP::Rand::Int() { 
-  unsigned int r = rand(); 
-  return r + rand(); 
+  unsigned int r = Next(); 
+  return r + Next(); 
 }
 
 
 
 // Returns a float in the range [0, 1).
 float VUWLGP::Rand::Uniform() { 
-  return 1.0 * rand() / (1.0 * RAND_MAX + 1); 
+  return 1.0 * Next() / (1.0 * Rand::Max + 1); 
 }
 
 
@@ -60,6 +154,10 @@ template <> double VUWLGP::Rand::GenerateRandomConstant<double>() {
   return (2.0 * Rand::Uniform()) - 1;
 }
 
+template <> float VUWLGP::Rand::GenerateRandomConstant<float>() {
+  return static_cast<float>((2.0 * Rand::Uniform()) - 1);
+}
+
 template <> unsigned int VUWLGP::Rand::GenerateRandomConstant<unsigned int>() {
   return Rand::Int();
 }
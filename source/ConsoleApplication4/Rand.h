@@ -7,17 +7,36 @@
 #include <ctime>
 
 namespace VUWLGP {
+  // Each thread has its own generator, so concurrent runs (or the worker threads of a run) don't
+  // share state and are reproducible from their seeds. A thread's generator behaves as if
+  // seeded with 1 until Init is called on that thread. The generator is the additive feedback
+  // generator used by glibc's rand(), so a seed gives the same sequence it always has on Linux.
   namespace Rand {
-    // Initialise the random number generator with a time-dependent seed.
+    // The largest value the underlying generator returns.
+    const unsigned int Max = 2147483647u;
+
+    // Initialise the calling thread's random number generator with a time-dependent seed.
     void Init();
     
-    // Initialise the random number generated with a specified seed.
+    // Initialise the calling thread's random number generator with a specified seed.
     void Init(unsigned int seed);
+
+    // The complete state of a generator, e.g. so that it can be saved in a checkpoint and
+    // restored later to carry on with exactly the same sequence.
+    struct State {
+      unsigned int table[31];
+      unsigned int front;
+      unsigned int rear;
+    };
+
+    // Returns the state of, or restores a state to, the calling thread's generator.
+    State GetState();
+    void SetState(const State& state);
     
     // Returns a random integer in the range [0, ceiling).
     unsigned int Int(unsigned int ceiling);
     
-    // Returns a random integer in the range [0, RAND_MAX].
+    // Returns a random integer in the range [0, 2 * Rand::Max].
     unsigned int Int();
     
     // Returns a float in the range [0, 1).
@@ -0,0 +1,1217 @@
+// lgpcheck - checks the parts of the library which promise exact agreement: that every
+// evaluation engine (and kernel level, tile size and number of threads) gives exactly the
+// interpreter's fitnesses, that programs, binary datasets and population histories read back
+// exactly what was written, that a run resumed from a checkpoint carries on exactly as it
+// would have, that pipelined populations, islands and multiple runs each give what a single
+// generational run does, that logs which fall behind stay in order, and that the fast
+// transcendental functions stay within the error bounds Transcendental.h documents. Prints a
+// line for each check, and exits with status 1 if any failed. `make check` builds and runs it.
+//
+// Usage: lgpcheck
+//
+// It writes its scratch files (all starting "lgpcheck.") to the current directory, and
+// removes them when it is done.
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "AsynchronousSteadyStatePopulation.h"
+#include "Config.h"
+#include "Dataset.h"
+#include "FitnessEnvironment.h"
+#include "GenerationalTournamentPopulation.h"
+#include "HalfFloat.h"
+#include "IPopulation.h"
+#include "IslandModel.h"
+#include "KernelDispatch.h"
+#include "LogWriter.h"
+#include "MultiRunDriver.h"
+#include "OpSet.h"
+#include "PipelinedGenerationalPopulation.h"
+#include "PopulationHistory.h"
+#include "ProgramSerialiser.h"
+#include "Rand.h"
+#include "Transcendental.h"
+
+#include "InstructionArgumentConstant.h"
+#include "InstructionArgumentFeature.h"
+#include "InstructionArgumentRegister.h"
+
+#include "InstructionOperationPlus.h"
+#include "InstructionOperationMinus.h"
+#include "InstructionOperationMult.h"
+#include "InstructionOperationDiv.h"
+#include "InstructionOperationIflt.h"
+#include "InstructionOperationExp.h"
+#include "InstructionOperationSin.h"
+#include "InstructionOperationCos.h"
+#include "InstructionOperationSqrt.h"
+#include "InstructionOperationLog.h"
+
+#include "SymRegFitnessCase.h"
+
+#include "SymRegProgram.h"
+
+using namespace VUWLGP;
+
+// Initialise the static members the generational populations (which the history, checkpoints
+// and pipelining are checked with) need, as main does:
+template <> double
+GenerationalTournamentPopulation<SymRegProgram<double>, double>::proportionElitism
+= 0.1;
+template <> unsigned int
+GenerationalTournamentPopulation<SymRegProgram<double>, double>::tournamentSize
+= 2;
+
+// The populations checked against each other:
+typedef GenerationalTournamentPopulation<SymRegProgram<double>, double> Generational;
+typedef PipelinedGenerationalPopulation<SymRegProgram<double>, double> Pipelined;
+
+// The number of checks which have failed so far.
+static unsigned int failures = 0;
+
+// Prints the outcome of the check called name, with detail saying what went wrong if it
+// failed.
+static void Report(const std::string& name, bool passed, const std::string& detail = "") {
+	if (passed) {
+		std::cout << "ok      " << name << std::endl;
+	}
+	else {
+		std::cout << "FAILED  " << name << (detail.empty() ? "" : ": ") << detail << std::endl;
+		++failures;
+	}
+}
+
+// A population which is never bred - each "generation" just flags every program to be
+// evaluated again.
+template <class T> class CheckPopulation : public IPopulation<SymRegProgram<T>, T> {
+public:
+	CheckPopulation(Config<T>* c) : IPopulation<SymRegProgram<T>, T>(c) { }
+
+	void IteratePopulation() {
+		for (unsigned int i = 0; i < this->programs.size(); ++i) {
+			this->programs[i]->FitnessStatusReference() = false;
+		}
+	}
+
+	const SymRegProgram<T>* SelectProgByFitness() const {
+		return static_cast<const SymRegProgram<T>*>(this->programs[0]);
+	}
+
+	std::vector<double> Fitnesses() const {
+		std::vector<double> fitnesses;
+		for (unsigned int i = 0; i < this->programs.size(); ++i) {
+			fitnesses.push_back(this->programs[i]->Fitness());
+		}
+		return fitnesses;
+	}
+};
+
+// Builds a Config for programs of 10 to 40 instructions (and up to 200 once bred) over 6
+// registers and 4 features, made of the basic operations and, if transcendental is set, the
+// transcendental ones, as main does. Caller is responsible for the memory.
+template <class T> static Config<T>* BuildConfig(bool transcendental) {
+	Config<T>* c = new Config<T>();
+	c->numRegisters = 6;
+	c->numFeatures = 4;
+	c->initialMinLength = 10;
+	c->initialMaxLength = 40;
+	c->maxLength = 200;
+	c->epsilon = 0;
+	c->populationSize = 120;
+	c->transcendentalOperations = transcendental;
+
+	c->argumentGenerators->AddElement(InstructionArgumentConstant<T>::Generate);
+	c->argumentGenerators->AddElement(InstructionArgumentFeature<T>::Generate);
+	c->argumentGenerators->AddElement(InstructionArgumentRegister<T>::Generate);
+	if (transcendental) {
+		OpSet<T, InstructionOperationPlus, InstructionOperationMinus, InstructionOperationMult,
+			InstructionOperationDiv, InstructionOperationIflt, InstructionOperationExp,
+			InstructionOperationSin, InstructionOperationCos, InstructionOperationSqrt,
+			InstructionOperationLog>::Register(c);
+	}
+	else {
+		OpSet<T, InstructionOperationPlus, InstructionOperationMinus, InstructionOperationMult,
+			InstructionOperationDiv, InstructionOperationIflt>::Register(c);
+	}
+	return c;
+}
+
+// Adds numCases random cases over [-4, 4] to fe, with a few zero features so that the
+// protected operations' special cases come up.
+template <class T> static void AddCases(FitnessEnvironment<T>* fe, unsigned int numCases,
+	unsigned int numFeatures) {
+	for (unsigned int i = 0; i < numCases; ++i) {
+		std::vector<T> x(numFeatures);
+		for (unsigned int f = 0; f < numFeatures; ++f) {
+			x[f] = i % 17 == f ? 0 : static_cast<T>(Rand::Uniform() * 8 - 4);
+		}
+		fe->AddCase(new SymRegFitnessCase<T>(x, x[0] * x[1] - x[2] + x[3] * x[3]));
+	}
+}
+
+// Returns a description of the first difference between fitnesses and expected, compared bit
+// for bit (as some are NaN), or an empty string if they are the same.
+static std::string Difference(const std::vector<double>& fitnesses,
+	const std::vector<double>& expected) {
+	for (unsigned int i = 0; i < expected.size(); ++i) {
+		if (std::memcmp(&fitnesses[i], &expected[i], sizeof(double)) != 0) {
+			std::ostringstream buffer;
+			buffer.precision(17);
+			buffer << "program " << i << " has fitness " << fitnesses[i] << " rather than "
+				<< expected[i];
+			return buffer.str();
+		}
+	}
+	return "";
+}
+
+// Checks that decoding float16s a block at a time gives exactly what decoding them one at a
+// time does (or a NaN for a NaN) at every kernel level this processor has, for every value.
+template <class T> static void CheckFloat16s(const std::string& name) {
+	std::vector<unsigned short> values(65536 + 3);
+	for (unsigned int i = 0; i < values.size(); ++i) {
+		values[i] = static_cast<unsigned short>(i);
+	}
+
+	KernelLevel selected = KernelDispatch::Selected();
+	for (unsigned int level = KernelsBaseline; level <= KernelsAvx512; ++level) {
+		if (!KernelDispatch::Supports(static_cast<KernelLevel>(level))) {
+			continue;
+		}
+		KernelDispatch::Select(KernelDispatch::Name(static_cast<KernelLevel>(level)));
+
+		// From an odd offset, so the blocks are unaligned and there is a tail:
+		std::vector<T> decoded(values.size() - 1);
+		HalfFloat::DecodeFloat16s(&values[1], decoded.size(), &decoded[0]);
+		std::string difference;
+		for (unsigned int i = 0; i < decoded.size() && difference.empty(); ++i) {
+			T expected = HalfFloat::DecodeFloat16(values[i + 1]);
+			bool same = expected != expected ? decoded[i] != decoded[i] :
+				std::memcmp(&decoded[i], &expected, sizeof(T)) == 0;
+			if (!same) {
+				std::ostringstream buffer;
+				buffer << "float16 " << values[i + 1] << " decoded as " << decoded[i]
+					<< " rather than " << expected;
+				difference = buffer.str();
+			}
+		}
+
+		Report("float16s decoded in blocks into " + name + " with the " +
+			KernelDispatch::Name(static_cast<KernelLevel>(level)) + " kernels",
+			difference.empty(), difference);
+	}
+	KernelDispatch::Select(KernelDispatch::Name(selected));
+}
+
+// Checks that every engine, on its own and with tiles, chunks and threads, gives exactly the
+// fitnesses the interpreter does, for programs in T of the basic or transcendental operations
+// (with the fast approximations if fast is set), against datasets on either side of
+// Config::lockstepMaxCases.
+template <class T> static void CheckEngines(const std::string& name, bool transcendental,
+	bool fast) {
+	Config<T>* c = BuildConfig<T>(transcendental);
+	c->fastTranscendentals = fast;
+	Transcendental<T>::fast = fast;
+	Rand::Init(1);
+	CheckPopulation<T>* pop = new CheckPopulation<T>(c);
+
+	const char* engines[] = { "lockstep", "plan", "compiled", "batch", "auto" };
+	const unsigned int sizes[] = { c->lockstepMaxCases / 2, c->lockstepMaxCases * 3 };
+	for (unsigned int s = 0; s < 2; ++s) {
+		FitnessEnvironment<T>* fe = new FitnessEnvironment<T>(c);
+		AddCases(fe, sizes[s], c->numFeatures);
+
+		c->evaluationEngine = "interpreter";
+		pop->IteratePopulation();
+		pop->EvaluateFlaggedPrograms(*fe);
+		std::vector<double> expected = pop->Fitnesses();
+
+		for (unsigned int e = 0; e < sizeof(engines) / sizeof(engines[0]); ++e) {
+			for (unsigned int blocked = 0; blocked < 2; ++blocked) {
+				c->evaluationEngine = engines[e];
+				c->evaluationTileSize = blocked ? 64 : 0;
+				c->evaluationChunkSize = blocked ? 160 : 0;
+				c->numThreads = blocked ? 3 : 1;
+
+				// Twice, as the plan engine fuses the superinstructions it counted the first
+				// time:
+				std::string difference;
+				for (unsigned int generation = 0; generation < 2 && difference.empty();
+					++generation) {
+					pop->IteratePopulation();
+					pop->EvaluateFlaggedPrograms(*fe);
+					difference = Difference(pop->Fitnesses(), expected);
+				}
+
+				std::ostringstream check;
+				check << name << ", " << engines[e] << " engine, " << sizes[s] << " cases"
+					<< (blocked ? ", tiles, chunks and threads" : "");
+				Report(check.str(), difference.empty(), difference);
+			}
+		}
+
+		// And the batch engine at every kernel level this processor has:
+		KernelLevel selected = KernelDispatch::Selected();
+		for (unsigned int level = KernelsBaseline; level <= KernelsAvx512; ++level) {
+			if (!KernelDispatch::Supports(static_cast<KernelLevel>(level))) {
+				continue;
+			}
+			KernelDispatch::Select(KernelDispatch::Name(static_cast<KernelLevel>(level)));
+			c->evaluationEngine = "batch";
+			c->evaluationTileSize = 0;
+			c->evaluationChunkSize = 0;
+			c->numThreads = 1;
+			pop->IteratePopulation();
+			pop->EvaluateFlaggedPrograms(*fe);
+			std::string difference = Difference(pop->Fitnesses(), expected);
+
+			std::ostringstream check;
+			check << name << ", batch engine with the "
+				<< KernelDispatch::Name(static_cast<KernelLevel>(level)) << " kernels, "
+				<< sizes[s] << " cases";
+			Report(check.str(), difference.empty(), difference);
+		}
+
+		// And again with the features packed as float16s, which the batch engine decodes
+		// a block at a time (with F16C above the baseline):
+		fe->PackFeatures(Float16);
+		c->evaluationEngine = "interpreter";
+		pop->IteratePopulation();
+		pop->EvaluateFlaggedPrograms(*fe);
+		expected = pop->Fitnesses();
+		for (unsigned int level = KernelsBaseline; level <= KernelsAvx512; ++level) {
+			if (!KernelDispatch::Supports(static_cast<KernelLevel>(level))) {
+				continue;
+			}
+			KernelDispatch::Select(KernelDispatch::Name(static_cast<KernelLevel>(level)));
+			c->evaluationEngine = "batch";
+			pop->IteratePopulation();
+			pop->EvaluateFlaggedPrograms(*fe);
+			std::string difference = Difference(pop->Fitnesses(), expected);
+
+			std::ostringstream check;
+			check << name << ", batch engine with the "
+				<< KernelDispatch::Name(static_cast<KernelLevel>(level)) << " kernels, "
+				<< sizes[s] << " cases of float16 features";
+			Report(check.str(), difference.empty(), difference);
+		}
+		KernelDispatch::Select(KernelDispatch::Name(selected));
+
+		delete fe;
+	}
+
+	Transcendental<T>::fast = false;
+	delete pop;
+	delete c;
+}
+
+// Checks that every program of an evaluated population reads back as it was written, and
+// that an unknown argument type is refused.
+static void CheckSerialiser() {
+	Config<double>* c = BuildConfig<double>(true);
+	Rand::Init(2);
+	CheckPopulation<double>* pop = new CheckPopulation<double>(c);
+	FitnessEnvironment<double>* fe = new FitnessEnvironment<double>(c);
+	AddCases(fe, 50, c->numFeatures);
+	pop->IteratePopulation();
+	pop->EvaluateFlaggedPrograms(*fe);
+	ProgramSerialiser<double> serialiser(c);
+
+	std::string difference;
+	std::vector<const SymRegProgram<double>*> programs;
+	pop->GetFittestPrograms(pop->Size(), programs);
+	for (unsigned int i = 0; i < programs.size() && difference.empty(); ++i) {
+		std::vector<unsigned char> data;
+		serialiser.Write(*programs[i], data);
+		unsigned int offset = 0;
+		SymRegProgram<double>* copy = serialiser.Read<SymRegProgram<double> >(&data[0],
+			data.size(), offset);
+		if (copy->ToString(true, true) != programs[i]->ToString(true, true) ||
+			offset != data.size()) {
+			difference = "program " + programs[i]->ToString(true, true) + " read back as " +
+				copy->ToString(true, true);
+		}
+		delete copy;
+	}
+	Report("programs read back as they were written", difference.empty(), difference);
+
+	// The second argument type of the first instruction is set to the unused type 3:
+	std::vector<unsigned char> data;
+	serialiser.Write(*programs[0], data);
+	data[sizeof(double) + 1 + sizeof(unsigned int) + 1] |= 3 << 3;
+	unsigned int offset = 0;
+	bool refused = false;
+	try {
+		delete serialiser.Read<SymRegProgram<double> >(&data[0], data.size(), offset);
+	}
+	catch (const std::string&) {
+		refused = true;
+	}
+	Report("programs with an unknown argument type are refused", refused);
+
+	delete fe;
+	delete pop;
+	delete c;
+}
+
+// Writes text to the file at filePath.
+static void WriteText(const std::string& filePath, const std::string& text) {
+	std::ofstream fout(filePath.c_str(), std::ios::out | std::ios::binary);
+	fout << text;
+}
+
+// Returns the contents of the file at filePath, or an empty string if it can't be read.
+static std::string ReadText(const std::string& filePath) {
+	std::ifstream fin(filePath.c_str(), std::ios::in | std::ios::binary);
+	std::ostringstream buffer;
+	buffer << fin.rdbuf();
+	return buffer.str();
+}
+
+// Returns a description of the first difference between the datasets, or an empty string if
+// they have exactly the same cases.
+template <class T> static std::string Difference(const Dataset<T>& data,
+	const Dataset<T>& expected) {
+	if (data.NumberOfCases() != expected.NumberOfCases() ||
+		data.NumberOfFeatures() != expected.NumberOfFeatures() ||
+		data.DataFormat() != expected.DataFormat()) {
+		return "the numbers of cases or features or the format differ";
+	}
+
+	for (unsigned int f = 0; f < expected.NumberOfFeatures(); ++f) {
+		if (std::memcmp(data.Feature(f), expected.Feature(f),
+			expected.NumberOfCases() * sizeof(T)) != 0) {
+			return "the features differ";
+		}
+	}
+	for (unsigned int i = 0; i < expected.NumberOfCases(); ++i) {
+		bool same = expected.DataFormat() == Dataset<T>::Regression ?
+			data.Target(i) == expected.Target(i) :
+			data.ClassNumber(i) == expected.ClassNumber(i);
+		if (!same) {
+			return "the targets or classes differ";
+		}
+	}
+	return "";
+}
+
+// Evolves a Population against fe from random seed 11 for c's maxGenerations generations, or
+// on from the checkpoint at resumeFrom if it isn't empty, and returns its programs as text.
+// Sets generations to what Evolve returns.
+template <class Population> static std::string EvolveFrom(Config<double>* c,
+	FitnessEnvironment<double>& fe, const std::string& resumeFrom, unsigned int& generations) {
+	Rand::Init(11);
+	Population pop(c);
+	if (!resumeFrom.empty()) {
+		Rand::Init(12); // so that only the checkpoint's state can give the same run
+		pop.LoadCheckpoint(resumeFrom);
+	}
+	generations = pop.Evolve(fe);
+	pop.FlushLogs();
+	return pop.ToString();
+}
+
+// Checks that a run resumed from a checkpoint carries on exactly as the run which saved it
+// would have: 20 generations in one go against 10, checkpointed, and 10 more.
+static void CheckCheckpoint() {
+	Config<double>* c = BuildConfig<double>(false);
+	c->statsLogFilePath = "lgpcheck.log";
+	c->popLogFilePath = "lgpcheck.pop";
+	c->popLogInterval = 100;
+	c->checkpointFilePath = "lgpcheck.checkpoint";
+	Rand::Init(3);
+	FitnessEnvironment<double> fe(c);
+	AddCases(&fe, 50, c->numFeatures);
+
+	unsigned int generations = 0, resumedGenerations = 0;
+	c->maxGenerations = 20;
+	std::string expected = EvolveFrom<Generational>(c, fe, "", generations);
+
+	c->maxGenerations = 10;
+	c->checkpointInterval = 10;
+	EvolveFrom<Generational>(c, fe, "", resumedGenerations);
+	c->maxGenerations = 20;
+	c->checkpointInterval = 0;
+	std::string resumed = "";
+	try {
+		resumed = EvolveFrom<Generational>(c, fe, "lgpcheck.checkpoint.bin",
+			resumedGenerations);
+	}
+	catch (const std::string& e) {
+		resumed = e;
+	}
+	Report("a run resumed from a checkpoint carries on exactly as it would have",
+		resumed == expected && resumedGenerations == generations);
+
+	std::remove("lgpcheck.checkpoint.bin");
+	std::remove("lgpcheck.log.txt");
+	std::remove("lgpcheck.pop.initial.txt");
+	delete c;
+}
+
+// Checks that a PipelinedGenerationalPopulation, with 1 or 4 evaluation threads, gives exactly
+// the results a GenerationalTournamentPopulation does from the same seed.
+static void CheckPipelined() {
+	Config<double>* c = BuildConfig<double>(false);
+	c->statsLogFilePath = "lgpcheck.log";
+	c->popLogFilePath = "lgpcheck.pop";
+	c->popLogInterval = 100;
+	c->maxGenerations = 10;
+	Rand::Init(3);
+	FitnessEnvironment<double> fe(c);
+	AddCases(&fe, 50, c->numFeatures);
+
+	unsigned int generations = 0;
+	std::string expected = EvolveFrom<Generational>(c, fe, "", generations);
+	unsigned int threadCounts[] = { 1, 4 };
+	for (unsigned int i = 0; i < 2; ++i) {
+		c->numThreads = threadCounts[i];
+		unsigned int pipelinedGenerations = 0;
+		std::string pipelined = EvolveFrom<Pipelined>(c, fe, "", pipelinedGenerations);
+		std::ostringstream name;
+		name << "a pipelined population with " << threadCounts[i]
+			<< (threadCounts[i] == 1 ? " thread" : " threads")
+			<< " gives the generational results";
+		Report(name.str(), pipelined == expected && pipelinedGenerations == generations);
+	}
+
+	std::remove("lgpcheck.log.txt");
+	std::remove("lgpcheck.pop.initial.txt");
+	delete c;
+}
+
+// Checks that datasets of T in both formats, saved in the binary format, open with exactly
+// the cases and splits they were saved with, and that binary datasets of the wrong format or
+// type are refused.
+template <class T> static void CheckDataset(const std::string& name) {
+	const std::string text[2] = { "lgpcheck.regression.txt", "lgpcheck.patterns.txt" };
+	const std::string binary[2] = { "lgpcheck.regression.bin", "lgpcheck.patterns.bin" };
+
+	// A column header, and a mix of integers, fractions, tiny and huge values, written with
+	// every digit so the text is the values exactly:
+	std::ostringstream regression;
+	std::ostringstream patterns;
+	regression.precision(17);
+	patterns.precision(17);
+	regression << "a,b,c,y\n";
+	Rand::Init(3);
+	for (unsigned int i = 0; i < 1000; ++i) {
+		double x[3] = { double(i % 7), Rand::Uniform() * 2 - 1, (Rand::Uniform() - 0.5) *
+			std::pow(10.0, double(i % 40) - 20) };
+		regression << x[0] << "," << x[1] << "," << x[2] << "," << x[0] - x[1] * x[2] << "\n";
+		patterns << "image" << i % 3 << " " << i % 20 << " " << i / 20 << " " << i % 4
+			<< " class" << i % 4 << " " << x[0] << " " << x[1] << " " << x[2] << "\n";
+	}
+	WriteText(text[0], regression.str());
+	WriteText(text[1], patterns.str());
+
+	std::vector<typename Dataset<T>::Split> splits(2);
+	splits[0].name = "train";
+	splits[0].begin = 0;
+	splits[0].end = 700;
+	splits[1].name = "test";
+	splits[1].begin = 700;
+	splits[1].end = 1000;
+
+	const typename Dataset<T>::Format formats[2] = { Dataset<T>::Regression,
+		Dataset<T>::Patterns };
+	const char* formatNames[2] = { "regression", "patterns" };
+	for (unsigned int f = 0; f < 2; ++f) {
+		std::string difference;
+		try {
+			Dataset<T> parsed(text[f], formats[f], 2);
+			parsed.Save(binary[f], splits);
+			Dataset<T> mapped(binary[f], formats[f], 1);
+			difference = Difference(mapped, parsed);
+
+			for (unsigned int i = 0; i < splits.size() && difference.empty(); ++i) {
+				const typename Dataset<T>::Split* split = mapped.FindSplit(splits[i].name);
+				if (split == 0 || split->begin != splits[i].begin ||
+					split->end != splits[i].end) {
+					difference = "split " + splits[i].name + " wasn't kept";
+				}
+			}
+		}
+		catch (const std::string& e) {
+			difference = e;
+		}
+		Report(name + " " + formatNames[f] + " datasets round trip through the binary format",
+			difference.empty(), difference);
+
+		bool refused = false;
+		try {
+			Dataset<T> mapped(binary[f], formats[1 - f], 1);
+		}
+		catch (const std::string&) {
+			refused = true;
+		}
+		Report(name + " binary " + formatNames[f] + " datasets are refused as " +
+			formatNames[1 - f], refused);
+	}
+
+	bool refused = false;
+	try {
+		if (sizeof(T) == sizeof(double)) {
+			Dataset<float> mapped(binary[0], Dataset<float>::Regression, 1);
+		}
+		else {
+			Dataset<double> mapped(binary[0], Dataset<double>::Regression, 1);
+		}
+	}
+	catch (const std::string&) {
+		refused = true;
+	}
+	Report(name + " binary datasets are refused as another type", refused);
+
+	for (unsigned int f = 0; f < 2; ++f) {
+		std::remove(text[f].c_str());
+		std::remove(binary[f].c_str());
+	}
+}
+
+// Checks that a population history rebuilds every population dump of an evolving population
+// exactly as it was written as text, through several keyframes, and that a history can't be
+// appended to with another set of operations.
+static void CheckHistory() {
+	Config<double>* c = BuildConfig<double>(false);
+	c->populationSize = 200;
+	c->maxGenerations = 12;
+	c->statsLogFilePath = "lgpcheck.log";
+	c->popLogFilePath = "lgpcheck.pop";
+	c->popLogFormat = "both";
+	c->popLogInterval = 1;
+	c->historyKeyframeInterval = 5;
+	c->dropLogsWhenBehind = false;
+	const std::string historyPath = c->popLogFilePath + ".history.bin";
+	std::remove(historyPath.c_str());
+	std::remove((c->statsLogFilePath + ".txt").c_str());
+
+	Rand::Init(4);
+	FitnessEnvironment<double>* fe = new FitnessEnvironment<double>(c);
+	AddCases(fe, 100, c->numFeatures);
+	IPopulation<SymRegProgram<double>, double>* pop =
+		new GenerationalTournamentPopulation<SymRegProgram<double>, double>(c);
+	pop->Evolve(*fe);
+	pop->FlushLogs();
+
+	std::string difference;
+	std::vector<std::string> identifiers;
+	try {
+		PopulationHistoryReader<double> reader(historyPath);
+		identifiers = reader.Identifiers();
+		for (unsigned int i = 0; i < identifiers.size() && difference.empty(); ++i) {
+			std::string rebuilt;
+			reader.FormatPopulation(identifiers[i], rebuilt);
+			if (rebuilt != ReadText(c->popLogFilePath + "." + identifiers[i] + ".txt")) {
+				difference = "generation " + identifiers[i] + " was rebuilt differently";
+			}
+		}
+		if (identifiers.size() < 2 && difference.empty()) {
+			difference = "too few generations were recorded";
+		}
+	}
+	catch (const std::string& e) {
+		difference = e;
+	}
+	Report("population histories rebuild every dump", difference.empty(), difference);
+
+	bool refused = false;
+	Config<double>* other = BuildConfig<double>(true);
+	try {
+		ProgramSerialiser<double> serialiser(other);
+		PopulationHistoryWriter<double> writer(historyPath, serialiser, 5);
+	}
+	catch (const std::string&) {
+		refused = true;
+	}
+	Report("population histories refuse to be appended to with other operations", refused);
+
+	delete other;
+	delete pop;
+	delete fe;
+	for (unsigned int i = 0; i < identifiers.size(); ++i) {
+		std::remove((c->popLogFilePath + "." + identifiers[i] + ".txt").c_str());
+	}
+	std::remove(historyPath.c_str());
+	std::remove((c->statsLogFilePath + ".txt").c_str());
+	delete c;
+}
+
+// Returns the identifiers of the entries in the statistics log text, in order, and sets
+// lastLogged to whether the last is a full entry rather than a note that it was dropped.
+static std::vector<std::string> LogEntries(const std::string& text, bool& lastLogged) {
+	const std::string rule = "############################## ";
+	std::vector<std::string> identifiers;
+	std::istringstream lines(text);
+	std::string line;
+	while (std::getline(lines, line)) {
+		if (line.compare(0, rule.size(), rule) == 0) {
+			identifiers.push_back(line.substr(rule.size(), line.find(' ', rule.size()) -
+				rule.size()));
+			lastLogged = std::getline(lines, line) && line.find("not logged") ==
+				std::string::npos;
+		}
+	}
+	return identifiers;
+}
+
+// Checks that a population logged faster than the LogWriter can write (a large population
+// dumped every generation through a queue of two) keeps its statistics log in generation
+// order, with the dropped generations noted in their places, and that its last log - of
+// the final generation, or of the one a solution is found in if solution is set - is kept.
+static void CheckLogOrder(bool solution) {
+	Config<double>* c = BuildConfig<double>(false);
+	c->populationSize = 3000;
+	c->maxGenerations = solution ? 100 : 30;
+	c->statsLogFilePath = "lgpcheck.log";
+	c->popLogFilePath = "lgpcheck.pop";
+	c->popLogInterval = 1;
+	c->logQueueLength = 2;
+	std::remove((c->statsLogFilePath + ".txt").c_str());
+
+	Rand::Init(6);
+	CheckPopulation<double>* pop = new CheckPopulation<double>(c);
+	FitnessEnvironment<double>* fe = new FitnessEnvironment<double>(c);
+	AddCases(fe, 20, c->numFeatures);
+	pop->EvaluateFlaggedPrograms(*fe);
+
+	std::vector<std::string> expected;
+	for (unsigned int gen = 1; gen <= 30; ++gen) {
+		if (solution && gen == 30) {
+			c->epsilon = DBL_MAX; // so every program is a solution
+		}
+		std::ostringstream conv;
+		conv << gen;
+		expected.push_back(conv.str());
+		pop->Log(gen);
+	}
+	unsigned int dropped = pop->FlushLogs();
+
+	bool lastLogged = false;
+	std::vector<std::string> identifiers =
+		LogEntries(ReadText(c->statsLogFilePath + ".txt"), lastLogged);
+	std::ostringstream detail;
+	if (identifiers != expected) {
+		detail << "the generations were logged in the order";
+		for (unsigned int i = 0; i < identifiers.size(); ++i) {
+			detail << " " << identifiers[i];
+		}
+	}
+	else if (!lastLogged) {
+		detail << "the last generation was dropped";
+	}
+
+	std::ostringstream check;
+	check << "logs stay in order with " << dropped << " of 30 dropped, and the "
+		<< (solution ? "solution's" : "final generation's") << " is kept";
+	Report(check.str(), detail.str().empty(), detail.str());
+
+	delete fe;
+	delete pop;
+	for (unsigned int i = 0; i < expected.size(); ++i) {
+		std::remove((c->popLogFilePath + "." + expected[i] + ".txt").c_str());
+	}
+	std::remove((c->statsLogFilePath + ".txt").c_str());
+	delete c;
+}
+
+// Returns the error a LogWriter reports from Flush after being handed one program to log,
+// with its statistics log at statsFilePath and its population dump at popFilePath.
+static std::string LogError(const std::string& statsFilePath, const std::string& popFilePath) {
+	Config<double>* c = BuildConfig<double>(false);
+	Rand::Init(7);
+	SymRegProgram<double> prog(20, c);
+	prog.SetFitness(1);
+
+	std::string error;
+	{
+		LogWriter<double> writer(c);
+		LogWriter<double>::Snapshot snapshot;
+		snapshot.identifier = "1";
+		snapshot.statsFilePath = statsFilePath;
+		snapshot.popFilePath = popFilePath;
+		snapshot.offsets.push_back(0);
+		snapshot.sortedOrder.push_back(0);
+		writer.Serialiser().Write(prog, snapshot.programs);
+		writer.Submit(snapshot, true);
+		try {
+			writer.Flush();
+		}
+		catch (const std::string& e) {
+			error = e;
+		}
+	}
+	delete c;
+	return error;
+}
+
+// Evolves a population for a generation with metrics appended to lgpcheck.metrics.csv, a
+// link to /dev/full, and returns what Evolve throws.
+static std::string MetricsError() {
+	Config<double>* c = BuildConfig<double>(false);
+	c->maxGenerations = 1;
+	c->statsLogFilePath = "lgpcheck.log";
+	c->popLogFilePath = "lgpcheck.pop";
+	c->popLogInterval = 100;
+	c->metricsFormat = "csv";
+	c->metricsFilePath = "lgpcheck.metrics";
+	std::remove("lgpcheck.metrics.csv");
+	symlink("/dev/full", "lgpcheck.metrics.csv");
+
+	std::string error;
+	Rand::Init(7);
+	FitnessEnvironment<double> fe(c);
+	AddCases(&fe, 50, c->numFeatures);
+	GenerationalTournamentPopulation<SymRegProgram<double>, double> pop(c);
+	try {
+		pop.Evolve(fe);
+	}
+	catch (const std::string& e) {
+		error = e;
+	}
+
+	std::remove("lgpcheck.metrics.csv");
+	std::remove("lgpcheck.log.txt");
+	std::remove("lgpcheck.pop.initial.txt");
+	delete c;
+	return error;
+}
+
+// Checks that the LogWriter reports statistics logs and population dumps it can't write in
+// full, and the population metrics records, using /dev/full as a full disk (if there is one).
+static void CheckLogErrors() {
+	FILE* full = std::fopen("/dev/full", "wb");
+	if (full == 0) {
+		Report("log writing errors are reported (skipped, as there is no /dev/full)", true);
+		return;
+	}
+	std::fclose(full);
+
+	Report("log writing errors are reported for statistics logs",
+		!LogError("/dev/full", "").empty());
+	Report("log writing errors are reported for population dumps",
+		!LogError("lgpcheck.log.txt", "/dev/full").empty());
+	std::remove("lgpcheck.log.txt");
+	std::string error = MetricsError();
+	Report("metrics writing errors are reported", error.find("AppendMetrics") !=
+		std::string::npos, error);
+}
+
+// Evolves an AsynchronousSteadyStatePopulation with numThreads threads for 5 equivalent
+// generations from random seed seed, and returns its programs as text. Sets correct to
+// whether every program's fitness is the one it is given when evaluated again. Throws what
+// Evolve throws.
+static std::string EvolveAsynchronously(Config<double>* c, unsigned int numThreads,
+	unsigned int seed, bool& correct) {
+	c->numThreads = numThreads;
+	c->maxGenerations = 5;
+	c->statsLogFilePath = "lgpcheck.log";
+	c->popLogFilePath = "lgpcheck.pop";
+	c->popLogInterval = 100;
+
+	Rand::Init(seed);
+	FitnessEnvironment<double> fe(c);
+	AddCases(&fe, 50, c->numFeatures);
+	AsynchronousSteadyStatePopulation<SymRegProgram<double>, double> pop(c);
+	pop.Evolve(fe);
+
+	std::vector<const SymRegProgram<double>*> programs;
+	pop.GetFittestPrograms(pop.Size(), programs);
+	correct = true;
+	for (unsigned int i = 0; i < programs.size(); ++i) {
+		SymRegProgram<double> copy(*programs[i]);
+		copy.UpdateFitness(fe);
+		double fitness = programs[i]->Fitness();
+		double evaluated = copy.Fitness();
+		correct = correct && std::memcmp(&fitness, &evaluated, sizeof(double)) == 0;
+	}
+	return pop.ToString();
+}
+
+// Checks that the asynchronous population is repeatable with one thread, that with several
+// every program ends up with its own fitness, and that a worker thread's error (here, a
+// checkpoint which can't be written) is thrown from Evolve rather than ending the process.
+static void CheckAsynchronous() {
+	Config<double>* c = BuildConfig<double>(false);
+	c->populationSize = 200;
+
+	bool correct = false;
+	bool repeatCorrect = false;
+	std::string first = EvolveAsynchronously(c, 1, 8, correct);
+	std::string repeat = EvolveAsynchronously(c, 1, 8, repeatCorrect);
+	Report("asynchronous populations evolve repeatably with one thread",
+		first == repeat && correct && repeatCorrect);
+
+	EvolveAsynchronously(c, 4, 8, correct);
+	Report("asynchronous populations keep every program's fitness with four threads",
+		correct);
+
+	std::string error;
+	c->checkpointInterval = 2;
+	c->checkpointFilePath = "lgpcheck.missing/checkpoint";
+	try {
+		EvolveAsynchronously(c, 4, 8, correct);
+	}
+	catch (const std::string& e) {
+		error = e;
+	}
+	Report("asynchronous populations throw their worker threads' errors from Evolve",
+		error.find("SaveCheckpoint") != std::string::npos, error);
+
+	std::remove("lgpcheck.log.txt");
+	std::remove("lgpcheck.pop.initial.txt");
+	delete c;
+}
+
+// Generators for MultiRunDriver and IslandModel: a GenerationalTournamentPopulation, and 50
+// random cases (or, if failEnvironments is set, a std::exception, as from an allocation which
+// fails).
+static bool failEnvironments = false;
+static IPopulation<SymRegProgram<double>, double>* BuildPopulation(Config<double>* c) {
+	return new GenerationalTournamentPopulation<SymRegProgram<double>, double>(c);
+}
+static FitnessEnvironment<double>* BuildEnvironment(Config<double>* c) {
+	if (failEnvironments) {
+		throw std::runtime_error("deliberate failure");
+	}
+	FitnessEnvironment<double>* fe = new FitnessEnvironment<double>(c);
+	AddCases(fe, 50, c->numFeatures);
+	return fe;
+}
+
+// Returns the lines of the file at filePath, each split into its comma separated fields.
+static std::vector<std::vector<std::string> > ReadCsv(const std::string& filePath) {
+	std::vector<std::vector<std::string> > rows;
+	std::istringstream lines(ReadText(filePath));
+	std::string line;
+	while (std::getline(lines, line)) {
+		rows.push_back(std::vector<std::string>());
+		std::istringstream fields(line);
+		std::string field;
+		while (std::getline(fields, field, ',')) {
+			rows.back().push_back(field);
+		}
+	}
+	return rows;
+}
+
+// Checks that MultiRunDriver appends a single run's 4 column line to the results file for
+// each run, and the labelled lines and summary to the summary file, that each run gives
+// what a single run with its seed does, and that a run which throws (anything) is reported
+// rather than ending the process.
+static void CheckMultiRun() {
+	Config<double>* c = BuildConfig<double>(false);
+	c->populationSize = 100;
+	c->maxGenerations = 5;
+	c->numRuns = 3;
+	c->numConcurrentRuns = 2;
+	c->randSeed = 9;
+	c->seedSpecified = true;
+	c->statsLogFilePath = "lgpcheck.log";
+	c->popLogFilePath = "lgpcheck.pop";
+	c->popLogInterval = 100;
+	c->runLogFilePath = "lgpcheck.results.csv";
+	c->runSummaryFilePath = "lgpcheck.runs.csv";
+	std::remove(c->runLogFilePath.c_str());
+	std::remove(c->runSummaryFilePath.c_str());
+
+	MultiRunDriver<SymRegProgram<double>, double> driver(c, BuildPopulation, BuildEnvironment,
+		BuildEnvironment);
+	driver.Run();
+
+	std::vector<std::vector<std::string> > results = ReadCsv(c->runLogFilePath);
+	std::vector<std::vector<std::string> > summary = ReadCsv(c->runSummaryFilePath);
+	bool laidOut = results.size() == c->numRuns && summary.size() == c->numRuns + 3;
+	for (unsigned int i = 0; i < results.size() && laidOut; ++i) {
+		laidOut = results[i].size() == 4;
+	}
+	for (unsigned int i = 0; i < summary.size() && laidOut; ++i) {
+		const char* labels[] = { "mean", "sd", "median" };
+		std::ostringstream label;
+		if (i < c->numRuns) {
+			label << "run";
+		}
+		label << (i < c->numRuns ? std::string() : labels[i - c->numRuns]);
+		laidOut = summary[i].size() == 5 && summary[i][0].find(label.str()) == 0;
+	}
+	Report("multiple runs write 4 column results and a labelled summary", laidOut);
+
+	// Each run against a single run with its seed, built and evolved as main does:
+	bool same = true;
+	for (unsigned int run = 0; run < c->numRuns; ++run) {
+		Rand::Init(c->randSeed + run);
+		IPopulation<SymRegProgram<double>, double>* pop = BuildPopulation(c);
+		FitnessEnvironment<double>* train = BuildEnvironment(c);
+		FitnessEnvironment<double>* test = BuildEnvironment(c);
+		unsigned int generations = std::min(pop->Evolve(*train), c->maxGenerations);
+		double fitness = pop->GetFittestProgram()->Fitness();
+		same = same && generations == driver.Result(run).generations &&
+			std::memcmp(&fitness, &driver.Result(run).trainingFitness, sizeof(double)) == 0;
+		delete pop;
+		delete test;
+		delete train;
+	}
+	Report("each of multiple runs gives what a single run with its seed does", same);
+
+	std::string error;
+	failEnvironments = true;
+	try {
+		driver.Run();
+	}
+	catch (const std::string& e) {
+		error = e;
+	}
+	failEnvironments = false;
+	Report("multiple runs report runs which throw", error.find("did not finish") !=
+		std::string::npos, error);
+
+	for (unsigned int run = 0; run < c->numRuns; ++run) {
+		std::ostringstream suffix;
+		suffix << ".run" << run;
+		std::remove((c->statsLogFilePath + suffix.str() + ".txt").c_str());
+		std::remove((c->popLogFilePath + suffix.str() + ".initial.txt").c_str());
+	}
+	std::remove((c->statsLogFilePath + ".txt").c_str());
+	std::remove((c->popLogFilePath + ".initial.txt").c_str());
+	std::remove(c->runLogFilePath.c_str());
+	std::remove(c->runSummaryFilePath.c_str());
+	delete c;
+}
+
+// Checks that a single island gives what a single run with its seed does, that islands
+// which migrate programs all finish with their own logs and the best of them is logged, and
+// that an island which throws is reported rather than taking the coordinating process with it.
+static void CheckIslands() {
+	Config<double>* c = BuildConfig<double>(false);
+	c->populationSize = 100;
+	c->maxGenerations = 6;
+	c->randSeed = 5;
+	c->seedSpecified = true;
+	c->statsLogFilePath = "lgpcheck.log";
+	c->popLogFilePath = "lgpcheck.pop";
+	c->popLogInterval = 100;
+	c->runLogFilePath = "lgpcheck.results.csv";
+	std::remove(c->runLogFilePath.c_str());
+
+	// An island builds its environments before its population:
+	Rand::Init(c->randSeed);
+	FitnessEnvironment<double>* train = BuildEnvironment(c);
+	FitnessEnvironment<double>* test = BuildEnvironment(c);
+	IPopulation<SymRegProgram<double>, double>* pop = BuildPopulation(c);
+	unsigned int generations = pop->Evolve(*train);
+	pop->FlushLogs();
+	double fitness = pop->GetFittestProgram()->Fitness();
+	delete pop;
+	delete test;
+	delete train;
+
+	std::string error;
+	{
+		IslandModel<SymRegProgram<double>, double> islands(c, BuildPopulation, BuildEnvironment,
+			BuildEnvironment);
+		try {
+			islands.Evolve();
+		}
+		catch (const std::string& e) {
+			error = e;
+		}
+		Report("a single island gives what a single run with its seed does", error.empty() &&
+			islands.Result(0).generations == generations &&
+			std::memcmp(&fitness, &islands.Result(0).trainingFitness, sizeof(double)) == 0,
+			error);
+	}
+
+	c->numIslands = 3;
+	c->migrationInterval = 2;
+	c->migrationSize = 5;
+	{
+		IslandModel<SymRegProgram<double>, double> islands(c, BuildPopulation, BuildEnvironment,
+			BuildEnvironment);
+		try {
+			islands.Evolve();
+			islands.LogResults();
+		}
+		catch (const std::string& e) {
+			error = e;
+		}
+		bool logged = error.empty();
+		for (unsigned int i = 0; i < c->numIslands && logged; ++i) {
+			std::ostringstream suffix;
+			suffix << ".island" << i;
+			logged = islands.Result(i).finished &&
+				!ReadText(c->statsLogFilePath + suffix.str() + ".txt").empty();
+		}
+		std::vector<std::vector<std::string> > results = ReadCsv(c->runLogFilePath);
+		std::ostringstream best;
+		best << islands.Result(islands.BestIsland()).trainingFitness;
+		logged = logged && results.size() == 1 && results[0].size() == 4 &&
+			results[0][2] == best.str();
+		Report("migrating islands all finish, and the best is logged", logged, error);
+	}
+
+	error = "";
+	failEnvironments = true;
+	{
+		IslandModel<SymRegProgram<double>, double> islands(c, BuildPopulation, BuildEnvironment,
+			BuildEnvironment);
+		try {
+			islands.Evolve();
+		}
+		catch (const std::string& e) {
+			error = e;
+		}
+	}
+	failEnvironments = false;
+	Report("islands which throw are reported", error.find("did not finish") !=
+		std::string::npos, error);
+
+	for (unsigned int i = 0; i < c->numIslands; ++i) {
+		std::ostringstream suffix;
+		suffix << ".island" << i;
+		std::remove((c->statsLogFilePath + suffix.str() + ".txt").c_str());
+		std::remove((c->popLogFilePath + suffix.str() + ".initial.txt").c_str());
+	}
+	std::remove((c->statsLogFilePath + ".txt").c_str());
+	std::remove((c->popLogFilePath + ".initial.txt").c_str());
+	std::remove(c->runLogFilePath.c_str());
+	delete c;
+}
+
+// Returns the largest error of fast against exact over numSamples random x from sample, each
+// error divided by scale(x, exact(x)) - e.g. |exact(x)| for a relative error.
+template <class T> static double LargestError(T (*fast)(T), double (*exact)(double),
+	double (*sample)(), double (*scale)(double, double), unsigned int numSamples) {
+	double largest = 0;
+	for (unsigned int i = 0; i < numSamples; ++i) {
+		T x = static_cast<T>(sample());
+		double expected = exact(x);
+		double error = std::fabs(double(fast(x)) - expected) / scale(x, expected);
+		largest = error > largest || error != error ? error : largest;
+	}
+	return largest;
+}
+
+// Returns a random double in the range [0, 1), with all its bits random (as Rand::Uniform's
+// float has only 24).
+static double Uniform() {
+	return Rand::Uniform() + std::ldexp(double(Rand::Uniform()), -24);
+}
+
+// The ranges the functions are checked over, and the scales of their errors:
+static double ExpArgument() { return Uniform() * 1400 - 700; }
+static double FloatExpArgument() { return Rand::Uniform() * 170 - 85; }
+static double LogArgument() {
+	return (1 + Uniform()) * std::ldexp(1.0, static_cast<int>(Rand::Int(2000)) - 1000);
+}
+static double FloatLogArgument() {
+	return (1 + Rand::Uniform()) * std::ldexp(1.0, static_cast<int>(Rand::Int(250)) - 125);
+}
+static double SmallAngle() { return (Uniform() * 2 - 1) * std::ldexp(1.0, 20); }
+static double LargeAngle() {
+	return (Uniform() * 2 - 1) * std::ldexp(1.0, 20 + static_cast<int>(Rand::Int(30)));
+}
+static double FloatAngle() { return (Rand::Uniform() * 2 - 1) * std::ldexp(1.0, 20); }
+static double Absolute(double, double) { return 1; }
+static double Relative(double, double expected) {
+	return expected < DBL_MIN ? 1 : std::fabs(expected);
+}
+static double FloatRelative(double, double expected) {
+	return expected < FLT_MIN ? 1 : std::fabs(expected);
+}
+static double Proportional(double x, double) { return std::fabs(x); }
+static double FloatAngleScale(double x, double) { return 1e-6 + std::fabs(x) * 1e-7; }
+static double Exp(double x) { return std::exp(x); }
+static double Log(double x) { return std::log(x); }
+static double Sin(double x) { return std::sin(x); }
+static double Cos(double x) { return std::cos(x); }
+
+// Checks the error of one fast function against its documented bound.
+static void CheckBound(const std::string& name, double error, double bound) {
+	std::ostringstream detail;
+	detail << "error " << error << ", bound " << bound;
+	Report(name + " is within its error bound", error <= bound, detail.str());
+}
+
+// Checks the fast transcendental functions against the bounds Transcendental.h documents.
+static void CheckTranscendentals() {
+	const unsigned int n = 1000000;
+	Rand::Init(5);
+	CheckBound("FastExp in double", LargestError<double>(Transcendental<double>::FastExp, Exp,
+		ExpArgument, Relative, n), 1e-14);
+	CheckBound("FastLog in double", LargestError<double>(Transcendental<double>::FastLog, Log,
+		LogArgument, Absolute, n), 2e-13);
+	CheckBound("FastSin in double for |x| < 2^20", LargestError<double>(
+		Transcendental<double>::FastSin, Sin, SmallAngle, Absolute, n), 1e-13);
+	CheckBound("FastCos in double for |x| < 2^20", LargestError<double>(
+		Transcendental<double>::FastCos, Cos, SmallAngle, Absolute, n), 1e-13);
+	CheckBound("FastSin in double for 2^20 <= |x| < 2^50", LargestError<double>(
+		Transcendental<double>::FastSin, Sin, LargeAngle, Proportional, n), 2e-16);
+	CheckBound("FastCos in double for 2^20 <= |x| < 2^50", LargestError<double>(
+		Transcendental<double>::FastCos, Cos, LargeAngle, Proportional, n), 2e-16);
+
+	CheckBound("FastExp in float", LargestError<float>(Transcendental<float>::FastExp, Exp,
+		FloatExpArgument, FloatRelative, n), 1e-5);
+	CheckBound("FastLog in float", LargestError<float>(Transcendental<float>::FastLog, Log,
+		FloatLogArgument, Absolute, n), 1e-5);
+	CheckBound("FastSin in float", LargestError<float>(Transcendental<float>::FastSin, Sin,
+		FloatAngle, FloatAngleScale, n), 1);
+	CheckBound("FastCos in float", LargestError<float>(Transcendental<float>::FastCos, Cos,
+		FloatAngle, FloatAngleScale, n), 1);
+}
+
+int main(int argc, char** argv) {
+	if (argc != 1) {
+		std::cerr << "Usage: " << argv[0] << std::endl;
+		return 1;
+	}
+
+	try {
+		// The evaluation engines (plans, compiled, batch, lockstep and the kernel levels):
+		CheckEngines<double>("double", false, false);
+		CheckEngines<double>("double transcendental", true, false);
+		CheckEngines<double>("double fast transcendental", true, true);
+		CheckEngines<float>("float", false, false);
+		CheckEngines<float>("float fast transcendental", true, true);
+		CheckFloat16s<float>("float");
+		CheckFloat16s<double>("double");
+
+		// The binary formats - programs, checkpoints, datasets and population histories:
+		CheckSerialiser();
+		CheckCheckpoint();
+		CheckDataset<double>("double");
+		CheckDataset<float>("float");
+		CheckHistory();
+
+		// The background log writer:
+		CheckLogOrder(false);
+		CheckLogOrder(true);
+		CheckLogErrors();
+
+		// The parallel populations and runs:
+		CheckPipelined();
+		CheckAsynchronous();
+		CheckMultiRun();
+		CheckIslands();
+
+		// The fast transcendental functions:
+		CheckTranscendentals();
+	}
+	catch (const std::string& e) {
+		Report("the checks ran", false, e);
+	}
+
+	std::cout << (failures == 0 ? "All checks passed." : "Some checks failed.") << std::endl;
+	return failures == 0 ? 0 : 1;
+}
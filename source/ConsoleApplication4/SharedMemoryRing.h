@@ -0,0 +1,193 @@
+
+  
+#ifndef SHAREDMEMORYRING_H
+#define SHAREDMEMORYRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace VUWLGP {
+  // A block of POSIX shared memory. The name of the underlying shared memory object is
+  // unlinked as soon as it has been mapped, so the memory is only reachable through this
+  // mapping and the mappings processes fork()ed after it was created inherit, and it is freed
+  // when the last of them exits. Throws a std::string if the memory can't be created.
+  class SharedMemorySegment {
+  public:
+    SharedMemorySegment(size_t size);
+    ~SharedMemorySegment();
+
+    void* Address() const { return address; }
+    size_t Size() const { return size; }
+
+  private:
+    SharedMemorySegment(const SharedMemorySegment& rhs); // not copyable
+    SharedMemorySegment& operator=(const SharedMemorySegment& rhs);
+
+    void* address;
+    size_t size;
+  };
+
+
+
+  // A single-producer, single-consumer queue of messages of up to slotSize bytes, stored in
+  // a ring of numSlots fixed size slots in memory that can be shared between processes (e.g.
+  // part of a SharedMemorySegment). The ring does not own the memory it uses. Push and Pop
+  // never block: a message which doesn't fit is refused rather than waited for.
+  class SharedMemoryRing {
+  public:
+    // Uses the RequiredBytes(numSlots, slotSize) bytes at memory, which should be aligned to
+    // at least 64 bytes. Exactly one process should pass initialise = true, before any
+    // other process uses the ring.
+    SharedMemoryRing(void* memory, unsigned int numSlots, unsigned int slotSize,
+		     bool initialise);
+
+    // Returns the number of bytes of memory a ring with these dimensions needs, rounded up
+    // to a multiple of 64 so that rings can be placed one after another.
+    static size_t RequiredBytes(unsigned int numSlots, unsigned int slotSize);
+
+    // Copies the size bytes at data into the ring. Returns false (and copies nothing) if
+    // the ring is full or the message is larger than a slot.
+    bool Push(const unsigned char* data, unsigned int size);
+
+    // Moves the oldest message in the ring into out. Returns false if the ring is empty.
+    bool Pop(std::vector<unsigned char>& out);
+
+  private:
+    // head and tail count the messages ever popped and pushed; they are kept on separate
+    // cache lines as they are written by different processes.
+    struct Header {
+      std::atomic<unsigned int> head;
+      char padding[64 - sizeof(std::atomic<unsigned int>)];
+      std::atomic<unsigned int> tail;
+    };
+
+    unsigned char* Slot(unsigned int count) const {
+      return slots + (count % numSlots) * (sizeof(unsigned int) + slotSize);
+    }
+
+    Header* header;
+    unsigned char* slots;
+    unsigned int numSlots;
+    unsigned int slotSize;
+  };
+}
+
+
+
+////////////////////////////////// INLINE FUNCTION DEFINITIONS /////////////////////////////////
+inline VUWLGP::SharedMemorySegment::SharedMemorySegment(size_t s):
+address(0),
+size(s) {
+#ifndef _WIN32
+  static unsigned int segmentsCreated = 0;
+  std::ostringstream name;
+  name << "/vuwlgp." << getpid() << "." << segmentsCreated++;
+
+  int fd = shm_open(name.str().c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+  if(fd < 0) {
+    throw std::string("SharedMemorySegment - could not create ") + name.str();
+  }
+
+  if(ftruncate(fd, size) != 0) {
+    close(fd);
+    shm_unlink(name.str().c_str());
+    throw std::string("SharedMemorySegment - could not size ") + name.str();
+  }
+
+  void* mapped = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  shm_unlink(name.str().c_str());
+
+  if(mapped == MAP_FAILED) {
+    throw std::string("SharedMemorySegment - could not map ") + name.str();
+  }
+
+  address = mapped;
+  std::memset(address, 0, size);
+#else
+  throw std::string("SharedMemorySegment - POSIX shared memory is not available");
+#endif
+}
+
+
+
+inline VUWLGP::SharedMemorySegment::~SharedMemorySegment() {
+#ifndef _WIN32
+  if(address != 0) {
+    munmap(address, size);
+  }
+#endif
+}
+
+
+
+inline VUWLGP::SharedMemoryRing::SharedMemoryRing(void* memory, unsigned int slotCount,
+						  unsigned int bytesPerSlot, bool initialise):
+header(static_cast<Header*>(memory)),
+slots(static_cast<unsigned char*>(memory) + sizeof(Header)),
+numSlots(slotCount),
+slotSize(bytesPerSlot) {
+  if(initialise) {
+    new (header) Header();
+    header->head.store(0);
+    header->tail.store(0);
+  }
+}
+
+
+
+inline size_t VUWLGP::SharedMemoryRing::RequiredBytes(unsigned int slotCount,
+						      unsigned int bytesPerSlot) {
+  size_t bytes = sizeof(Header) + slotCount * (sizeof(unsigned int) + bytesPerSlot);
+  return (bytes + 63) / 64 * 64;
+}
+
+
+
+inline bool VUWLGP::SharedMemoryRing::Push(const unsigned char* data, unsigned int size) {
+  unsigned int tail = header->tail.load(std::memory_order_relaxed);
+
+  if(size > slotSize || tail - header->head.load(std::memory_order_acquire) >= numSlots) {
+    return false;
+  }
+
+  unsigned char* slot = Slot(tail);
+  std::memcpy(slot, &size, sizeof(unsigned int));
+  std::memcpy(slot + sizeof(unsigned int), data, size);
+
+  // Publish the message only once it has been completely written:
+  header->tail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+
+
+inline bool VUWLGP::SharedMemoryRing::Pop(std::vector<unsigned char>& out) {
+  unsigned int head = header->head.load(std::memory_order_relaxed);
+
+  if(head == header->tail.load(std::memory_order_acquire)) {
+    return false;
+  }
+
+  const unsigned char* slot = Slot(head);
+  unsigned int size;
+  std::memcpy(&size, slot, sizeof(unsigned int));
+  out.assign(slot + sizeof(unsigned int), slot + sizeof(unsigned int) + size);
+
+  // Only let the producer reuse the slot once it has been copied out:
+  header->head.store(head + 1, std::memory_order_release);
+  return true;
+}
+#endif
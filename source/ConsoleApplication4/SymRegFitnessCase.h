@@ -24,6 +24,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <sstream>
 #include <string>
 
+#include "Dataset.h"
 #include "IFitnessCase.h"
 
 namespace VUWLGP {
@@ -32,13 +33,23 @@ namespace VUWLGP {
     // Initialise a SymRegFitnessCase from a pattern file string (see docs for format)
     SymRegFitnessCase(double xVal, double yVal);
 
+    // Initialise a SymRegFitnessCase with several features (x values).
+    SymRegFitnessCase(const std::vector<T>& xVals, double yVal);
+
     // Return the 0-base class number of the class this case represents.
     double Y() const { return y; }
 
     // Returns a new SymRegFitnessCase. Caller should manage the memory (which
     // FitnessEnvironment will do if it is just passed to FitnessEnvironment<T>::AddCase).
-    // GENERATE-FROM-STRING IS NOT IMPLEMENTED FOR THIS KIND OF FITNESS CASE
-    //static IFitnessCase<T>* Generate(const std::string& patternFileLine);
+    // The line holds the features followed by y, in the Regression format Dataset reads.
+    // Throws a std::string if it can't be parsed.
+    static IFitnessCase<T>* Generate(const std::string& patternFileLine);
+
+    // Returns a new SymRegFitnessCase for case i of data, for FitnessEnvironment::AddCases.
+    static IFitnessCase<T>* Generate(const Dataset<T>& data, unsigned int i);
+
+    // Takes y from case i of data.
+    void View(const Dataset<T>& data, unsigned int i) { y = data.Target(i); }
 
   protected:
     // To make it non-abstract this method from IFitnessCase is instantiated
@@ -55,6 +66,50 @@ namespace VUWLGP {
 template <class T> 
 VUWLGP::SymRegFitnessCase<T>::SymRegFitnessCase(double xVal, double yVal):
 y(yVal) {
-  features.push_back(xVal);
+  this->features.push_back(xVal);
+}
+
+
+
+template <class T> 
+VUWLGP::SymRegFitnessCase<T>::SymRegFitnessCase(const std::vector<T>& xVals, double yVal):
+y(yVal) {
+  this->features = xVals;
+}
+
+
+
+template <class T>
+VUWLGP::IFitnessCase<T>* VUWLGP::SymRegFitnessCase<T>::Generate(const std::string& line) {
+  const char* end = line.data() + line.size();
+  const char* pos = Dataset<T>::SkipSeparators(line.data(), end);
+
+  std::vector<double> values;
+  double value;
+  while(pos != end) {
+    if(!Dataset<T>::ParseNumber(pos, end, value)) {
+      throw "SymRegFitnessCase::Generate - could not parse \"" + line + "\"";
+    }
+    values.push_back(value);
+    pos = Dataset<T>::SkipSeparators(pos, end);
+  }
+
+  if(values.size() < 2) {
+    throw "SymRegFitnessCase::Generate - \"" + line + "\" should be the features and y";
+  }
+
+  return new SymRegFitnessCase<T>(std::vector<T>(values.begin(), values.end() - 1),
+				  values.back());
+}
+
+
+
+template <class T> VUWLGP::IFitnessCase<T>*
+VUWLGP::SymRegFitnessCase<T>::Generate(const VUWLGP::Dataset<T>& data, unsigned int i) {
+  std::vector<T> xVals(data.NumberOfFeatures());
+  for(unsigned int f = 0; f < xVals.size(); ++f) {
+    xVals[f] = data.F(f, i);
+  }
+  return new SymRegFitnessCase<T>(xVals, data.Target(i));
 }
 #endif
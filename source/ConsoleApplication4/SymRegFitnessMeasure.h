@@ -39,7 +39,7 @@ VUWLGP::SymRegFitnessMeasure<T>::UpdateError(const VUWLGP::RegisterCollection<T>
   const SymRegFitnessCase<T>* mcfc;
   if( (mcfc = dynamic_cast<const SymRegFitnessCase<T>*>(fc)) != 0) {
     // then its a valid FC for sym reg
-    fitness += (fRV.Read(0) - mcfc->Y()) * (fRV.Read(0) - mcfc->Y());
+    this->fitness += (fRV.Read(0) - mcfc->Y()) * (fRV.Read(0) - mcfc->Y());
   }
   else { // wrong type of fitness measure for sym reg
     throw std::string("Error: tried to pass a non-sym reg fitness case to UpdateError");
@@ -51,7 +51,7 @@ VUWLGP::SymRegFitnessMeasure<T>::UpdateError(const VUWLGP::RegisterCollection<T>
 template <class T>
 std::string VUWLGP::SymRegFitnessMeasure<T>::ToString() const {
   std::ostringstream buffer;
-  buffer << OverallFitness();
+  buffer << this->OverallFitness();
   return buffer.str();
 }
 #endif
@@ -38,6 +38,9 @@ namespace VUWLGP {
 
     static Instruction<T>* InstructionFactory(Config<T>* c) { return new Instruction<T>(c); }
 
+    // Inherited from IProgram - the fitness measure only reads r[0]
+    unsigned int NumberOfOutputs() const { return 1; }
+
   protected:
     // To make it non-abstract this method from IProgram is instantiated
     void MakeAbstract() const { }
@@ -49,13 +52,13 @@ namespace VUWLGP {
 ////////////////////////////////// INLINE FUNCTION DEFINITIONS /////////////////////////////////
 template <class T> 
 VUWLGP::SymRegProgram<T>::SymRegProgram(unsigned int programSize, VUWLGP::Config<T>* conf):
-IProgram<T>(conf, new SymRegFitnessMeasure<double>(conf)){ 
+IProgram<T>(conf, new SymRegFitnessMeasure<T>(conf)){ 
   // Construct all the instructions, they will be delete'd in the IProgram dtor, as will the
   // FitnessMeasure passed to its ctor.
-  instructions.reserve(programSize);
+  this->instructions.reserve(programSize);
 
   for(unsigned int i = 0; i < programSize; ++i) {
-     instructions.push_back(InstructionFactory(config));
+     this->instructions.push_back(InstructionFactory(this->config));
   }
 }
 
@@ -67,7 +70,7 @@ IProgram<T>(rhs) {
   // Copy the fitness measure, using its defaultly defined cctor
   VUWLGP::SymRegFitnessMeasure<T>* temp = 
     dynamic_cast<VUWLGP::SymRegFitnessMeasure<T>*>(rhs.fitnessMeasure);
-  fitnessMeasure = new VUWLGP::SymRegFitnessMeasure<T>(*temp);
+  this->fitnessMeasure = new VUWLGP::SymRegFitnessMeasure<T>(*temp);
 }
 #endif
 
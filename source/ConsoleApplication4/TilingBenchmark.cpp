@@ -0,0 +1,184 @@
+// lgptilebench - compares evaluating a population program by program (each program streams
+// every case through the cache) with cache-blocked evaluation (see
+// IPopulation::EvaluateInChunks), on random symbolic regression datasets which grow from well
+// inside the L1/L2 caches to well past the L3 cache.
+//
+// Usage: lgptilebench [<max cases>] [<Config parameter>:<value> ...]
+//
+// e.g. lgptilebench 1048576 populationSize:64 evaluationTileSize:512 evaluationProgramBatch:8.
+// The tile size defaults to 1024 cases. For each dataset size it prints the time per case
+// evaluated both ways and roughly how much case data each way reads per generation - the
+// per-program order reads the whole dataset once per program, so once it no longer fits in the
+// cache all of that comes from memory, while the tiled order reads it once per generation.
+// featureStorage:float16 or featureStorage:bfloat16 evaluates against packed copies of the
+// features (see FitnessEnvironment::PackFeatures), to compare with full precision ones.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Config.h"
+#include "FitnessEnvironment.h"
+#include "HalfFloat.h"
+#include "IPopulation.h"
+#include "Rand.h"
+
+#include "InstructionArgumentConstant.h"
+#include "InstructionArgumentFeature.h"
+#include "InstructionArgumentRegister.h"
+
+#include "InstructionOperationPlus.h"
+#include "InstructionOperationMinus.h"
+#include "InstructionOperationMult.h"
+#include "InstructionOperationDiv.h"
+#include "InstructionOperationIflt.h"
+
+#include "SymRegFitnessCase.h"
+
+#include "SymRegProgram.h"
+
+using namespace VUWLGP;
+
+// A population which is never bred - each "generation" just flags every program to be
+// evaluated again.
+class BenchmarkPopulation : public IPopulation<SymRegProgram<double>, double> {
+public:
+	BenchmarkPopulation(Config<double>* c) : IPopulation<SymRegProgram<double>, double>(c) { }
+
+	void IteratePopulation() {
+		for (unsigned int i = 0; i < programs.size(); ++i) {
+			programs[i]->FitnessStatusReference() = false;
+		}
+	}
+
+	const SymRegProgram<double>* SelectProgByFitness() const {
+		return static_cast<const SymRegProgram<double>*>(programs[0]);
+	}
+
+	std::vector<double> Fitnesses() const {
+		std::vector<double> fitnesses;
+		for (unsigned int i = 0; i < programs.size(); ++i) {
+			fitnesses.push_back(programs[i]->Fitness());
+		}
+		return fitnesses;
+	}
+};
+
+// Returns the mean number of seconds pop takes to evaluate a generation against fe, timing
+// generations for at least half a second.
+static double SecondsPerGeneration(BenchmarkPopulation& pop, FitnessEnvironment<double>& fe) {
+	pop.IteratePopulation();
+	pop.EvaluateFlaggedPrograms(fe); // warms the cache up as far as it can be
+
+	unsigned int generations = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	double seconds = 0;
+	while (seconds < 0.5) {
+		pop.IteratePopulation();
+		pop.EvaluateFlaggedPrograms(fe);
+		++generations;
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+			.count();
+	}
+	return seconds / generations;
+}
+
+int main(int argc, char** argv) {
+	unsigned int maxCases = 1 << 20;
+	int first = 1;
+	if (argc > 1 && std::string(argv[1]).find(':') == std::string::npos) {
+		maxCases = std::strtoul(argv[1], 0, 10);
+		first = 2;
+	}
+
+	// The Config parses every argument after the first it is given:
+	std::vector<char*> args(1, argv[0]);
+	args.insert(args.end(), argv + first, argv + argc);
+	Config<double>* c = new Config<double>(args.size(), &args[0], false);
+
+	bool populationSizeGiven = false;
+	for (unsigned int i = 1; i < args.size(); ++i) {
+		populationSizeGiven = populationSizeGiven ||
+			std::string(args[i]).find("populationSize:") == 0;
+	}
+
+	const unsigned int numFeatures = 8;
+	c->numRegisters = 6;
+	c->numFeatures = numFeatures;
+
+	c->argumentGenerators->AddElement(InstructionArgumentConstant<double>::Generate);
+	c->argumentGenerators->AddElement(InstructionArgumentFeature<double>::Generate);
+	c->argumentGenerators->AddElement(InstructionArgumentRegister<double>::Generate);
+
+	c->instructionOperations->AddElement(InstructionOperationPlus<double>::Generate);
+	c->instructionOperations->AddElement(InstructionOperationMinus<double>::Generate);
+	c->instructionOperations->AddElement(InstructionOperationMult<double>::Generate);
+	c->instructionOperations->AddElement(InstructionOperationDiv<double>::Generate);
+	c->instructionOperations->AddElement(InstructionOperationIflt<double>::Generate);
+
+	c->initialMinLength = 10;
+	c->initialMaxLength = 40;
+	if (!populationSizeGiven) {
+		c->populationSize = 64;
+	}
+	unsigned int tileSize = c->evaluationTileSize != 0 ? c->evaluationTileSize : 1024;
+	FeatureStorage storage = HalfFloat::StorageNamed(c->featureStorage);
+
+	Rand::Init(c->seedSpecified ? c->randSeed : 1);
+	BenchmarkPopulation* pop = new BenchmarkPopulation(c);
+	FitnessEnvironment<double>* fe = new FitnessEnvironment<double>(c);
+
+	// Roughly the bytes of one case: the case object, its features (or their packed copies)
+	// and the allocator's header:
+	const double caseBytes = sizeof(SymRegFitnessCase<double>) + numFeatures *
+		(storage == FullPrecision ? sizeof(double) : sizeof(unsigned short)) + 16;
+
+	std::cout << pop->Size() << " programs, " << c->NumberOfThreads() << " threads, tiles of "
+		<< tileSize << " cases, batches of " << c->evaluationProgramBatch << " programs, "
+		<< c->featureStorage << " features" << std::endl << std::endl;
+	std::cout << "     cases   data MB   per-program ns   tiled ns   speedup"
+		<< "   MB read per generation (per-program / tiled)" << std::endl;
+
+	for (unsigned int numCases = 1024; numCases <= maxCases; numCases *= 4) {
+		while (fe->NumberOfCases() < numCases) {
+			std::vector<double> x(numFeatures);
+			for (unsigned int i = 0; i < numFeatures; ++i) {
+				x[i] = Rand::Uniform() * 8 - 4;
+			}
+			fe->AddCase(new SymRegFitnessCase<double>(x, x[0] * x[1] - x[2] + x[3] * x[3]));
+		}
+		fe->PackFeatures(storage);
+
+		c->evaluationChunkSize = 0;
+		c->evaluationTileSize = 0;
+		double perProgram = SecondsPerGeneration(*pop, *fe);
+		std::vector<double> fitnesses = pop->Fitnesses();
+
+		c->evaluationTileSize = tileSize;
+		double tiled = SecondsPerGeneration(*pop, *fe);
+		// Compared bit for bit, as some programs' fitnesses are NaN:
+		std::vector<double> tiledFitnesses = pop->Fitnesses();
+		if (std::memcmp(&tiledFitnesses[0], &fitnesses[0], fitnesses.size() * sizeof(double))) {
+			std::cerr << "The tiled fitnesses differ from the per-program ones" << std::endl;
+			return 1;
+		}
+
+		double evaluations = static_cast<double>(numCases) * pop->Size();
+		double dataMB = numCases * caseBytes / 1e6;
+		std::cout << std::setw(10) << numCases << std::fixed << std::setprecision(1)
+			<< std::setw(10) << dataMB << std::setw(17) << perProgram / evaluations * 1e9
+			<< std::setw(11) << tiled / evaluations * 1e9 << std::setprecision(2)
+			<< std::setw(10) << perProgram / tiled << std::setprecision(1) << std::setw(16)
+			<< dataMB * pop->Size() << " / " << dataMB << std::endl;
+	}
+
+	delete pop;
+	delete fe;
+	delete c;
+	return 0;
+}
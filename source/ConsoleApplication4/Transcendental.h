@@ -0,0 +1,287 @@
+
+  
+#ifndef TRANSCENDENTAL_H
+#define TRANSCENDENTAL_H
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace VUWLGP {
+  // The functions the transcendental operations compute (see InstructionOperationExp, Sin,
+  // Cos, Sqrt and Log). They are the standard library's unless fast is set, when exp, log,
+  // sin and cos are polynomial approximations which have no branches or calls, so compilers
+  // vectorise the operations' batch loops with them (see IInstructionOperation::ComputeBatch)
+  // as they can't with the library's. Their errors in double are below:
+  //   FastExp - 1e-14 relative, except that results below the smallest normal number are 0
+  //   FastLog - 2e-13 absolute
+  //   FastSin and FastCos - 1e-13 absolute for |x| < 2^20, and 2e-16 * |x| (the rounding of
+  //   the reduction by pi/2) up to 2^50 (beyond that they stay finite, but mean little)
+  // In float, exp and log are within 1e-5 and sin and cos within 1e-6 + |x| * 1e-7. Only
+  // float and double are supported.
+  template <class T> class Transcendental {
+  public:
+    // Whether the approximations are used. It must be set before any program is evaluated
+    // (e.g. from Config::fastTranscendentals), so every evaluation engine computes the same.
+    static bool fast;
+
+    static T Exp(T x) { return fast ? FastExp(x) : std::exp(x); }
+    static T Sin(T x) { return fast ? FastSin(x) : std::sin(x); }
+    static T Cos(T x) { return fast ? FastCos(x) : std::cos(x); }
+
+    // The protected square root and logarithm, of |x| (and 0 for the logarithm of 0). The
+    // square root is the standard library's either way, which is exact.
+    static T Sqrt(T x) { return std::sqrt(std::fabs(x)); }
+    static T Log(T x) {
+      return x == 0 ? 0 : fast ? FastLog(std::fabs(x)) : std::log(std::fabs(x));
+    }
+
+    static T FastExp(T x);
+    static T FastLog(T x); // x must not be negative
+    static T FastSin(T x);
+    static T FastCos(T x);
+
+  private:
+    // Returns 2^n, for n in the range of the exponents of normal numbers.
+    static T Pow2(int n);
+
+    // Returns the mantissa of x, which must be positive, normal and finite, scaled to [1, 2),
+    // and sets exponent to x's.
+    static T Mantissa(T x, int& exponent);
+
+    // Returns x rounded to the nearest integer, for |x| < 2^(digits - 2), and sets low to
+    // its two lowest bits.
+    static T Round(T x, unsigned int& low);
+
+    // Reduces x to x - k * pi/2, in [-pi/4, pi/4], and sets quadrant to k mod 4.
+    static T Reduce(T x, unsigned int& quadrant);
+
+    // sin and cos of r in [-pi/4, pi/4].
+    static T SinOfReduced(T r);
+    static T CosOfReduced(T r);
+  };
+}
+
+
+
+////////////////////////////////// Inline Function Definitions /////////////////////////////////
+template <class T> bool VUWLGP::Transcendental<T>::fast = false;
+
+
+
+template <class T>
+T VUWLGP::Transcendental<T>::FastExp(T x) {
+  // exp(x) = 2^k * exp(r), for r = x - k * ln 2 in [-ln 2 / 2, ln 2 / 2], with ln 2 split in
+  // two so k * ln2High is exact:
+  const T ln2High = 6.93147180369123816490e-01;
+  const T ln2Low = 1.90821492927058770002e-10;
+  const T log2e = 1.44269504088896340736;
+  const T high = std::numeric_limits<T>::max_exponent * T(0.693147180559945309417);
+  const T low = (std::numeric_limits<T>::min_exponent - 1) * T(0.693147180559945309417);
+
+  T clamped = x > low ? x : low;
+  clamped = clamped < high ? clamped : high;
+  unsigned int bits;
+  T k = Round(clamped * log2e, bits);
+  T r = clamped - k * ln2High - k * ln2Low;
+
+  T p = T(1) / 39916800;
+  p = p * r + T(1) / 3628800;
+  p = p * r + T(1) / 362880;
+  p = p * r + T(1) / 40320;
+  p = p * r + T(1) / 5040;
+  p = p * r + T(1) / 720;
+  p = p * r + T(1) / 120;
+  p = p * r + T(1) / 24;
+  p = p * r + T(1) / 6;
+  p = p * r + T(1) / 2;
+  p = p * r + 1;
+  p = p * r + 1;
+
+  // 2^k is made in two halves, as 2^k itself can be just out of range:
+  int n = static_cast<int>(k);
+  T result = p * Pow2(n >> 1) * Pow2(n - (n >> 1));
+  result = x < low ? 0 : result;
+  result = x > high ? std::numeric_limits<T>::infinity() : result;
+  return x != x ? x : result;
+}
+
+
+
+template <class T>
+T VUWLGP::Transcendental<T>::FastLog(T x) {
+  // log(x) = e * ln 2 + log(m), for m in [sqrt(1/2), sqrt(2)), whose logarithm is
+  // 2 * atanh(f) for f = (m - 1) / (m + 1). Subnormal numbers are scaled up first:
+  const T ln2High = 6.93147180369123816490e-01;
+  const T ln2Low = 1.90821492927058770002e-10;
+  const int scaling = std::numeric_limits<T>::digits + 1;
+
+  bool subnormal = x < std::numeric_limits<T>::min();
+  int bits;
+  T m = Mantissa(subnormal ? x * Pow2(scaling) : x, bits);
+  // The exponent is carried as a T, as compilers don't vectorise the int arithmetic mixed in:
+  T exponent = bits - (subnormal ? scaling : 0);
+  bool large = m > T(1.41421356237309504880);
+  m = large ? m * T(0.5) : m;
+  exponent += large ? 1 : 0;
+
+  T f = (m - 1) / (m + 1);
+  T s = f * f;
+  T p = T(1) / 15;
+  p = p * s + T(1) / 13;
+  p = p * s + T(1) / 11;
+  p = p * s + T(1) / 9;
+  p = p * s + T(1) / 7;
+  p = p * s + T(1) / 5;
+  p = p * s + T(1) / 3;
+  p = p * s + 1;
+
+  T result = exponent * ln2High + (exponent * ln2Low + 2 * f * p);
+  result = x == 0 ? -std::numeric_limits<T>::infinity() : result;
+  result = x == std::numeric_limits<T>::infinity() ? x : result;
+  return x != x ? x : result;
+}
+
+
+
+template <class T>
+T VUWLGP::Transcendental<T>::FastSin(T x) {
+  unsigned int quadrant;
+  T r = Reduce(x, quadrant);
+  T s = SinOfReduced(r);
+  T c = CosOfReduced(r);
+  T result = quadrant & 1 ? c : s;
+  result = quadrant & 2 ? -result : result;
+  return result + (x - x); // NaN for infinities and NaNs
+}
+
+
+
+template <class T>
+T VUWLGP::Transcendental<T>::FastCos(T x) {
+  unsigned int quadrant;
+  T r = Reduce(x, quadrant);
+  T s = SinOfReduced(r);
+  T c = CosOfReduced(r);
+  T result = quadrant & 1 ? s : c;
+  result = (quadrant + 1) & 2 ? -result : result;
+  return result + (x - x);
+}
+
+
+
+template <class T>
+T VUWLGP::Transcendental<T>::Reduce(T x, unsigned int& quadrant) {
+  // pi/2 is split in two so k * halfPiHigh is exact for |k| < 2^20:
+  const T halfPiHigh = 1.57079632673412561417e+00;
+  const T halfPiLow = 6.07710050650619224932e-11;
+  const T twoOverPi = 6.36619772367581382433e-01;
+  const T limit = Pow2(std::numeric_limits<T>::digits - 3);
+
+  // Beyond the limit x is clamped, so the result stays finite:
+  T clamped = x > -limit * halfPiHigh ? x : -limit * halfPiHigh;
+  clamped = clamped < limit * halfPiHigh ? clamped : limit * halfPiHigh;
+  T k = Round(clamped * twoOverPi, quadrant);
+  return (clamped - k * halfPiHigh) - k * halfPiLow;
+}
+
+
+
+template <class T>
+T VUWLGP::Transcendental<T>::SinOfReduced(T r) {
+  T s = r * r;
+  T p = T(1) / 6227020800;
+  p = p * s - T(1) / 39916800;
+  p = p * s + T(1) / 362880;
+  p = p * s - T(1) / 5040;
+  p = p * s + T(1) / 120;
+  p = p * s - T(1) / 6;
+  return r + r * s * p;
+}
+
+
+
+template <class T>
+T VUWLGP::Transcendental<T>::CosOfReduced(T r) {
+  T s = r * r;
+  T p = -T(1) / 87178291200;
+  p = p * s + T(1) / 479001600;
+  p = p * s - T(1) / 3628800;
+  p = p * s + T(1) / 40320;
+  p = p * s - T(1) / 720;
+  p = p * s + T(1) / 24;
+  p = p * s - T(1) / 2;
+  return 1 + s * p;
+}
+
+
+
+template <>
+inline double VUWLGP::Transcendental<double>::Pow2(int n) {
+  unsigned long long bits = static_cast<unsigned long long>(n + 1023) << 52;
+  double result;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+
+
+template <>
+inline float VUWLGP::Transcendental<float>::Pow2(int n) {
+  unsigned int bits = static_cast<unsigned int>(n + 127) << 23;
+  float result;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+
+
+template <>
+inline double VUWLGP::Transcendental<double>::Mantissa(double x, int& exponent) {
+  unsigned long long bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  exponent = static_cast<int>(bits >> 52) - 1023;
+  bits = (bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL;
+  double m;
+  std::memcpy(&m, &bits, sizeof(m));
+  return m;
+}
+
+
+
+template <>
+inline float VUWLGP::Transcendental<float>::Mantissa(float x, int& exponent) {
+  unsigned int bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  exponent = static_cast<int>(bits >> 23) - 127;
+  bits = (bits & 0x007fffffu) | 0x3f800000u;
+  float m;
+  std::memcpy(&m, &bits, sizeof(m));
+  return m;
+}
+
+
+
+// Adding 1.5 * 2^(digits - 1) leaves the rounded value in the mantissa's lowest bits:
+template <>
+inline double VUWLGP::Transcendental<double>::Round(double x, unsigned int& low) {
+  const double shift = 6755399441055744.0;
+  double shifted = x + shift;
+  unsigned long long bits;
+  std::memcpy(&bits, &shifted, sizeof(bits));
+  low = static_cast<unsigned int>(bits) & 3;
+  return shifted - shift;
+}
+
+
+
+template <>
+inline float VUWLGP::Transcendental<float>::Round(float x, unsigned int& low) {
+  const float shift = 12582912.0f;
+  float shifted = x + shift;
+  unsigned int bits;
+  std::memcpy(&bits, &shifted, sizeof(bits));
+  low = bits & 3;
+  return shifted - shift;
+}
+#endif
@@ -15,7 +15,8 @@ namespace VUWLGP {
   // sufficient.
   template <class T> class WeightedCollection {
   public:
-    // Uses default ctor, cctor, dtor
+    // Uses default cctor, dtor
+    WeightedCollection(): weightSum(0) { }
     
     // Adds elem with weight "weight" to this WeightedCollection.
     void AddElement(T elem, double weight = 1);
@@ -28,6 +29,7 @@ namespace VUWLGP {
 
     // Misc helper/inspection methods:
     unsigned int NumberOfElements() const { return elements.size(); }
+    T GetElement(unsigned int i) const { return elements[i].second; }
     double WeightSum() const { return weightSum; }
 
   private: